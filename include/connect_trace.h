@@ -0,0 +1,72 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <cstdint>
+
+namespace signalr
+{
+    /**
+     * Where the time of one start() or reconnect attempt went. Every phase is a point in time in milliseconds since the
+     * attempt began, -1 for a phase the attempt did not reach or skipped (e.g. negotiate with skip_negotiation()).
+     */
+    struct connect_trace
+    {
+        /** Whether the attempt was made by automatic reconnect. */
+        bool reconnect;
+        /** Whether the attempt got as far as the handshake response. */
+        bool succeeded;
+        /** Negotiate requests sent, including the ones that followed a redirect. */
+        uint32_t negotiate_requests;
+        /** The first negotiate request was issued. */
+        int32_t negotiate_sent_ms;
+        /** The HTTP connection of the first negotiate was up (DNS, TCP and TLS done). -1 if a kept-alive connection was reused. */
+        int32_t negotiate_connected_ms;
+        /** The response of the last negotiate request was parsed. */
+        int32_t negotiate_completed_ms;
+        /** The transport connect was started (the WebSocket upgrade or the event stream request). */
+        int32_t websocket_started_ms;
+        /** The transport was connected (DNS, TCP, TLS and the HTTP upgrade or the start of the event stream). */
+        int32_t websocket_connected_ms;
+        /** The handshake request was handed to the transport. */
+        int32_t handshake_sent_ms;
+        /** The handshake response arrived. */
+        int32_t handshake_acked_ms;
+        /** The first message after the handshake response arrived. */
+        int32_t first_message_ms;
+    };
+
+    /**
+     * Duration of one part of the connect, over all attempts that went through it.
+     */
+    struct connect_phase_stats
+    {
+        /** Attempts the duration was measured for. */
+        uint32_t samples;
+        int32_t min_ms;
+        int32_t max_ms;
+        /** Average in milliseconds, 0 without samples. */
+        int32_t avg_ms;
+    };
+
+    /**
+     * Aggregated connect_trace of every attempt since the connection was built.
+     */
+    struct connect_trace_stats
+    {
+        uint32_t attempts;
+        uint32_t succeeded;
+        /** From the first negotiate request to the last parsed response, redirects included. */
+        connect_phase_stats negotiate;
+        /** From starting the transport connect to the connected transport. */
+        connect_phase_stats websocket;
+        /** From sending the handshake request to its response. */
+        connect_phase_stats handshake;
+        /** From the start of the attempt to the handshake response, successful attempts only. */
+        connect_phase_stats total;
+        /** From the handshake response to the first message after it. */
+        connect_phase_stats first_message;
+    };
+}
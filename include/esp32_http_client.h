@@ -7,6 +7,9 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <chrono>
 
 namespace signalr {
 
@@ -17,6 +20,18 @@ struct signalr_client_config;
  * ESP32 HTTP client adapter
  * Wraps ESP-IDF esp_http_client to provide SignalR-compatible interface
  * Implements the http_client abstract interface
+ *
+ * Connections of http_request::keep_alive requests are kept alive after a 2xx response that was
+ * read in full and shared by all instances, one idle connection per origin, so negotiate redirects
+ * and reconnect negotiations to the same server skip the TCP and TLS handshakes. A connection that
+ * fails is closed instead of being reused.
+ * Idle connections are closed after CONFIG_SIGNALR_HTTP_KEEP_ALIVE_IDLE_MS by a timer, whether
+ * or not another request comes.
+ * With CONFIG_SIGNALR_TLS_SESSION_KEEP_MS https handles outlive their connection and resume the
+ * TLS session of the last one, so a later connection to the server does an abbreviated handshake.
+ *
+ * With signalr_client_config::set_dns_cache() requests connect to the cached address of the
+ * server, keeping the host name for the Host header and the TLS server name.
  */
 class esp32_http_client : public http_client {
 public:
@@ -36,9 +51,49 @@ private:
                                   const std::string& content,
                                   const std::map<std::string, std::string>& headers,
                                   std::chrono::seconds timeout,
+                                  const std::function<void(const char*, size_t)>& body_handler,
+                                  bool keep_alive,
                                   cancellation_token token);
 
+    struct idle_client {
+        std::string origin;
+        esp_http_client_handle_t client;
+        // headers set on the handle by its last request, removed before the next one
+        std::vector<std::string> header_names;
+        std::chrono::steady_clock::time_point released;
+        // connection closed after the keep-alive time, the handle is kept for its TLS session
+        bool closed;
+        // host name of a handle made by address, esp-tls keeps the pointer for every handshake of the handle
+        std::unique_ptr<std::string> common_name;
+    };
+
+    static std::string origin_of(const std::string& url);
+    static int retention_ms(const std::string& origin);
+    static esp_http_client_handle_t take_idle_client(const std::string& origin, std::vector<std::string>& header_names,
+                                                     std::unique_ptr<std::string>& common_name);
+    static void release_client(const std::string& origin, esp_http_client_handle_t client, std::vector<std::string> header_names,
+                               std::unique_ptr<std::string> common_name);
+
+    // with s_idle_lock held: moves the handles past their retention to `expired` and closes the connections idle past
+    // the keep-alive time. Returns when the next entry is due, zero once the pool is empty
+    static std::chrono::milliseconds expire_idle_clients(std::vector<idle_client>& expired);
+    // with s_idle_lock held: runs sweep_idle_clients on the reconnect worker after `due`
+    static void schedule_sweep(std::chrono::milliseconds due);
+    static void sweep_idle_clients(void*);
+    static void sweep_dropped(void*);
+
+    static std::mutex s_idle_lock;
+    static std::vector<idle_client> s_idle_clients;
+    // a sweep is pending on a timer, guarded by s_idle_lock
+    static bool s_sweep_scheduled;
+
     std::string m_response_buffer;
+    // body_handler of the request in flight, the body goes to m_response_buffer when it is empty
+    std::function<void(const char*, size_t)> m_body_handler;
+    size_t m_body_received = 0;
+    // the request in flight is a negotiate, whose connection goes to the connect trace
+    bool m_negotiate = false;
+    std::chrono::milliseconds m_dns_cache_ttl;
 };
 
 } // namespace signalr
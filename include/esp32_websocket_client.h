@@ -8,6 +8,7 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include <chrono>
 #include <string>
 #include <functional>
 #include <memory>
@@ -31,6 +32,9 @@ struct signalr_client_config;
  * - This adapter bridges the two models using a message queue
  * - Callbacks are executed on a dedicated task to avoid stack overflow
  *   in the WebSocket event handler
+ * - With signalr_client_config::set_dns_cache(ttl, true) it connects to the
+ *   cached address of the server; the upgrade request then carries the
+ *   address as Host header, the TLS server name stays the host name
  */
 class esp32_websocket_client : public websocket_client {
 public:
@@ -82,6 +86,10 @@ private:
     bool m_is_connected;
     bool m_is_stopping;
     std::string m_receive_buffer;
+
+    std::chrono::milliseconds m_dns_cache_ttl;
+    // server name of a connect by address, esp-tls keeps the pointer until m_client is destroyed
+    std::string m_cert_common_name;
     
     static constexpr int CONNECTED_BIT = BIT0;
     static constexpr int DISCONNECTED_BIT = BIT1;
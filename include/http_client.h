@@ -16,20 +16,29 @@ namespace signalr
     enum class http_method
     {
         GET,
-        POST
+        POST,
+        DELETE
     };
 
     class http_request
     {
     public:
         http_request()
-            : method(http_method::GET), timeout(std::chrono::seconds(120))
+            : method(http_method::GET), timeout(std::chrono::seconds(120)), keep_alive(false), negotiate(false)
         { }
 
         http_method method;
         std::map<std::string, std::string> headers;
         std::string content;
         std::chrono::seconds timeout;
+        // when set, clients that support it hand the response body to this callback in the chunks it arrives in and
+        // leave http_response::content empty. Clients that don't fill content as usual. Must not throw
+        std::function<void(const char* data, size_t length)> body_handler;
+        // clients that pool connections may keep this one open for the next request to the same server once a 2xx
+        // response was read in full. For short exchanges such as negotiate, not for polls or streamed responses
+        bool keep_alive;
+        // the request is a negotiate, clients that record connect traces mark when its connection is up
+        bool negotiate;
     };
 
     class http_response
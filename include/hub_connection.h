@@ -12,6 +12,11 @@
 #include "log_writer.h"
 #include "signalr_client_config.h"
 #include "signalr_value.h"
+#include "raw_arguments.h"
+#include "stream_handle.h"
+#include "stream_writer.h"
+#include "prepared_invocation.h"
+#include "connect_trace.h"
 
 namespace signalr
 {
@@ -25,6 +30,8 @@ namespace signalr
     {
     public:
         typedef std::function<void __cdecl (const std::vector<signalr::value>&)> method_invoked_handler;
+        // receives the registered target name and the still-serialized arguments, see raw_arguments
+        typedef std::function<void __cdecl (const std::string&, const signalr::raw_arguments&)> raw_method_invoked_handler;
 
         SIGNALRCLIENT_API ~hub_connection();
 
@@ -41,6 +48,15 @@ namespace signalr
 
         SIGNALRCLIENT_API connection_state __cdecl get_connection_state() const;
         SIGNALRCLIENT_API std::string __cdecl get_connection_id() const;
+        // number of invocations completed with a timeout error since the connection was built
+        SIGNALRCLIENT_API size_t __cdecl get_timed_out_invocation_count() const;
+        // messages held while disconnected, see signalr_client_config::set_offline_buffer
+        SIGNALRCLIENT_API offline_buffer_stats __cdecl get_offline_buffer_stats() const;
+        // phase timings of the most recent start() or reconnect attempt, and aggregated over all attempts
+        SIGNALRCLIENT_API connect_trace __cdecl get_last_connect_trace() const;
+        SIGNALRCLIENT_API connect_trace_stats __cdecl get_connect_trace_stats() const;
+        // report link state (e.g. from WIFI_EVENT/IP_EVENT handlers); reconnect attempts wait while it is false
+        SIGNALRCLIENT_API void __cdecl set_network_available(bool available);
 
         SIGNALRCLIENT_API void __cdecl set_disconnected(const std::function<void __cdecl(std::exception_ptr)>& disconnected_callback);
 
@@ -48,10 +64,47 @@ namespace signalr
 
         SIGNALRCLIENT_API void __cdecl on(const std::string& event_name, const method_invoked_handler& handler);
 
+        // Registers a handler that skips argument decoding. Use it for high-rate targets that only need part of the
+        // payload or forward it as-is. A target can have either an `on` or an `on_raw` handler, not both.
+        SIGNALRCLIENT_API void __cdecl on_raw(const std::string& event_name, const raw_method_invoked_handler& handler);
+
         SIGNALRCLIENT_API void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments = std::vector<signalr::value>(), std::function<void(const signalr::value&, std::exception_ptr)> callback = [](const signalr::value&, std::exception_ptr) {}) noexcept;
 
+        // Same as invoke but fails with a timeout error if the result has not arrived after `timeout` instead of using
+        // signalr_client_config::get_invocation_timeout(). A timeout of 0 waits until the connection closes.
+        SIGNALRCLIENT_API void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout) noexcept;
+
         SIGNALRCLIENT_API void send(const std::string& method_name, const std::vector<signalr::value>& arguments = std::vector<signalr::value>(), std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
 
+        // Invokes a streaming hub method (one returning IAsyncEnumerable<T> or ChannelReader<T>). `on_item` is called for every
+        // item in order and `on_complete` exactly once afterwards, both on the scheduler. Items that arrive faster than
+        // `on_item` consumes them are buffered up to CONFIG_SIGNALR_STREAM_BUFFER_SIZE, beyond that the stream is canceled
+        // and completed with an error.
+        SIGNALRCLIENT_API stream_handle stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept;
+
+        // Sends a hub method whose last parameter is a client-to-server stream (ChannelReader<T> or IAsyncEnumerable<T>).
+        // Items written to the returned writer are delivered to that parameter; `callback` is invoked once the invocation was sent.
+        SIGNALRCLIENT_API stream_writer send_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        // Same as send_with_stream but `callback` receives the result of the hub method. The writer is closed when the method returns.
+        SIGNALRCLIENT_API stream_writer invoke_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&, std::exception_ptr)> callback = [](const signalr::value&, std::exception_ptr) {}) noexcept;
+
+        // Prepares a hub method that is called often. The returned handle serializes the message envelope once and only
+        // the arguments on every send or invoke.
+        SIGNALRCLIENT_API prepared_invocation __cdecl prepare(const std::string& method_name);
+
+        // Starts a batch. Messages sent by send, invoke, stream and stream writers until the matching uncork() are appended
+        // to one buffer and sent as a single frame, each still completing its own callback when the frame was sent.
+        // Calls nest, only the outermost uncork() flushes. A batch that would grow past CONFIG_SIGNALR_MAX_MESSAGE_SIZE is
+        // flushed early.
+        SIGNALRCLIENT_API void __cdecl cork();
+        // Ends a batch started by cork(). `callback` is invoked once the frame carrying the batch was sent.
+        SIGNALRCLIENT_API void __cdecl uncork(std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
     private:
         friend class hub_connection_builder;
 
@@ -39,6 +39,8 @@ namespace signalr
         // Auto-reconnect configuration (similar to C# and JS clients)
         SIGNALRCLIENT_API hub_connection_builder& with_automatic_reconnect();
         SIGNALRCLIENT_API hub_connection_builder& with_automatic_reconnect(const std::vector<std::chrono::milliseconds>& reconnect_delays);
+        // e.g. std::make_shared<decorrelated_jitter_reconnect_policy>(std::chrono::seconds(1), std::chrono::seconds(60))
+        SIGNALRCLIENT_API hub_connection_builder& with_automatic_reconnect(std::shared_ptr<reconnect_policy> policy);
 
 #ifdef USE_MSGPACK
         SIGNALRCLIENT_API hub_connection_builder& with_messagepack_hub_protocol();
@@ -59,5 +61,6 @@ namespace signalr
         // Auto-reconnect settings
         bool m_auto_reconnect_enabled = false;
         std::vector<std::chrono::milliseconds> m_reconnect_delays;
+        std::shared_ptr<reconnect_policy> m_reconnect_policy;
     };
 }
@@ -142,6 +142,8 @@ public:
     json_reader() = default;
     
     bool parse(const std::string& document, json_value& root, bool collect_comments = true);
+    // Parse a slice of a larger buffer without copying it into a std::string first
+    bool parse(const char* document, size_t length, json_value& root);
     std::string get_formatted_error_messages() const;
 
 private:
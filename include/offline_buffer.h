@@ -0,0 +1,37 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace signalr
+{
+    /**
+     * What happens to a message sent while the connection is down and the offline buffer is full.
+     */
+    enum class offline_overflow_policy
+    {
+        /** Fail the oldest buffered messages until the new one fits. */
+        drop_oldest,
+        /** Fail the new message and keep the buffered ones. */
+        reject_new
+    };
+
+    /**
+     * Snapshot of the offline outbound buffer configured with signalr_client_config::set_offline_buffer.
+     */
+    struct offline_buffer_stats
+    {
+        /** Messages waiting for the connection to come back. */
+        size_t buffered_messages;
+        /** Serialized size of the waiting messages. */
+        size_t buffered_bytes;
+        /** Messages failed because the buffer was full, cumulative. */
+        uint32_t dropped_messages;
+        /** Buffered messages handed to the transport after a reconnect, cumulative. */
+        uint32_t flushed_messages;
+    };
+}
@@ -0,0 +1,51 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include "signalr_value.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace signalr
+{
+    class hub_connection_impl;
+    class invocation_template;
+
+    /**
+     * A hub method prepared with hub_connection::prepare for repeated calls. The parts of the message that do not
+     * depend on the arguments are serialized once, each call only serializes its arguments into a reused buffer.
+     * Copies refer to the same method. The handle does not keep the connection alive.
+     */
+    class prepared_invocation
+    {
+    public:
+        /**
+         * Create a handle that does not refer to a hub method.
+         */
+        SIGNALRCLIENT_API prepared_invocation() noexcept;
+
+        /**
+         * Same as hub_connection::send for the prepared method.
+         */
+        SIGNALRCLIENT_API void send(const std::vector<signalr::value>& arguments = std::vector<signalr::value>(),
+            std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        /**
+         * Same as hub_connection::invoke for the prepared method, using the default invocation timeout.
+         */
+        SIGNALRCLIENT_API void invoke(const std::vector<signalr::value>& arguments = std::vector<signalr::value>(),
+            std::function<void(const signalr::value&, std::exception_ptr)> callback = [](const signalr::value&, std::exception_ptr) {}) noexcept;
+
+    private:
+        friend class hub_connection_impl;
+
+        prepared_invocation(const std::weak_ptr<hub_connection_impl>& connection, const std::shared_ptr<invocation_template>& invocation) noexcept;
+
+        std::weak_ptr<hub_connection_impl> m_connection;
+        std::shared_ptr<invocation_template> m_template;
+    };
+}
@@ -0,0 +1,84 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include "signalr_value.h"
+#include "signalr_compact_value.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace signalr
+{
+    /**
+     * A non-owning view over the still-serialized argument array of a received invocation.
+     * Arguments are only decoded when asked for, so a handler that reads one field or forwards the payload
+     * does not pay for converting the whole array into signalr::value objects.
+     *
+     * The view points into the receive buffer and is only valid for the duration of the handler call.
+     * Copy what you need (e.g. with to_string() or decode()) before returning from the handler.
+     */
+    class raw_arguments
+    {
+    public:
+        /**
+         * Create an empty view.
+         */
+        SIGNALRCLIENT_API raw_arguments() noexcept;
+
+        /**
+         * Create a view over a serialized argument array, e.g. "[1,\"a\"]". The buffer is not copied.
+         */
+        SIGNALRCLIENT_API raw_arguments(const char* data, size_t length) noexcept;
+
+        /**
+         * The serialized argument array, including the enclosing brackets. Not null terminated.
+         */
+        SIGNALRCLIENT_API const char* data() const noexcept;
+
+        /**
+         * The length in bytes of the serialized argument array.
+         */
+        SIGNALRCLIENT_API size_t length() const noexcept;
+
+        /**
+         * The number of arguments. The array is scanned on every call.
+         */
+        SIGNALRCLIENT_API size_t size() const;
+
+        /**
+         * Locate the serialized form of the argument at the given index without decoding it.
+         * Returns false if the index is out of range.
+         */
+        SIGNALRCLIENT_API bool raw_at(size_t index, const char*& data, size_t& length) const;
+
+        /**
+         * Decode the argument at the given index. Throws signalr_exception if the index is out of range
+         * or the argument is not valid JSON.
+         */
+        SIGNALRCLIENT_API signalr::value decode(size_t index) const;
+
+        /**
+         * Decode the argument at the given index into a single-allocation compact_value.
+         * Throws signalr_exception if the index is out of range or the argument is not valid JSON.
+         */
+        SIGNALRCLIENT_API signalr::compact_value decode_compact(size_t index) const;
+
+        /**
+         * Decode all arguments, equivalent to what a handler registered with hub_connection::on receives.
+         */
+        SIGNALRCLIENT_API std::vector<signalr::value> decode_all() const;
+
+        /**
+         * Copy the serialized argument array into a string that outlives the handler call.
+         */
+        SIGNALRCLIENT_API std::string to_string() const;
+
+    private:
+        const char* m_data;
+        size_t m_length;
+    };
+}
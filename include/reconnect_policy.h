@@ -0,0 +1,81 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include <chrono>
+#include <cstdint>
+
+namespace signalr
+{
+    /**
+     * What a reconnect_policy is told when asked for the delay before the next attempt.
+     */
+    struct reconnect_context
+    {
+        /** Attempts made since the connection was lost, 0 before the first one. */
+        int previous_attempts;
+        /** Delay the policy returned for the previous attempt, 0 before the first one. */
+        std::chrono::milliseconds previous_delay;
+    };
+
+    /**
+     * Decides how long to wait before each automatic reconnect attempt, in place of the fixed list set with
+     * signalr_client_config::set_reconnect_delays(). Called on the reconnect worker, one attempt at a time.
+     */
+    class reconnect_policy
+    {
+    public:
+        virtual ~reconnect_policy() {}
+
+        /**
+         * The delay before the next attempt. Negative values are treated as 0.
+         */
+        virtual std::chrono::milliseconds next_delay(const reconnect_context& context) = 0;
+    };
+
+    /**
+     * Doubles the delay on every attempt, starting at `base` and capped at `max`. With `jitter` the delay is drawn
+     * uniformly between 0 and that value ("full jitter") so devices that lost the same access point spread out.
+     */
+    class exponential_reconnect_policy : public reconnect_policy
+    {
+    public:
+        /**
+         * A non-zero `seed` makes the jitter reproducible, 0 uses the hardware random number generator.
+         */
+        SIGNALRCLIENT_API exponential_reconnect_policy(std::chrono::milliseconds base, std::chrono::milliseconds max,
+            bool jitter = true, uint32_t seed = 0);
+
+        SIGNALRCLIENT_API std::chrono::milliseconds next_delay(const reconnect_context& context) override;
+
+    private:
+        std::chrono::milliseconds m_base;
+        std::chrono::milliseconds m_max;
+        bool m_jitter;
+        uint32_t m_random_state;
+    };
+
+    /**
+     * "Decorrelated jitter": every delay is drawn uniformly between `base` and three times the previous delay, capped
+     * at `max`. Grows about as fast as exponential backoff but the attempts of different devices do not line up.
+     */
+    class decorrelated_jitter_reconnect_policy : public reconnect_policy
+    {
+    public:
+        /**
+         * A non-zero `seed` makes the delays reproducible, 0 uses the hardware random number generator.
+         */
+        SIGNALRCLIENT_API decorrelated_jitter_reconnect_policy(std::chrono::milliseconds base, std::chrono::milliseconds max,
+            uint32_t seed = 0);
+
+        SIGNALRCLIENT_API std::chrono::milliseconds next_delay(const reconnect_context& context) override;
+
+    private:
+        std::chrono::milliseconds m_base;
+        std::chrono::milliseconds m_max;
+        uint32_t m_random_state;
+    };
+}
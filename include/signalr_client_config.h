@@ -17,6 +17,8 @@
 #include <string>
 #include <vector>
 #include "scheduler.h"
+#include "offline_buffer.h"
+#include "reconnect_policy.h"
 #include <memory>
 
 namespace signalr
@@ -55,10 +57,46 @@ namespace signalr
         SIGNALRCLIENT_API std::chrono::milliseconds get_server_timeout() const noexcept;
         SIGNALRCLIENT_API void set_keepalive_interval(std::chrono::milliseconds);
         SIGNALRCLIENT_API std::chrono::milliseconds get_keepalive_interval() const noexcept;
+        // number of client-to-server stream messages that may be queued or in flight per stream before
+        // stream_writer::write() starts rejecting items
+        SIGNALRCLIENT_API void set_stream_upload_window(size_t window);
+        SIGNALRCLIENT_API size_t get_stream_upload_window() const noexcept;
+        // time an invoke() waits for its completion before it fails with a timeout error, 0 waits until the connection closes
+        SIGNALRCLIENT_API void set_invocation_timeout(std::chrono::milliseconds timeout);
+        SIGNALRCLIENT_API std::chrono::milliseconds get_invocation_timeout() const noexcept;
+        // send() and invoke() messages made while the connection is not connected are kept, up to `max_messages` and
+        // `max_bytes`, and sent in order after the next handshake. 0 messages disables the buffer
+        SIGNALRCLIENT_API void set_offline_buffer(size_t max_messages, size_t max_bytes, offline_overflow_policy policy = offline_overflow_policy::drop_oldest);
+        SIGNALRCLIENT_API size_t get_offline_buffer_max_messages() const noexcept;
+        SIGNALRCLIENT_API size_t get_offline_buffer_max_bytes() const noexcept;
+        SIGNALRCLIENT_API offline_overflow_policy get_offline_buffer_policy() const noexcept;
+        // ask the server for stateful reconnect: after a transport drop the connection is resumed with the same
+        // connection token and unacknowledged messages are replayed by both sides instead of starting over
+        SIGNALRCLIENT_API void enable_stateful_reconnect(bool enable);
+        SIGNALRCLIENT_API bool is_stateful_reconnect_enabled() const noexcept;
+        // bytes of sent but unacknowledged messages kept for replay, a resume is only attempted if nothing was evicted
+        SIGNALRCLIENT_API void set_stateful_reconnect_buffer_size(size_t max_bytes);
+        SIGNALRCLIENT_API size_t get_stateful_reconnect_buffer_size() const noexcept;
+        // remember where negotiate ended up (redirect url, access token, transports) for `ttl` so the next start skips
+        // the redirect hops. With `connect_directly` it also skips the final negotiate and opens the WebSocket without
+        // a connection token, only for servers that accept that (see skip_negotiation()). 0 disables the cache
+        SIGNALRCLIENT_API void set_negotiate_cache(std::chrono::milliseconds ttl, bool connect_directly = false);
+        SIGNALRCLIENT_API std::chrono::milliseconds get_negotiate_cache_ttl() const noexcept;
+        SIGNALRCLIENT_API bool is_negotiate_cache_direct_connect() const noexcept;
+        // keep resolved server addresses for at least `ttl` and connect to them by address, with the host name as Host
+        // header and TLS server name; stale addresses are refreshed in the background. The WebSocket upgrade request
+        // can only carry the address as Host header, so it connects by address only with `websocket_by_address`, for
+        // servers that do not route by host name. 0 disables the cache
+        SIGNALRCLIENT_API void set_dns_cache(std::chrono::milliseconds ttl, bool websocket_by_address = false);
+        SIGNALRCLIENT_API std::chrono::milliseconds get_dns_cache_ttl() const noexcept;
+        SIGNALRCLIENT_API bool is_dns_cache_websocket_by_address() const noexcept;
 
         // Auto-reconnect settings
         SIGNALRCLIENT_API void set_reconnect_delays(const std::vector<std::chrono::milliseconds>& delays);
         SIGNALRCLIENT_API const std::vector<std::chrono::milliseconds>& get_reconnect_delays() const noexcept;
+        // when set, the policy decides the delay before each attempt and the delays list is not used
+        SIGNALRCLIENT_API void set_reconnect_policy(std::shared_ptr<reconnect_policy> policy);
+        SIGNALRCLIENT_API std::shared_ptr<reconnect_policy> get_reconnect_policy() const noexcept;
         SIGNALRCLIENT_API void set_max_reconnect_attempts(int max_attempts);
         SIGNALRCLIENT_API int get_max_reconnect_attempts() const noexcept;
         SIGNALRCLIENT_API void enable_auto_reconnect(bool enable);
@@ -76,10 +114,22 @@ namespace signalr
         std::chrono::milliseconds m_handshake_timeout;
         std::chrono::milliseconds m_server_timeout;
         std::chrono::milliseconds m_keepalive_interval;
+        size_t m_stream_upload_window;
+        std::chrono::milliseconds m_invocation_timeout;
+        size_t m_offline_buffer_max_messages;
+        size_t m_offline_buffer_max_bytes;
+        offline_overflow_policy m_offline_buffer_policy;
+        bool m_stateful_reconnect_enabled;
+        size_t m_stateful_reconnect_buffer_size;
+        std::chrono::milliseconds m_negotiate_cache_ttl;
+        bool m_negotiate_cache_direct_connect;
+        std::chrono::milliseconds m_dns_cache_ttl;
+        bool m_dns_cache_websocket_by_address;
 
         // Auto-reconnect settings
         bool m_auto_reconnect_enabled;
         std::vector<std::chrono::milliseconds> m_reconnect_delays;
+        std::shared_ptr<reconnect_policy> m_reconnect_policy;
         int m_max_reconnect_attempts;
     };
 }
@@ -0,0 +1,156 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include "signalr_value.h"
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace signalr
+{
+    struct compact_node;
+
+    /**
+     * A read-only alternative to signalr::value for received payloads. The whole tree lives in a single
+     * allocation: maps are stored as key-sorted flat arrays, arrays as contiguous node blocks and strings of up to
+     * 8 bytes inline in their node. Child accessors return lightweight handles that share the tree's storage.
+     *
+     * Use it for large or high-rate payloads where the per-node allocations of signalr::value add up; call
+     * to_value() when an API needs a signalr::value.
+     */
+    class compact_value
+    {
+    public:
+        /**
+         * Create an object representing a value_type::null value.
+         */
+        SIGNALRCLIENT_API compact_value() noexcept;
+
+        /**
+         * Parse JSON text into a compact tree. Throws signalr_exception if the text is not valid JSON.
+         */
+        SIGNALRCLIENT_API static compact_value parse(const char* json, size_t length);
+
+        /**
+         * Parse JSON text into a compact tree. Throws signalr_exception if the text is not valid JSON.
+         */
+        SIGNALRCLIENT_API static compact_value parse(const std::string& json);
+
+        /**
+         * True if the object stored is a Key-Value pair.
+         */
+        SIGNALRCLIENT_API bool is_map() const;
+
+        /**
+         * True if the object stored is double.
+         */
+        SIGNALRCLIENT_API bool is_double() const;
+
+        /**
+         * True if the object stored is a string.
+         */
+        SIGNALRCLIENT_API bool is_string() const;
+
+        /**
+         * True if the object stored is empty.
+         */
+        SIGNALRCLIENT_API bool is_null() const;
+
+        /**
+         * True if the object stored is an array of compact_value's.
+         */
+        SIGNALRCLIENT_API bool is_array() const;
+
+        /**
+         * True if the object stored is a bool.
+         */
+        SIGNALRCLIENT_API bool is_bool() const;
+
+        /**
+         * Returns the stored object as a double. This will throw if the underlying object is not a value_type::float64.
+         */
+        SIGNALRCLIENT_API double as_double() const;
+
+        /**
+         * Returns the stored object as a bool. This will throw if the underlying object is not a value_type::boolean.
+         */
+        SIGNALRCLIENT_API bool as_bool() const;
+
+        /**
+         * Returns a copy of the stored string. This will throw if the underlying object is not a value_type::string.
+         */
+        SIGNALRCLIENT_API std::string as_string() const;
+
+        /**
+         * Returns the stored string without copying it. Not null terminated, use string_length().
+         * This will throw if the underlying object is not a value_type::string.
+         */
+        SIGNALRCLIENT_API const char* string_data() const;
+
+        /**
+         * Returns the length in bytes of the stored string. This will throw if the underlying object is not a value_type::string.
+         */
+        SIGNALRCLIENT_API size_t string_length() const;
+
+        /**
+         * Returns the number of elements of an array or entries of a map. This will throw for any other type.
+         */
+        SIGNALRCLIENT_API size_t size() const;
+
+        /**
+         * Returns the array element at the given index. This will throw if the underlying object is not a value_type::array
+         * or the index is out of range.
+         */
+        SIGNALRCLIENT_API compact_value operator[](size_t index) const;
+
+        /**
+         * Returns the map entry for the given key, or a value_type::null value if the key is not present.
+         * Keys are looked up with a binary search. This will throw if the underlying object is not a value_type::map.
+         */
+        SIGNALRCLIENT_API compact_value operator[](const std::string& key) const;
+
+        /**
+         * Returns whether the map contains the given key. This will throw if the underlying object is not a value_type::map.
+         */
+        SIGNALRCLIENT_API bool contains(const std::string& key) const;
+
+        /**
+         * Returns the key of the map entry at the given index, entries are sorted by key.
+         * This will throw if the underlying object is not a value_type::map or the index is out of range.
+         */
+        SIGNALRCLIENT_API std::string key_at(size_t index) const;
+
+        /**
+         * Returns the value of the map entry at the given index, entries are sorted by key.
+         * This will throw if the underlying object is not a value_type::map or the index is out of range.
+         */
+        SIGNALRCLIENT_API compact_value value_at(size_t index) const;
+
+        /**
+         * Returns the value_type that represents the stored object.
+         */
+        SIGNALRCLIENT_API value_type type() const;
+
+        /**
+         * Converts the tree into a signalr::value.
+         */
+        SIGNALRCLIENT_API signalr::value to_value() const;
+
+        /**
+         * Returns the size in bytes of the single allocation backing the whole tree.
+         */
+        SIGNALRCLIENT_API size_t storage_size() const;
+
+    private:
+        compact_value(const std::shared_ptr<const compact_node>& storage, const compact_node* node) noexcept;
+
+        const compact_node* find(const char* key, size_t length) const;
+
+        std::shared_ptr<const compact_node> m_storage;
+        const compact_node* m_node;
+    };
+}
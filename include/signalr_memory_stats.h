@@ -0,0 +1,32 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace signalr
+{
+    /**
+     * Allocation counters of the cJSON hooks installed by the client (CONFIG_SIGNALR_JSON_PSRAM_HOOKS), which
+     * serve cJSON allocations from PSRAM when it has room. All zero when the hooks are disabled.
+     * Cumulative counters start when the first connection is created and wrap around.
+     */
+    struct json_memory_stats
+    {
+        /** Requests that landed in PSRAM. */
+        uint32_t psram_allocations;
+        /** Requests that landed in internal RAM, PSRAM being full. */
+        uint32_t internal_allocations;
+        /** Bytes requested by cJSON that were served from PSRAM instead of internal RAM. */
+        uint32_t internal_bytes_saved;
+    };
+
+    /**
+     * Snapshot of the cJSON allocation counters. Safe to call from any task.
+     */
+    SIGNALRCLIENT_API json_memory_stats get_json_memory_stats() noexcept;
+}
@@ -0,0 +1,45 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include <memory>
+
+namespace signalr
+{
+    class stream_item_buffer;
+    class hub_connection_impl;
+
+    /**
+     * Handle to a server-to-client stream started with hub_connection::stream.
+     * Copies refer to the same stream. Dropping the handle does not cancel the stream.
+     */
+    class stream_handle
+    {
+    public:
+        /**
+         * Create a handle that does not refer to a stream.
+         */
+        SIGNALRCLIENT_API stream_handle() noexcept;
+
+        /**
+         * Cancel the stream. The server is sent a CancelInvocation message, items that were not delivered yet are
+         * dropped and on_complete receives a cancellation error. Does nothing if the stream has already completed.
+         */
+        SIGNALRCLIENT_API void cancel() noexcept;
+
+        /**
+         * Whether the stream is still running, i.e. it has not completed, failed or been canceled.
+         */
+        SIGNALRCLIENT_API bool is_active() const noexcept;
+
+    private:
+        friend class hub_connection_impl;
+
+        explicit stream_handle(const std::shared_ptr<stream_item_buffer>& buffer) noexcept;
+
+        std::weak_ptr<stream_item_buffer> m_buffer;
+    };
+}
@@ -0,0 +1,73 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "_exports.h"
+#include "signalr_value.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace signalr
+{
+    class client_stream;
+    class hub_connection_impl;
+
+    /**
+     * Writer for a client-to-server stream started with hub_connection::send_with_stream or invoke_with_stream.
+     * Copies refer to the same stream. Items are sent in order; at most signalr_client_config::get_stream_upload_window()
+     * messages are queued or in flight at a time, which lets a slow link push back on the producer.
+     */
+    class stream_writer
+    {
+    public:
+        /**
+         * Create a writer that does not refer to a stream.
+         */
+        SIGNALRCLIENT_API stream_writer() noexcept;
+
+        /**
+         * Queue an item. Returns false, without invoking the callback, when the window is full or the stream is closed.
+         * Otherwise the callback is invoked once the item was handed to the transport or failed to send.
+         */
+        SIGNALRCLIENT_API bool write(const signalr::value& item, std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        /**
+         * Complete the stream after the queued items have been sent. No further writes are accepted.
+         * Returns false if the stream was already completed or closed.
+         */
+        SIGNALRCLIENT_API bool complete(std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        /**
+         * Complete the stream with an error, the server side of the stream observes it as a failure.
+         * Returns false if the stream was already completed or closed.
+         */
+        SIGNALRCLIENT_API bool cancel(const std::string& error = "Stream canceled by client.", std::function<void(std::exception_ptr)> callback = [](std::exception_ptr) {}) noexcept;
+
+        /**
+         * Set a handler that is called when a full window gets room again, so a producer that was rejected by write()
+         * knows when to retry. Called from the task that completed the send.
+         */
+        SIGNALRCLIENT_API void set_ready_handler(const std::function<void()>& handler) noexcept;
+
+        /**
+         * Number of messages of this stream that are queued or not yet acknowledged by the transport.
+         */
+        SIGNALRCLIENT_API size_t in_flight() const noexcept;
+
+        /**
+         * Whether write() can still accept items. A stream closes when it is completed, when the connection is lost
+         * or when the hub method it was passed to returns.
+         */
+        SIGNALRCLIENT_API bool is_open() const noexcept;
+
+    private:
+        friend class hub_connection_impl;
+
+        explicit stream_writer(const std::shared_ptr<client_stream>& stream) noexcept;
+
+        std::shared_ptr<client_stream> m_stream;
+    };
+}
@@ -2,7 +2,12 @@
 #include "signalr_client_config.h"
 #include "esp_log.h"
 #include "cancellation_token_source.h"
+#include "connect_trace_recorder.h"
+#include "dns_cache.h"
+#include "reconnect_worker.h"
+#include <algorithm>
 #include <atomic>
+#include <cctype>
 #include <cstring>
 #include <stdexcept>
 
@@ -10,8 +15,38 @@ static const char* TAG = "ESP32_HTTP_CLIENT";
 
 namespace signalr {
 
-esp32_http_client::esp32_http_client(const signalr_client_config& config) {
-    // Configuration can be used for future enhancements
+#ifdef CONFIG_SIGNALR_HTTP_KEEP_ALIVE_IDLE_MS
+constexpr int KEEP_ALIVE_IDLE_MS = CONFIG_SIGNALR_HTTP_KEEP_ALIVE_IDLE_MS;
+#else
+constexpr int KEEP_ALIVE_IDLE_MS = 30000;
+#endif
+
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS) && defined(CONFIG_SIGNALR_TLS_SESSION_KEEP_MS)
+constexpr int TLS_SESSION_KEEP_MS = CONFIG_SIGNALR_TLS_SESSION_KEEP_MS;
+#else
+constexpr int TLS_SESSION_KEEP_MS = 0;
+#endif
+
+// one per origin in practice: the hub itself and at most one negotiate redirect target
+constexpr size_t MAX_IDLE_CLIENTS = 2;
+
+static esp_http_client_method_t to_esp_method(http_method method) {
+    switch (method) {
+        case http_method::GET:
+            return HTTP_METHOD_GET;
+        case http_method::DELETE:
+            return HTTP_METHOD_DELETE;
+        default:
+            return HTTP_METHOD_POST;
+    }
+}
+
+std::mutex esp32_http_client::s_idle_lock;
+std::vector<esp32_http_client::idle_client> esp32_http_client::s_idle_clients;
+bool esp32_http_client::s_sweep_scheduled = false;
+
+esp32_http_client::esp32_http_client(const signalr_client_config& config)
+    : m_dns_cache_ttl(config.get_dns_cache_ttl()) {
 }
 
 esp32_http_client::~esp32_http_client() {
@@ -20,16 +55,21 @@ esp32_http_client::~esp32_http_client() {
 void esp32_http_client::send(const std::string& url, http_request& request,
                             std::function<void(const http_response&, std::exception_ptr)> callback,
                             cancellation_token token) {
-    ESP_LOGI(TAG, "HTTP %s request to: %s", 
-            request.method == http_method::GET ? "GET" : "POST", url.c_str());
-    
+    // every poll and send comes through here, and the query carries the connection token
+    const size_t query_start = std::min(url.find('?'), url.size());
+    ESP_LOGD(TAG, "HTTP %s request to: %.*s",
+            request.method == http_method::GET ? "GET" : request.method == http_method::POST ? "POST" : "DELETE",
+            (int)query_start, url.c_str());
+
     try {
         if (token.is_canceled()) {
             throw canceled_exception();
         }
 
+        m_negotiate = request.negotiate;
         http_response response = perform_request(url, request.method, request.content, 
-                                                request.headers, request.timeout, token);
+                                                request.headers, request.timeout, request.body_handler,
+                                                request.keep_alive, token);
         callback(response, nullptr);
     } catch (const std::exception& e) {
         ESP_LOGE(TAG, "HTTP request failed: %s", e.what());
@@ -42,81 +82,321 @@ http_response esp32_http_client::perform_request(const std::string& url,
                                                  const std::string& content,
                                                  const std::map<std::string, std::string>& headers,
                                                  std::chrono::seconds timeout,
+                                                 const std::function<void(const char*, size_t)>& body_handler,
+                                                 bool keep_alive,
                                                  cancellation_token token) {
-    http_response response;
-    m_response_buffer.clear();
+    resolved_url target;
+    auto dns = dns_cache::resolve_url(url, m_dns_cache_ttl, target);
+    if (dns == dns_cache::status::failed) {
+        throw std::runtime_error("Failed to resolve " + target.host);
+    }
+    const bool by_address = dns == dns_cache::status::resolved;
+    const std::string& request_url = by_address ? target.url : url;
 
-    esp_http_client_config_t config = {};
-    config.url = url.c_str();
-    config.method = (method == http_method::GET) ? HTTP_METHOD_GET : HTTP_METHOD_POST;
-    config.timeout_ms = static_cast<int>(timeout.count() * 1000);
-    config.event_handler = http_event_handler;
-    config.user_data = &m_response_buffer;
-    config.buffer_size = 2048;
-    config.buffer_size_tx = 2048;
+    // a connection made to an address only serves the host name it was made for
+    const std::string origin = by_address ? origin_of(url) + "@" + target.address : origin_of(url);
+    m_body_handler = body_handler;
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (!client) {
-        throw std::runtime_error("Failed to initialize HTTP client");
-    }
+    // A kept-alive connection may have been closed by the server while it sat in the pool, which only shows
+    // when it is used. Such a request is repeated once on a new connection of the same handle, which keeps the
+    // TLS session of the handle for an abbreviated handshake.
+    esp_http_client_handle_t retry_client = nullptr;
+    std::vector<std::string> header_names;
+    // must outlive the handle, which is freed only after this object
+    std::unique_ptr<std::string> common_name;
+    for (int attempt = 0; ; ++attempt) {
+        http_response response;
+        m_response_buffer.clear();
+        m_body_received = 0;
 
-    auto cleanup_flag = std::make_shared<std::atomic<bool>>(false);
+        std::vector<std::string> previous_headers;
+        esp_http_client_handle_t client;
+        if (retry_client) {
+            client = retry_client;
+            previous_headers = std::move(header_names);
+        } else {
+            client = take_idle_client(origin, previous_headers, common_name);
+        }
+        const bool reused = client != nullptr;
 
-    token.register_callback([client, cleanup_flag]()
-    {
-        if (!cleanup_flag->load(std::memory_order_acquire))
+        if (reused) {
+            ESP_LOGD(TAG, "Reusing kept-alive connection to %s", origin.c_str());
+            esp_http_client_set_url(client, request_url.c_str());
+            esp_http_client_set_method(client, to_esp_method(method));
+            esp_http_client_set_timeout_ms(client, static_cast<int>(timeout.count() * 1000));
+            for (const auto& name : previous_headers) {
+                esp_http_client_delete_header(client, name.c_str());
+            }
+        } else {
+            esp_http_client_config_t config = {};
+            config.url = request_url.c_str();
+            config.method = to_esp_method(method);
+            config.timeout_ms = static_cast<int>(timeout.count() * 1000);
+            config.event_handler = http_event_handler;
+            config.buffer_size = 2048;
+            config.buffer_size_tx = 2048;
+            config.keep_alive_enable = KEEP_ALIVE_IDLE_MS > 0;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+            // the session is taken from each closed connection and offered by the next one of this handle
+            config.save_client_session = TLS_SESSION_KEEP_MS > 0;
+#endif
+            if (by_address) {
+                // server name and certificate check still go by the host name
+                common_name.reset(new std::string(target.host));
+                config.common_name = common_name->c_str();
+            }
+
+            client = esp_http_client_init(&config);
+            if (!client) {
+                throw std::runtime_error("Failed to initialize HTTP client");
+            }
+        }
+
+        // pooled handles outlive the adapter that created them, point the data events at this one
+        esp_http_client_set_user_data(client, this);
+
+        auto cleanup_flag = std::make_shared<std::atomic<bool>>(false);
+
+        token.register_callback([client, cleanup_flag]()
+        {
+            if (!cleanup_flag->load(std::memory_order_acquire))
+            {
+                esp_http_client_close(client);
+            }
+        });
+
+        if (token.is_canceled())
         {
-            esp_http_client_close(client);
+            cleanup_flag->store(true, std::memory_order_release);
+            esp_http_client_cleanup(client);
+            throw canceled_exception();
         }
-    });
 
-    if (token.is_canceled())
-    {
-        esp_http_client_cleanup(client);
-        throw canceled_exception();
+        // Set headers
+        if (by_address) {
+            esp_http_client_set_header(client, "Host", target.authority.c_str());
+        }
+        header_names.clear();
+        for (const auto& header : headers) {
+            esp_http_client_set_header(client, header.first.c_str(), header.second.c_str());
+            header_names.push_back(header.first);
+        }
+
+        // Set body for POST requests, clearing the one a reused handle may still point at
+        if (method == http_method::POST && !content.empty()) {
+            esp_http_client_set_post_field(client, content.c_str(), content.length());
+        } else if (reused) {
+            esp_http_client_set_post_field(client, nullptr, 0);
+        }
+
+        // Perform request
+        esp_err_t err = esp_http_client_perform(client);
+
+        // Set cleanup flag BEFORE cleanup to prevent cancellation callback from accessing freed client
+        cleanup_flag->store(true, std::memory_order_release);
+
+        if (err != ESP_OK) {
+            // a body handler cannot take back chunks it was already given
+            if (reused && attempt == 0 && m_body_received == 0 && !token.is_canceled()) {
+                ESP_LOGD(TAG, "Kept-alive connection to %s failed (%s), retrying on a new one",
+                        origin.c_str(), esp_err_to_name(err));
+                esp_http_client_close(client);
+                retry_client = client;
+                continue;
+            }
+            // never hand a connection in an unknown state to the next request
+            esp_http_client_cleanup(client);
+            if (by_address && !token.is_canceled()) {
+                // the host may have moved, have the next request look it up again
+                dns_cache::expire(target.host);
+            }
+            throw std::runtime_error("HTTP request failed: " + std::string(esp_err_to_name(err)));
+        }
+
+        response.status_code = esp_http_client_get_status_code(client);
+        response.content = std::move(m_response_buffer);
+
+        ESP_LOGD(TAG, "HTTP Status: %d, Response length: %d", 
+                response.status_code, (int)m_body_received);
+
+        // an error response or one cut short may leave the connection in any state, and a poll or stream would
+        // fill the pool with handles nobody asked to keep
+        if (keep_alive && response.status_code >= 200 && response.status_code < 300 &&
+            esp_http_client_is_complete_data_received(client)) {
+            release_client(origin, client, std::move(header_names), std::move(common_name));
+        } else {
+            esp_http_client_cleanup(client);
+        }
+        if (token.is_canceled())
+        {
+            throw canceled_exception();
+        }
+        return response;
     }
+}
 
-    // Set headers
-    for (const auto& header : headers) {
-        esp_http_client_set_header(client, header.first.c_str(), header.second.c_str());
+std::string esp32_http_client::origin_of(const std::string& url) {
+    // scheme://authority, the part a connection can be shared by
+    auto scheme_end = url.find("://");
+    auto authority_start = scheme_end == std::string::npos ? 0 : scheme_end + 3;
+    auto authority_end = url.find_first_of("/?#", authority_start);
+    std::string origin = url.substr(0, authority_end);
+    for (auto& c : origin) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
     }
+    return origin;
+}
 
-    // Set body for POST requests
-    if (method == http_method::POST && !content.empty()) {
-        esp_http_client_set_post_field(client, content.c_str(), content.length());
+int esp32_http_client::retention_ms(const std::string& origin) {
+    // past the keep-alive time a https handle is only worth its TLS session
+    if (TLS_SESSION_KEEP_MS > KEEP_ALIVE_IDLE_MS && origin.compare(0, 8, "https://") == 0) {
+        return TLS_SESSION_KEEP_MS;
     }
+    return KEEP_ALIVE_IDLE_MS;
+}
 
-    // Perform request
-    esp_err_t err = esp_http_client_perform(client);
-    
-    if (err == ESP_OK) {
-        response.status_code = esp_http_client_get_status_code(client);
-        response.content = m_response_buffer;
-        
-        ESP_LOGI(TAG, "HTTP Status: %d, Response length: %d", 
-                response.status_code, m_response_buffer.length());
+std::chrono::milliseconds esp32_http_client::expire_idle_clients(std::vector<idle_client>& expired) {
+    auto now = std::chrono::steady_clock::now();
+    auto next_due = std::chrono::steady_clock::duration::max();
+    std::vector<esp_http_client_handle_t> idle_too_long;
+    for (auto it = s_idle_clients.begin(); it != s_idle_clients.end();) {
+        auto idle = now - it->released;
+        auto retention = std::chrono::milliseconds(retention_ms(it->origin));
+        if (idle > retention) {
+            expired.push_back(std::move(*it));
+            it = s_idle_clients.erase(it);
+            continue;
+        }
+
+        if (!it->closed && idle > std::chrono::milliseconds(KEEP_ALIVE_IDLE_MS)) {
+            // the server has most likely dropped the connection, closing it frees the socket and saves the session
+            idle_too_long.push_back(it->client);
+            it->closed = true;
+        }
+
+        auto due = (it->closed ? retention : std::chrono::milliseconds(KEEP_ALIVE_IDLE_MS)) - idle;
+        next_due = std::min(next_due, std::chrono::duration_cast<std::chrono::steady_clock::duration>(due));
+        ++it;
+    }
+
+    // closed with the lock held so no other request takes a handle that is being closed
+    for (auto handle : idle_too_long) {
+        esp_http_client_close(handle);
+    }
+
+    if (s_idle_clients.empty()) {
+        return std::chrono::milliseconds::zero();
+    }
+    // rounded up, an entry is only due once it is past its time
+    return std::chrono::duration_cast<std::chrono::milliseconds>(next_due) + std::chrono::milliseconds(1);
+}
+
+void esp32_http_client::schedule_sweep(std::chrono::milliseconds due) {
+    if (reconnect_worker::post_after(pdMS_TO_TICKS(due.count()) + 1, sweep_idle_clients, nullptr, sweep_dropped)) {
+        s_sweep_scheduled = true;
     } else {
-        // Set cleanup flag BEFORE cleanup to prevent cancellation callback from accessing freed client
-        cleanup_flag->store(true, std::memory_order_release);
-        esp_http_client_cleanup(client);
-        throw std::runtime_error("HTTP request failed: " + std::string(esp_err_to_name(err)));
+        // the next release tries again, until then the next request expires the pool
+        ESP_LOGW(TAG, "Failed to schedule expiring idle connections");
+    }
+}
+
+void esp32_http_client::sweep_dropped(void*) {
+    // the next release schedules a new sweep
+    std::lock_guard<std::mutex> lock(s_idle_lock);
+    s_sweep_scheduled = false;
+}
+
+void esp32_http_client::sweep_idle_clients(void*) {
+    std::vector<idle_client> expired;
+    {
+        std::lock_guard<std::mutex> lock(s_idle_lock);
+        s_sweep_scheduled = false;
+        auto next_due = expire_idle_clients(expired);
+        if (next_due.count() > 0) {
+            schedule_sweep(next_due);
+        }
     }
 
-    cleanup_flag->store(true, std::memory_order_release);
-    esp_http_client_cleanup(client);
-    if (token.is_canceled())
+    // each entry frees its common_name only after its handle is gone
+    for (auto& entry : expired) {
+        esp_http_client_cleanup(entry.client);
+    }
+}
+
+esp_http_client_handle_t esp32_http_client::take_idle_client(const std::string& origin, std::vector<std::string>& header_names,
+                                                             std::unique_ptr<std::string>& common_name) {
+    std::vector<idle_client> expired;
+    esp_http_client_handle_t client = nullptr;
     {
-        throw canceled_exception();
+        std::lock_guard<std::mutex> lock(s_idle_lock);
+        // the sweep may be running late, never hand out a handle past its time
+        expire_idle_clients(expired);
+        for (auto it = s_idle_clients.begin(); it != s_idle_clients.end(); ++it) {
+            if (it->origin == origin) {
+                client = it->client;
+                header_names = std::move(it->header_names);
+                common_name = std::move(it->common_name);
+                s_idle_clients.erase(it);
+                break;
+            }
+        }
+    }
+
+    // each entry frees its common_name only after its handle is gone
+    for (auto& entry : expired) {
+        esp_http_client_cleanup(entry.client);
+    }
+    return client;
+}
+
+void esp32_http_client::release_client(const std::string& origin, esp_http_client_handle_t client, std::vector<std::string> header_names,
+                                       std::unique_ptr<std::string> common_name) {
+    esp_http_client_handle_t evicted = nullptr;
+    std::unique_ptr<std::string> evicted_common_name;
+    if (retention_ms(origin) <= 0) {
+        evicted = client;
+        evicted_common_name = std::move(common_name);
+    } else {
+        std::lock_guard<std::mutex> lock(s_idle_lock);
+        if (s_idle_clients.size() >= MAX_IDLE_CLIENTS) {
+            // the oldest one is the most likely to have been closed by its server already
+            evicted = s_idle_clients.front().client;
+            evicted_common_name = std::move(s_idle_clients.front().common_name);
+            s_idle_clients.erase(s_idle_clients.begin());
+        }
+
+        idle_client idle;
+        idle.origin = origin;
+        idle.client = client;
+        idle.header_names = std::move(header_names);
+        idle.released = std::chrono::steady_clock::now();
+        idle.closed = false;
+        idle.common_name = std::move(common_name);
+        s_idle_clients.push_back(std::move(idle));
+
+        // idle handles are closed and freed on time even when no further request comes, which is the usual case
+        // once the hub connection is up
+        if (!s_sweep_scheduled) {
+            schedule_sweep(std::chrono::milliseconds(KEEP_ALIVE_IDLE_MS));
+        }
+    }
+
+    if (evicted) {
+        esp_http_client_cleanup(evicted);
     }
-    return response;
 }
 
 esp_err_t esp32_http_client::http_event_handler(esp_http_client_event_t* evt) {
     switch (evt->event_id) {
         case HTTP_EVENT_ON_DATA:
             if (evt->data_len > 0 && evt->user_data) {
-                auto* buffer = static_cast<std::string*>(evt->user_data);
-                buffer->append(static_cast<char*>(evt->data), evt->data_len);
+                auto* self = static_cast<esp32_http_client*>(evt->user_data);
+                self->m_body_received += evt->data_len;
+                if (self->m_body_handler) {
+                    self->m_body_handler(static_cast<const char*>(evt->data), evt->data_len);
+                } else {
+                    self->m_response_buffer.append(static_cast<char*>(evt->data), evt->data_len);
+                }
                 ESP_LOGD(TAG, "Received %d bytes", evt->data_len);
             }
             break;
@@ -127,6 +407,10 @@ esp_err_t esp32_http_client::http_event_handler(esp_http_client_event_t* evt) {
 
         case HTTP_EVENT_ON_CONNECTED:
             ESP_LOGD(TAG, "HTTP connected");
+            // transports started from the negotiate callback connect within the same trace scope
+            if (evt->user_data && static_cast<esp32_http_client*>(evt->user_data)->m_negotiate) {
+                connect_trace_recorder::mark_current(connect_trace_recorder::phase::negotiate_connected);
+            }
             break;
 
         case HTTP_EVENT_HEADERS_SENT:
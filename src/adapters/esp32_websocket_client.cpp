@@ -1,6 +1,7 @@
 #include "esp32_websocket_client.h"
 #include "signalr_client_config.h"
 #include "memory_utils.h"
+#include "dns_cache.h"
 #include "esp_log.h"
 #include <cstring>
 #include <exception>
@@ -153,7 +154,8 @@ esp32_websocket_client::esp32_websocket_client(const signalr_client_config& conf
     , m_callback_semaphore(nullptr)
     , m_callback_task_running(false)
     , m_is_connected(false)
-    , m_is_stopping(false) {
+    , m_is_stopping(false)
+    , m_dns_cache_ttl(config.is_dns_cache_websocket_by_address() ? config.get_dns_cache_ttl() : std::chrono::milliseconds::zero()) {
     
     m_event_group = xEventGroupCreate();
     if (!m_event_group) {
@@ -203,8 +205,22 @@ void esp32_websocket_client::start(const std::string& url, std::function<void(st
         m_pending_receive_callback = nullptr;
     }
 
+    resolved_url target;
+    auto dns = dns_cache::resolve_url(url, m_dns_cache_ttl, target);
+    if (dns == dns_cache::status::failed) {
+        ESP_LOGE(TAG, "Failed to resolve %s", target.host.c_str());
+        callback(get_client_start_failed_exception());
+        return;
+    }
+    const bool by_address = dns == dns_cache::status::resolved;
+
     esp_websocket_client_config_t ws_cfg = {};
-    ws_cfg.uri = url.c_str();
+    ws_cfg.uri = by_address ? target.url.c_str() : url.c_str();
+    if (by_address) {
+        ESP_LOGD(TAG, "Connecting to cached address %s of %s", target.address.c_str(), target.host.c_str());
+        m_cert_common_name = target.host;
+        ws_cfg.cert_common_name = m_cert_common_name.c_str();
+    }
     ws_cfg.buffer_size = WEBSOCKET_BUFFER_SIZE;
     ws_cfg.task_stack = WEBSOCKET_TASK_STACK_SIZE;
     // Set network timeout for underlying TCP operations
@@ -249,6 +265,10 @@ void esp32_websocket_client::start(const std::string& url, std::function<void(st
         callback(nullptr);
     } else {
         ESP_LOGE(TAG, "Connection timeout or failed");
+        if (by_address) {
+            // the host may have moved, have the next attempt look it up again
+            dns_cache::expire(target.host);
+        }
         // CRITICAL: Clean up the WebSocket client on timeout!
         // Otherwise the client keeps running and may connect later, causing state inconsistency.
         if (m_client) {
@@ -3,36 +3,92 @@
 // See the LICENSE file in the project root for more information.
 
 #include "callback_manager.h"
-#include <sstream>
+#include "signalr_exception.h"
+#include "sdkconfig.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
 
 namespace signalr
 {
+#ifdef CONFIG_SIGNALR_MAX_PENDING_INVOCATIONS
+    const size_t callback_manager::default_capacity = CONFIG_SIGNALR_MAX_PENDING_INVOCATIONS;
+#else
+    const size_t callback_manager::default_capacity = 64;
+#endif
+    const size_t callback_manager::max_capacity;
+
+    // an id is the generation in the upper and the slot index in the lower 16 bits, independent of the table size so
+    // ids handed out before the table grows stay valid
+    static const uint32_t index_bits = 16;
+    static const uint32_t index_mask = (1u << index_bits) - 1;
+    static const uint32_t max_generation = UINT32_MAX >> index_bits;
+
     // dtor_clear_arguments will be passed when closing any pending callbacks when the `callback_manager` is
     // destroyed (i.e. in the dtor)
-    callback_manager::callback_manager(const char* dtor_clear_arguments)
-        : m_dtor_clear_arguments(dtor_clear_arguments)
-    { }
+    callback_manager::callback_manager(const char* dtor_clear_arguments, size_t capacity)
+        : m_timed_out(0), m_dtor_clear_arguments(dtor_clear_arguments)
+    {
+        add_slots(std::min(std::max(capacity, (size_t)1), max_capacity));
+    }
 
     callback_manager::~callback_manager()
     {
         clear(m_dtor_clear_arguments.data());
     }
 
-    // note: callback must not throw except for the `on_progress` callback which will never be invoked from the dtor
     std::string callback_manager::register_callback(const std::function<void(const char*, const signalr::value&)>& callback)
     {
-        auto callback_id = get_callback_id();
+        return register_callback(callback, nullptr);
+    }
+
+    std::string callback_manager::register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+        const std::function<void(signalr::value&&)>& on_item)
+    {
+        return register_callback(callback, on_item, 0);
+    }
+
+    // note: callback must not throw except for the `on_item` callback which will never be invoked from the dtor
+    // a deadline of 0 means the callback only completes with the invocation or the connection
+    std::string callback_manager::register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+        const std::function<void(signalr::value&&)>& on_item, int64_t deadline_ms)
+    {
+        uint32_t id;
 
         {
             std::lock_guard<std::mutex> lock(m_map_lock);
 
-            m_callbacks.insert(std::make_pair(callback_id, callback));
+            if (m_free.empty())
+            {
+                if (m_slots.size() >= max_capacity)
+                {
+                    throw signalr_exception("too many pending invocations, at most " + std::to_string(m_slots.size())
+                        + " can be outstanding");
+                }
+                add_slots(std::min(m_slots.size(), max_capacity - m_slots.size()));
+            }
+
+            auto index = m_free.back();
+            m_free.pop_back();
+
+            auto& entry = m_slots[index];
+            entry.on_completion = callback;
+            entry.on_item = on_item;
+            entry.occupied = true;
+            entry.deadline = deadline_ms;
+            if (deadline_ms != 0)
+            {
+                push_deadline(index);
+            }
+            id = (entry.generation << index_bits) | index;
         }
 
-        return callback_id;
+        // at most 10 digits, stays within the small string buffer
+        char buffer[16];
+        auto length = snprintf(buffer, sizeof(buffer), "%u", (unsigned)id);
+        return std::string(buffer, (size_t)length);
     }
 
-
     // invokes a callback and stops tracking it if remove callback set to true
     bool callback_manager::invoke_callback(const std::string& callback_id, const char* error, const signalr::value& arguments, bool remove_callback)
     {
@@ -41,17 +97,20 @@ namespace signalr
         {
             std::lock_guard<std::mutex> lock(m_map_lock);
 
-            auto iter = m_callbacks.find(callback_id);
-            if (iter == m_callbacks.end())
+            auto entry = find_slot(callback_id);
+            if (entry == nullptr)
             {
                 return false;
             }
 
-            callback = iter->second;
-
             if (remove_callback)
             {
-                m_callbacks.erase(callback_id);
+                callback.swap(entry->on_completion);
+                release_slot(*entry);
+            }
+            else
+            {
+                callback = entry->on_completion;
             }
         }
 
@@ -59,12 +118,40 @@ namespace signalr
         return true;
     }
 
+    // hands a stream item to the callback registered for the stream, the registration stays in place
+    bool callback_manager::invoke_item(const std::string& callback_id, signalr::value&& item)
+    {
+        std::function<void(signalr::value&&)> on_item;
+
+        {
+            std::lock_guard<std::mutex> lock(m_map_lock);
+
+            auto entry = find_slot(callback_id);
+            if (entry == nullptr || !entry->on_item)
+            {
+                return false;
+            }
+
+            on_item = entry->on_item;
+        }
+
+        on_item(std::move(item));
+        return true;
+    }
+
     bool callback_manager::remove_callback(const std::string& callback_id)
     {
         {
             std::lock_guard<std::mutex> lock(m_map_lock);
 
-            return m_callbacks.erase(callback_id) != 0;
+            auto entry = find_slot(callback_id);
+            if (entry == nullptr)
+            {
+                return false;
+            }
+
+            release_slot(*entry);
+            return true;
         }
     }
 
@@ -73,20 +160,193 @@ namespace signalr
         {
             std::lock_guard<std::mutex> lock(m_map_lock);
 
-            for (auto& kvp : m_callbacks)
+            for (auto& entry : m_slots)
             {
-                kvp.second(error, signalr::value());
+                if (entry.occupied)
+                {
+                    entry.on_completion(error, signalr::value());
+                    release_slot(entry);
+                }
             }
+        }
+    }
+
+    size_t callback_manager::expire(int64_t now_ms, const char* error)
+    {
+        std::vector<std::function<void(const char*, const signalr::value&)>> expired;
+
+        {
+            std::lock_guard<std::mutex> lock(m_map_lock);
 
-            m_callbacks.clear();
+            while (!m_deadlines.empty() && m_slots[m_deadlines.front()].deadline <= now_ms)
+            {
+                auto& entry = m_slots[m_deadlines.front()];
+                expired.push_back(std::move(entry.on_completion));
+                release_slot(entry);
+            }
+
+            m_timed_out += expired.size();
         }
+
+        // run outside of the lock, the callbacks and their captures are released when `expired` goes away
+        for (auto& callback : expired)
+        {
+            callback(error, signalr::value());
+        }
+
+        return expired.size();
     }
 
-    std::string callback_manager::get_callback_id()
+    size_t callback_manager::pending() const
     {
-        const auto callback_id = m_id++;
-        std::stringstream ss;
-        ss << callback_id;
-        return ss.str();
+        std::lock_guard<std::mutex> lock(m_map_lock);
+        return m_slots.size() - m_free.size();
+    }
+
+    size_t callback_manager::timed_out() const
+    {
+        std::lock_guard<std::mutex> lock(m_map_lock);
+        return m_timed_out;
+    }
+
+    callback_manager::slot* callback_manager::find_slot(const std::string& callback_id)
+    {
+        // ids are generated here, anything that is not a plain decimal number did not come from us
+        if (callback_id.empty() || callback_id.size() > 10)
+        {
+            return nullptr;
+        }
+
+        uint64_t id = 0;
+        for (auto c : callback_id)
+        {
+            if (c < '0' || c > '9')
+            {
+                return nullptr;
+            }
+            id = id * 10 + (uint64_t)(c - '0');
+        }
+
+        auto index = (uint32_t)id & index_mask;
+        if (id > UINT32_MAX || index >= m_slots.size())
+        {
+            return nullptr;
+        }
+
+        auto& entry = m_slots[index];
+        if (!entry.occupied || entry.generation != (uint32_t)id >> index_bits)
+        {
+            return nullptr;
+        }
+
+        return &entry;
+    }
+
+    // must be called with m_map_lock held or from the ctor
+    void callback_manager::add_slots(size_t count)
+    {
+        auto first = m_slots.size();
+        m_slots.resize(first + count);
+        m_free.reserve(m_slots.size());
+        m_deadlines.reserve(m_slots.size());
+        // pushed in reverse so the lowest index is taken first
+        for (size_t i = m_slots.size(); i > first; --i)
+        {
+            m_slots[i - 1].deadline = 0;
+            m_slots[i - 1].generation = 0;
+            m_slots[i - 1].heap_index = no_deadline;
+            m_slots[i - 1].occupied = false;
+            m_free.push_back((uint16_t)(i - 1));
+        }
+    }
+
+    void callback_manager::release_slot(slot& entry)
+    {
+        auto index = (uint16_t)(&entry - m_slots.data());
+        if (entry.heap_index != no_deadline)
+        {
+            remove_deadline(index);
+        }
+
+        entry.on_completion = nullptr;
+        entry.on_item = nullptr;
+        entry.occupied = false;
+        // wrap before the id would overflow 32 bits
+        if (++entry.generation > max_generation)
+        {
+            entry.generation = 0;
+        }
+        m_free.push_back(index);
+    }
+
+    void callback_manager::push_deadline(uint16_t index)
+    {
+        m_slots[index].heap_index = (uint16_t)m_deadlines.size();
+        m_deadlines.push_back(index);
+        sift_up(m_deadlines.size() - 1);
+    }
+
+    void callback_manager::remove_deadline(uint16_t index)
+    {
+        size_t position = m_slots[index].heap_index;
+        size_t last = m_deadlines.size() - 1;
+        if (position != last)
+        {
+            swap_deadlines(position, last);
+        }
+        m_deadlines.pop_back();
+        m_slots[index].heap_index = no_deadline;
+
+        if (position < m_deadlines.size())
+        {
+            sift_up(position);
+            sift_down(position);
+        }
+    }
+
+    void callback_manager::swap_deadlines(size_t a, size_t b)
+    {
+        std::swap(m_deadlines[a], m_deadlines[b]);
+        m_slots[m_deadlines[a]].heap_index = (uint16_t)a;
+        m_slots[m_deadlines[b]].heap_index = (uint16_t)b;
+    }
+
+    void callback_manager::sift_up(size_t position)
+    {
+        while (position > 0)
+        {
+            size_t parent = (position - 1) / 2;
+            if (m_slots[m_deadlines[parent]].deadline <= m_slots[m_deadlines[position]].deadline)
+            {
+                break;
+            }
+            swap_deadlines(parent, position);
+            position = parent;
+        }
+    }
+
+    void callback_manager::sift_down(size_t position)
+    {
+        size_t count = m_deadlines.size();
+        while (true)
+        {
+            size_t smallest = position;
+            size_t left = position * 2 + 1;
+            size_t right = left + 1;
+            if (left < count && m_slots[m_deadlines[left]].deadline < m_slots[m_deadlines[smallest]].deadline)
+            {
+                smallest = left;
+            }
+            if (right < count && m_slots[m_deadlines[right]].deadline < m_slots[m_deadlines[smallest]].deadline)
+            {
+                smallest = right;
+            }
+            if (smallest == position)
+            {
+                break;
+            }
+            swap_deadlines(position, smallest);
+            position = smallest;
+        }
     }
 }
@@ -4,34 +4,81 @@
 
 #pragma once
 
-#include <atomic>
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 #include <functional>
 #include <mutex>
 #include "signalr_value.h"
 
 namespace signalr
 {
+    // Pending invocations live in a table of slots. An id encodes the slot index and a generation that is bumped
+    // every time the slot is reused, so registering and completing are O(1) and a late or forged completion for a
+    // recycled slot is not mistaken for the current occupant. `capacity` slots are allocated up front; when they are
+    // all taken the table doubles, up to max_capacity, so only a burst beyond the initial size allocates.
     class callback_manager
     {
     public:
-        explicit callback_manager(const char* dtor_error);
+        explicit callback_manager(const char* dtor_error, size_t capacity = default_capacity);
         ~callback_manager();
 
         callback_manager(const callback_manager&) = delete;
         callback_manager& operator=(const callback_manager&) = delete;
 
+        static const size_t default_capacity;
+        // slot indexes are 16 bits, with one value reserved
+        static const size_t max_capacity = 0xFFFF;
+
+        // throws signalr_exception when max_capacity callbacks are pending
         std::string register_callback(const std::function<void(const char*, const signalr::value&)>& callback);
+        // `on_item` receives the items of a server-to-client stream, `callback` completes it
+        std::string register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+            const std::function<void(signalr::value&&)>& on_item);
+        // `callback` is completed by expire if it is still pending at `deadline_ms` (steady clock milliseconds)
+        std::string register_callback(const std::function<void(const char*, const signalr::value&)>& callback,
+            const std::function<void(signalr::value&&)>& on_item, int64_t deadline_ms);
         bool invoke_callback(const std::string& callback_id, const char* error, const signalr::value& arguments, bool remove_callback);
+        bool invoke_item(const std::string& callback_id, signalr::value&& item);
         bool remove_callback(const std::string& callback_id);
         void clear(const char* error);
 
+        // completes the callbacks whose deadline is at or before `now_ms` with `error`, returns how many expired
+        size_t expire(int64_t now_ms, const char* error);
+
+        size_t pending() const;
+        size_t timed_out() const;
+
     private:
-        std::atomic<int> m_id { 0 };
-        std::unordered_map<std::string, std::function<void(const char*, const signalr::value&)>> m_callbacks;
-        std::mutex m_map_lock;
+        struct slot
+        {
+            std::function<void(const char*, const signalr::value&)> on_completion;
+            std::function<void(signalr::value&&)> on_item;
+            int64_t deadline;
+            uint32_t generation;
+            // position in m_deadlines or no_deadline
+            uint16_t heap_index;
+            bool occupied;
+        };
+
+        static const uint16_t no_deadline = 0xFFFF;
+
+        std::vector<slot> m_slots;
+        // indexes of the unoccupied slots, used as a stack
+        std::vector<uint16_t> m_free;
+        // min-heap of the indexes of the slots that have a deadline, ordered by deadline
+        std::vector<uint16_t> m_deadlines;
+        size_t m_timed_out;
+        mutable std::mutex m_map_lock;
         std::string m_dtor_clear_arguments;
 
-        std::string get_callback_id();
+        // returns the slot the id refers to if it is occupied by that generation, must be called with m_map_lock held
+        slot* find_slot(const std::string& callback_id);
+        void add_slots(size_t count);
+        void release_slot(slot& entry);
+        void push_deadline(uint16_t index);
+        void remove_deadline(uint16_t index);
+        void swap_deadlines(size_t a, size_t b);
+        void sift_up(size_t position);
+        void sift_down(size_t position);
     };
 }
@@ -0,0 +1,205 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "client_stream.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    std::shared_ptr<client_stream> client_stream::create(const std::string& stream_id, size_t window, const std::shared_ptr<scheduler>& scheduler,
+        const serializer& serialize, const sender& send)
+    {
+        return std::shared_ptr<client_stream>(new client_stream(stream_id, window, scheduler, serialize, send));
+    }
+
+    client_stream::client_stream(const std::string& stream_id, size_t window, const std::shared_ptr<scheduler>& scheduler,
+        const serializer& serialize, const sender& send)
+        : m_id(stream_id), m_window(window), m_scheduler(scheduler), m_serialize(serialize), m_send(send),
+        m_in_flight(0), m_open(true), m_pumping(false)
+    { }
+
+    const std::string& client_stream::id() const
+    {
+        return m_id;
+    }
+
+    bool client_stream::write(const signalr::value& item, const std::function<void(std::exception_ptr)>& callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (!m_open || m_in_flight >= m_window)
+            {
+                return false;
+            }
+        }
+
+        std::string payload;
+        try
+        {
+            payload = m_serialize(stream_item_message(m_id, item));
+        }
+        catch (...)
+        {
+            callback(std::current_exception());
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        // checked again, another producer may have taken the last slot while this one was serializing
+        if (!m_open || m_in_flight >= m_window)
+        {
+            return false;
+        }
+
+        ++m_in_flight;
+        m_queue.push_back(pending_message{ std::move(payload), callback });
+        schedule_pump();
+        return true;
+    }
+
+    bool client_stream::complete(const std::string& error, const std::function<void(std::exception_ptr)>& callback)
+    {
+        std::string payload;
+        try
+        {
+            payload = m_serialize(completion_message(m_id, error, signalr::value(), false));
+        }
+        catch (...)
+        {
+            close(std::current_exception());
+            callback(std::current_exception());
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_open)
+        {
+            return false;
+        }
+
+        // the completion does not count against the window, it is the last message of the stream
+        m_open = false;
+        ++m_in_flight;
+        m_queue.push_back(pending_message{ std::move(payload), callback });
+        schedule_pump();
+        return true;
+    }
+
+    void client_stream::close(std::exception_ptr reason)
+    {
+        std::deque<pending_message> dropped;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_open = false;
+            m_in_flight -= m_queue.size();
+            dropped.swap(m_queue);
+        }
+
+        for (auto& message : dropped)
+        {
+            message.callback(reason);
+        }
+    }
+
+    void client_stream::set_ready_handler(const std::function<void()>& handler)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_ready_handler = handler;
+    }
+
+    size_t client_stream::in_flight() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_in_flight;
+    }
+
+    bool client_stream::is_open() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_open;
+    }
+
+    void client_stream::schedule_pump()
+    {
+        if (m_pumping)
+        {
+            return;
+        }
+
+        auto scheduler = m_scheduler.lock();
+        if (!scheduler)
+        {
+            return;
+        }
+
+        m_pumping = true;
+        auto self = shared_from_this();
+        scheduler->schedule([self]()
+            {
+                self->pump();
+            });
+    }
+
+    void client_stream::pump()
+    {
+        auto self = shared_from_this();
+        while (true)
+        {
+            pending_message message;
+
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_queue.empty())
+                {
+                    m_pumping = false;
+                    return;
+                }
+
+                message = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            auto callback = message.callback;
+            try
+            {
+                m_send(message.payload, [self, callback](std::exception_ptr exception)
+                    {
+                        self->on_sent(exception, callback);
+                    });
+            }
+            catch (...)
+            {
+                on_sent(std::current_exception(), callback);
+            }
+        }
+    }
+
+    void client_stream::on_sent(std::exception_ptr exception, const std::function<void(std::exception_ptr)>& callback)
+    {
+        std::function<void()> ready_handler;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_in_flight-- == m_window && m_open)
+            {
+                ready_handler = m_ready_handler;
+            }
+        }
+
+        if (exception)
+        {
+            // the link is gone, fail what is still queued instead of trying each item
+            close(exception);
+            ready_handler = nullptr;
+        }
+
+        callback(exception);
+
+        if (ready_handler)
+        {
+            ready_handler();
+        }
+    }
+}
@@ -0,0 +1,79 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "scheduler.h"
+#include "signalr_value.h"
+#include "hub_protocol.h"
+
+namespace signalr
+{
+    // Sends the items of one client-to-server stream. Writes are serialized on the caller and sent in order from the
+    // scheduler, so a slow link blocks a worker rather than the producer. At most `window` messages are queued or
+    // in flight; beyond that write() rejects items so the producer can drop, coalesce or wait for the ready handler.
+    class client_stream : public std::enable_shared_from_this<client_stream>
+    {
+    public:
+        typedef std::function<std::string(const hub_message&)> serializer;
+        typedef std::function<void(const std::string&, std::function<void(std::exception_ptr)>)> sender;
+
+        static std::shared_ptr<client_stream> create(const std::string& stream_id, size_t window, const std::shared_ptr<scheduler>& scheduler,
+            const serializer& serialize, const sender& send);
+
+        client_stream(const client_stream&) = delete;
+        client_stream& operator=(const client_stream&) = delete;
+
+        const std::string& id() const;
+
+        // returns false without invoking the callback if the stream is closed or the window is full
+        bool write(const signalr::value& item, const std::function<void(std::exception_ptr)>& callback);
+
+        // sends the completion after the queued items, an empty error completes the stream normally
+        bool complete(const std::string& error, const std::function<void(std::exception_ptr)>& callback);
+
+        // the connection went away or the invocation ended, queued items are failed with `reason`
+        void close(std::exception_ptr reason);
+
+        // invoked whenever a full window gets room again
+        void set_ready_handler(const std::function<void()>& handler);
+
+        size_t in_flight() const;
+        bool is_open() const;
+
+    private:
+        client_stream(const std::string& stream_id, size_t window, const std::shared_ptr<scheduler>& scheduler,
+            const serializer& serialize, const sender& send);
+
+        struct pending_message
+        {
+            std::string payload;
+            std::function<void(std::exception_ptr)> callback;
+        };
+
+        // must be called with m_lock held
+        void schedule_pump();
+        void pump();
+        void on_sent(std::exception_ptr exception, const std::function<void(std::exception_ptr)>& callback);
+
+        const std::string m_id;
+        const size_t m_window;
+        std::weak_ptr<scheduler> m_scheduler;
+        serializer m_serialize;
+        sender m_send;
+
+        mutable std::mutex m_lock;
+        std::deque<pending_message> m_queue;
+        std::function<void()> m_ready_handler;
+        // queued plus handed to the transport and not yet acknowledged
+        size_t m_in_flight;
+        bool m_open;
+        bool m_pumping;
+    };
+}
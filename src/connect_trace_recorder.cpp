@@ -0,0 +1,180 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "connect_trace_recorder.h"
+#include <cstring>
+
+namespace signalr
+{
+    namespace
+    {
+        // the negotiate and the WebSocket connect run synchronously on the task that starts the connection, so the
+        // adapters find the recorder of the attempt they belong to here
+        thread_local connect_trace_recorder* t_current = nullptr;
+
+        void reset_trace(connect_trace& trace)
+        {
+            trace.reconnect = false;
+            trace.succeeded = false;
+            trace.negotiate_requests = 0;
+            trace.negotiate_sent_ms = -1;
+            trace.negotiate_connected_ms = -1;
+            trace.negotiate_completed_ms = -1;
+            trace.websocket_started_ms = -1;
+            trace.websocket_connected_ms = -1;
+            trace.handshake_sent_ms = -1;
+            trace.handshake_acked_ms = -1;
+            trace.first_message_ms = -1;
+        }
+
+        int32_t* phase_field(connect_trace& trace, connect_trace_recorder::phase phase)
+        {
+            switch (phase)
+            {
+            case connect_trace_recorder::phase::negotiate_sent: return &trace.negotiate_sent_ms;
+            case connect_trace_recorder::phase::negotiate_connected: return &trace.negotiate_connected_ms;
+            case connect_trace_recorder::phase::negotiate_completed: return &trace.negotiate_completed_ms;
+            case connect_trace_recorder::phase::websocket_started: return &trace.websocket_started_ms;
+            case connect_trace_recorder::phase::websocket_connected: return &trace.websocket_connected_ms;
+            case connect_trace_recorder::phase::handshake_sent: return &trace.handshake_sent_ms;
+            case connect_trace_recorder::phase::handshake_acked: return &trace.handshake_acked_ms;
+            case connect_trace_recorder::phase::first_message: return &trace.first_message_ms;
+            }
+            return nullptr;
+        }
+    }
+
+    connect_trace_recorder::scope::scope(connect_trace_recorder& recorder)
+        : m_previous(t_current)
+    {
+        t_current = &recorder;
+    }
+
+    connect_trace_recorder::scope::~scope()
+    {
+        t_current = m_previous;
+    }
+
+    connect_trace_recorder::connect_trace_recorder()
+        : m_running(false), m_awaiting_first_message(false)
+    {
+        reset_trace(m_trace);
+        memset(&m_stats, 0, sizeof(m_stats));
+        memset(&m_sums, 0, sizeof(m_sums));
+    }
+
+    void connect_trace_recorder::begin(bool reconnect)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        reset_trace(m_trace);
+        m_trace.reconnect = reconnect;
+        m_started = std::chrono::steady_clock::now();
+        m_running = true;
+        m_awaiting_first_message = false;
+    }
+
+    void connect_trace_recorder::mark(phase phase)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        bool late_first_message = phase == phase::first_message && m_awaiting_first_message;
+        if (!m_running && !late_first_message)
+        {
+            return;
+        }
+
+        if (phase == phase::negotiate_sent)
+        {
+            ++m_trace.negotiate_requests;
+        }
+
+        int32_t* field = phase_field(m_trace, phase);
+        if (*field >= 0 && phase != phase::negotiate_completed)
+        {
+            return;
+        }
+
+        *field = (int32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_started).count();
+
+        if (late_first_message)
+        {
+            m_awaiting_first_message = false;
+            add_sample(m_stats.first_message, m_sums.first_message, m_trace.handshake_acked_ms, m_trace.first_message_ms);
+        }
+    }
+
+    void connect_trace_recorder::mark_current(phase phase)
+    {
+        if (t_current != nullptr)
+        {
+            t_current->mark(phase);
+        }
+    }
+
+    void connect_trace_recorder::finish(bool succeeded)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_running)
+        {
+            return;
+        }
+
+        m_running = false;
+        m_trace.succeeded = succeeded;
+
+        ++m_stats.attempts;
+        add_sample(m_stats.negotiate, m_sums.negotiate, m_trace.negotiate_sent_ms, m_trace.negotiate_completed_ms);
+        add_sample(m_stats.websocket, m_sums.websocket, m_trace.websocket_started_ms, m_trace.websocket_connected_ms);
+        add_sample(m_stats.handshake, m_sums.handshake, m_trace.handshake_sent_ms, m_trace.handshake_acked_ms);
+        if (succeeded)
+        {
+            ++m_stats.succeeded;
+            add_sample(m_stats.total, m_sums.total, 0, m_trace.handshake_acked_ms);
+
+            if (m_trace.first_message_ms >= 0)
+            {
+                add_sample(m_stats.first_message, m_sums.first_message, m_trace.handshake_acked_ms, m_trace.first_message_ms);
+            }
+            else
+            {
+                m_awaiting_first_message = true;
+            }
+        }
+    }
+
+    connect_trace connect_trace_recorder::last() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_trace;
+    }
+
+    connect_trace_stats connect_trace_recorder::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_stats;
+    }
+
+    void connect_trace_recorder::add_sample(connect_phase_stats& stats, int64_t& sum, int32_t from_ms, int32_t to_ms)
+    {
+        if (from_ms < 0 || to_ms < from_ms)
+        {
+            return;
+        }
+
+        int32_t duration = to_ms - from_ms;
+        if (stats.samples == 0 || duration < stats.min_ms)
+        {
+            stats.min_ms = duration;
+        }
+        if (stats.samples == 0 || duration > stats.max_ms)
+        {
+            stats.max_ms = duration;
+        }
+
+        ++stats.samples;
+        sum += duration;
+        stats.avg_ms = (int32_t)(sum / stats.samples);
+    }
+}
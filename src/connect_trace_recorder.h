@@ -0,0 +1,81 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "connect_trace.h"
+#include <chrono>
+#include <mutex>
+
+namespace signalr
+{
+    // Records the connect_trace of the current attempt of one connection and aggregates finished attempts. Phases are
+    // marked from whichever task reaches them. Code that has no reference to the connection, like the HTTP adapter,
+    // marks the recorder a scope installed on its task.
+    class connect_trace_recorder
+    {
+    public:
+        enum class phase
+        {
+            negotiate_sent,
+            negotiate_connected,
+            negotiate_completed,
+            websocket_started,
+            websocket_connected,
+            handshake_sent,
+            handshake_acked,
+            first_message
+        };
+
+        // makes `recorder` the one mark_current() records to on this task, for the lifetime of the scope
+        class scope
+        {
+        public:
+            explicit scope(connect_trace_recorder& recorder);
+            ~scope();
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+        private:
+            connect_trace_recorder* m_previous;
+        };
+
+        connect_trace_recorder();
+
+        // starts a new attempt, the previous one is dropped if it was not finished
+        void begin(bool reconnect);
+
+        // records the first time a phase is reached in the current attempt, except negotiate_completed which follows
+        // the last redirect. Ignored when no attempt is running, first_message is also taken after finish()
+        void mark(phase phase);
+        static void mark_current(phase phase);
+
+        // ends the current attempt and adds it to the stats
+        void finish(bool succeeded);
+
+        connect_trace last() const;
+        connect_trace_stats stats() const;
+
+    private:
+        mutable std::mutex m_lock;
+        std::chrono::steady_clock::time_point m_started;
+        bool m_running;
+        // the first_message phase of a finished successful attempt is still outstanding
+        bool m_awaiting_first_message;
+        connect_trace m_trace;
+        connect_trace_stats m_stats;
+        // totals behind the averages of m_stats
+        struct
+        {
+            int64_t negotiate;
+            int64_t websocket;
+            int64_t handshake;
+            int64_t total;
+            int64_t first_message;
+        } m_sums;
+
+        static void add_sample(connect_phase_stats& stats, int64_t& sum, int32_t from_ms, int32_t to_ms);
+    };
+}
@@ -7,6 +7,7 @@
 #include "connection_impl.h"
 #ifdef CONFIG_SIGNALR_ENABLE_NEGOTIATION
 #include "negotiate.h"
+#include "negotiate_cache.h"
 #endif
 #include "url_builder.h"
 #ifdef CONFIG_SIGNALR_ENABLE_TRACE_LOG_WRITER
@@ -22,6 +23,31 @@
 
 namespace signalr
 {
+    namespace
+    {
+        struct transport_name
+        {
+            transport_type type;
+            // as negotiate lists it in availableTransports
+            const char* name;
+        };
+
+        // the transports of this client, most preferred first. One that fails to connect falls back to the next one
+        // the server offers
+        const transport_name preferred_transports[] =
+        {
+            { transport_type::websockets, "WebSockets" },
+#ifdef CONFIG_SIGNALR_ENABLE_SSE_TRANSPORT
+            { transport_type::server_sent_events, "ServerSentEvents" },
+#endif
+#ifdef CONFIG_SIGNALR_ENABLE_LONG_POLLING_TRANSPORT
+            { transport_type::long_polling, "LongPolling" },
+#endif
+        };
+
+        constexpr size_t preferred_transport_count = sizeof(preferred_transports) / sizeof(preferred_transports[0]);
+    }
+
     std::shared_ptr<connection_impl> connection_impl::create(const std::string& url, trace_level trace_level, const std::shared_ptr<log_writer>& log_writer,
         std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory, std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory, const bool skip_negotiation)
     {
@@ -36,8 +62,9 @@ namespace signalr
 
     connection_impl::connection_impl(const std::string& url, trace_level trace_level, const std::shared_ptr<log_writer>& log_writer,
         std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory, std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory, const bool skip_negotiation)
-        : m_base_url(url), m_connection_state(connection_state::disconnected), m_logger(log_writer, trace_level), m_transport(nullptr), m_skip_negotiation(skip_negotiation),
-        m_message_received([](const std::string&) noexcept {}), m_disconnected([](std::exception_ptr) noexcept {}), m_disconnect_cts(std::make_shared<cancellation_token_source>())
+        : m_base_url(url), m_base_endpoint(std::make_shared<url_builder::endpoint>(url)), m_connection_state(connection_state::disconnected), m_logger(log_writer, trace_level), m_transport(nullptr), m_skip_negotiation(skip_negotiation),
+        m_message_received([](const std::string&) noexcept {}), m_disconnected([](std::exception_ptr) noexcept {}), m_disconnect_cts(std::make_shared<cancellation_token_source>()),
+        m_stateful_reconnect(false), m_transport_type(transport_type::websockets)
     {
         if (http_client_factory != nullptr)
         {
@@ -170,6 +197,8 @@ namespace signalr
             
             m_start_completed_event.reset();
             m_connection_id = "";
+            m_stateful_reconnect = false;
+            m_transport_type = transport_type::websockets;
         }
 
         m_scheduler = m_signalr_client_config.get_scheduler();
@@ -183,15 +212,48 @@ namespace signalr
         start_negotiate(m_base_url, callback);
     }
 
-    void connection_impl::start_negotiate(const std::string& url, std::function<void(std::exception_ptr)> callback)
+    void connection_impl::resume(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_stop_lock);
+
+            if (!m_stateful_reconnect || m_connection_token.empty())
+            {
+                callback(std::make_exception_ptr(signalr_exception("the connection did not negotiate stateful reconnect and cannot be resumed")));
+                return;
+            }
+
+            if (!change_state(connection_state::disconnected, connection_state::connecting))
+            {
+                callback(std::make_exception_ptr(signalr_exception("cannot resume a connection that is not in the disconnected state")));
+                return;
+            }
+
+            assert(!m_transport);
+
+            // the connection id and token are kept, the server matches them to the connection it is holding on to
+            m_disconnect_cts->reset();
+            m_start_completed_event.reset();
+        }
+
+        m_logger.log(trace_level::info, "resuming the connection");
+        start_negotiate(m_transport_url, callback, true);
+    }
+
+    void connection_impl::start_negotiate(const std::string& url, std::function<void(std::exception_ptr)> callback, bool resume)
     {
         std::weak_ptr<connection_impl> weak_connection = shared_from_this();
         const auto token = m_disconnect_cts;
 
+        negotiate_cache_entry cached;
+        const auto cache_ttl = m_signalr_client_config.get_negotiate_cache_ttl();
+        const bool from_cache = !m_skip_negotiation && !resume && cache_ttl.count() > 0
+            && negotiate_cache::lookup(url, cache_ttl, cached);
+
         std::shared_ptr<bool> connect_request_done = std::make_shared<bool>();
         std::shared_ptr<std::mutex> connect_request_lock = std::make_shared<std::mutex>();
 
-        const auto transport_started = [weak_connection, connect_request_done, connect_request_lock, callback, token]
+        const auto transport_started = [weak_connection, connect_request_done, connect_request_lock, callback, token, from_cache, url]
         (std::shared_ptr<transport> transport, std::exception_ptr exception)
         {
             {
@@ -246,6 +308,12 @@ namespace signalr
                             std::string("connection could not be started due to: ")
                             .append(e.what()));
                     }
+
+                    if (from_cache)
+                    {
+                        // the redirect may have moved or its token expired, the next start negotiates from the beginning
+                        negotiate_cache::invalidate(url);
+                    }
                 }
 
                 connection->m_transport = nullptr;
@@ -314,17 +382,45 @@ namespace signalr
                 transport_started(nullptr, nullptr);
             });
 
-        if (m_skip_negotiation)
+        if (m_skip_negotiation || resume)
         {
             // TODO: check that the websockets transport is explicitly selected
 
-            return start_transport(url, transport_started);
+            return start_transport(url, m_transport_type, transport_started);
+        }
+
+        if (from_cache)
+        {
+            if (!cached.access_token.empty())
+            {
+                m_signalr_client_config.get_http_headers()["Authorization"] = "Bearer " + cached.access_token;
+            }
+            m_negotiate_access_token = cached.access_token;
+
+            if (m_signalr_client_config.is_negotiate_cache_direct_connect() && cached.websockets_available
+                && !m_signalr_client_config.is_stateful_reconnect_enabled())
+            {
+                m_logger.log(trace_level::info, "using the cached negotiate result, connecting without negotiating");
+
+                // the server assigns the connection id when the WebSocket is accepted
+                m_connection_id.clear();
+                m_connection_token.clear();
+                m_stateful_reconnect = false;
+                m_transport_url = cached.url;
+                return start_transport(cached.url, transport_type::websockets, transport_started);
+            }
+
+            m_logger.log(trace_level::info, "using the cached negotiate result, skipping negotiate redirects");
+            start_negotiate_internal(cached.url, 0, transport_started, true);
+            return;
         }
 
+        m_negotiate_access_token.clear();
         start_negotiate_internal(url, 0, transport_started);
     }
 
-    void connection_impl::start_negotiate_internal(const std::string& url, int redirect_count, std::function<void(std::shared_ptr<transport> transport, std::exception_ptr)> transport_started)
+    void connection_impl::start_negotiate_internal(const std::string& url, int redirect_count, std::function<void(std::shared_ptr<transport> transport, std::exception_ptr)> transport_started,
+        bool from_cache, size_t first_transport)
     {
         if (m_disconnect_cts->is_canceled())
         {
@@ -340,9 +436,23 @@ namespace signalr
         std::weak_ptr<connection_impl> weak_connection = shared_from_this();
         const auto token = m_disconnect_cts;
 
+        std::shared_ptr<const url_builder::endpoint> endpoint;
+        try
+        {
+            endpoint = endpoint_for(url);
+        }
+        catch (...)
+        {
+            transport_started(nullptr, std::current_exception());
+            return;
+        }
+
         auto http_client = m_http_client_factory(m_signalr_client_config);
-        negotiate::negotiate(http_client, url, m_signalr_client_config,
-            [transport_started, weak_connection, redirect_count, token, url](negotiation_response&& response, std::exception_ptr exception)
+        m_connect_trace.mark(connect_trace_recorder::phase::negotiate_sent);
+        // lets the HTTP adapter record when its connection is up
+        connect_trace_recorder::scope trace_scope(m_connect_trace);
+        negotiate::negotiate(http_client, *endpoint, m_signalr_client_config,
+            [transport_started, weak_connection, redirect_count, token, url, from_cache, first_transport](negotiation_response&& response, std::exception_ptr exception)
             {
                 auto connection = weak_connection.lock();
                 if (!connection)
@@ -370,6 +480,8 @@ namespace signalr
                     return;
                 }
 
+                connection->m_connect_trace.mark(connect_trace_recorder::phase::negotiate_completed);
+
                 if (!response.error.empty())
                 {
                     transport_started(nullptr, std::make_exception_ptr(signalr_exception(response.error)));
@@ -382,32 +494,50 @@ namespace signalr
                     {
                         auto& headers = connection->m_signalr_client_config.get_http_headers();
                         headers["Authorization"] = "Bearer " + response.accessToken;
+                        connection->m_negotiate_access_token = response.accessToken;
                     }
-                    connection->start_negotiate_internal(response.url, redirect_count + 1, transport_started);
+                    connection->start_negotiate_internal(response.url, redirect_count + 1, transport_started, false, first_transport);
                     return;
                 }
 
                 connection->m_connection_id = std::move(response.connectionId);
                 connection->m_connection_token = std::move(response.connectionToken);
+                connection->m_stateful_reconnect = response.useStatefulReconnect;
+                connection->m_transport_url = url;
 
-                // TODO: fallback logic
-
-                bool foundWebsockets = false;
-                for (auto& availableTransport : response.availableTransports)
+                // indexes into preferred_transports of the offered ones, in order of preference
+                std::vector<size_t> offered;
+                for (size_t i = first_transport; i < preferred_transport_count; ++i)
                 {
-                    case_insensitive_equals comparer;
-                    if (comparer(availableTransport.transport, "WebSockets"))
+                    for (auto& availableTransport : response.availableTransports)
                     {
-                        foundWebsockets = true;
-                        break;
+                        case_insensitive_equals comparer;
+                        if (comparer(availableTransport.transport, preferred_transports[i].name))
+                        {
+                            offered.push_back(i);
+                            break;
+                        }
                     }
                 }
 
-                if (!foundWebsockets)
+                if (offered.empty())
                 {
-                    transport_started(nullptr, std::make_exception_ptr(signalr_exception("The server does not support WebSockets which is currently the only transport supported by this client.")));
+                    transport_started(nullptr, std::make_exception_ptr(signalr_exception(first_transport > 0
+                        ? "The transport connection failed and the server does not offer another transport supported by this client."
+                        : "The server does not offer a transport supported by this client.")));
                     return;
                 }
+                connection->m_transport_type = preferred_transports[offered[0]].type;
+
+                // an entry keeps the time it was first stored, a negotiate that started from it does not extend its life
+                if (!from_cache && connection->m_signalr_client_config.get_negotiate_cache_ttl().count() > 0)
+                {
+                    negotiate_cache_entry entry;
+                    entry.url = url;
+                    entry.access_token = connection->m_negotiate_access_token;
+                    entry.websockets_available = connection->m_transport_type == transport_type::websockets;
+                    negotiate_cache::store(connection->m_base_url, entry);
+                }
 
                 // TODO: use transfer format
 
@@ -417,11 +547,38 @@ namespace signalr
                     return;
                 }
 
-                connection->start_transport(url, transport_started);
+                if (offered.size() > 1)
+                {
+                    // A proxy that does not pass the WebSocket upgrade or holds back a streamed response only shows when
+                    // connecting. The connection token may already be bound to the failed transport, so the fallback
+                    // negotiates a new one.
+                    const size_t next_transport = offered[0] + 1;
+                    auto fell_back = std::make_shared<std::atomic<bool>>(false);
+                    auto fallback = [transport_started, weak_connection, token, url, from_cache, next_transport, fell_back]
+                    (std::shared_ptr<transport> transport, std::exception_ptr exception)
+                    {
+                        auto connection = weak_connection.lock();
+                        // only the first outcome decides, a later receive error of a started transport is not a failed connect
+                        if (fell_back->exchange(true) || transport || exception == nullptr || token->is_canceled() || !connection)
+                        {
+                            transport_started(transport, exception);
+                            return;
+                        }
+
+                        connection->m_logger.log(trace_level::warning,
+                            std::string("the ").append(preferred_transports[next_transport - 1].name)
+                            .append(" connection failed, falling back to the next transport"));
+                        connection->start_negotiate_internal(url, 0, transport_started, from_cache, next_transport);
+                    };
+                    connection->start_transport(url, connection->m_transport_type, fallback);
+                    return;
+                }
+
+                connection->start_transport(url, connection->m_transport_type, transport_started);
             }, get_cancellation_token(m_disconnect_cts));
     }
 
-    void connection_impl::start_transport(const std::string& url, std::function<void(std::shared_ptr<transport>, std::exception_ptr)> transport_started)
+    void connection_impl::start_transport(const std::string& url, transport_type transport_type, std::function<void(std::shared_ptr<transport>, std::exception_ptr)> transport_started)
     {
         auto connection = shared_from_this();
 
@@ -430,7 +587,7 @@ namespace signalr
         const auto& logger = m_logger;
 
         auto transport = connection->m_transport_factory->create_transport(
-            transport_type::websockets, connection->m_logger, connection->m_signalr_client_config);
+            transport_type, connection->m_logger, connection->m_signalr_client_config);
 
         transport->on_close([weak_connection](std::exception_ptr exception)
             {
@@ -498,10 +655,16 @@ namespace signalr
                 }
             });
 
-        connection->send_connect_request(transport, url, [transport_started, transport](std::exception_ptr exception)
+        m_connect_trace.mark(connect_trace_recorder::phase::websocket_started);
+        connection->send_connect_request(transport, url, [transport_started, transport, weak_connection](std::exception_ptr exception)
             {
                 if (exception == nullptr)
                 {
+                    auto connection = weak_connection.lock();
+                    if (connection)
+                    {
+                        connection->m_connect_trace.mark(connect_trace_recorder::phase::websocket_connected);
+                    }
                     transport_started(transport, nullptr);
                 }
                 else
@@ -511,11 +674,40 @@ namespace signalr
             });
     }
 
+    std::shared_ptr<const url_builder::endpoint> connection_impl::endpoint_for(const std::string& url)
+    {
+        if (url == m_base_url)
+        {
+            return m_base_endpoint;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_endpoint_lock);
+            if (m_redirect_endpoint && m_redirect_endpoint->base_url == url)
+            {
+                return m_redirect_endpoint;
+            }
+        }
+
+        auto endpoint = std::make_shared<url_builder::endpoint>(url);
+        std::lock_guard<std::mutex> lock(m_endpoint_lock);
+        m_redirect_endpoint = endpoint;
+        return endpoint;
+    }
+
     void connection_impl::send_connect_request(const std::shared_ptr<transport>& transport, const std::string& url, std::function<void(std::exception_ptr)> callback)
     {
         auto logger = m_logger;
-        auto query_string = "id=" + m_connection_token;
-        auto connect_url = url_builder::build_connect(url, transport->get_transport_type(), query_string);
+        std::string connect_url;
+        try
+        {
+            connect_url = url_builder::build_connect(*endpoint_for(url), transport->get_transport_type(), "id=" + m_connection_token);
+        }
+        catch (...)
+        {
+            callback(std::current_exception());
+            return;
+        }
 
         transport->start(connect_url, [callback, logger](std::exception_ptr exception)
             mutable {
@@ -792,6 +984,16 @@ namespace signalr
         return m_connection_state.load();
     }
 
+    bool connection_impl::is_stateful_reconnect() const noexcept
+    {
+        return m_stateful_reconnect;
+    }
+
+    connect_trace_recorder& connection_impl::get_connect_trace() noexcept
+    {
+        return m_connect_trace;
+    }
+
     std::string connection_impl::get_connection_id() const noexcept
     {
         if (m_connection_state.load() == connection_state::connecting)
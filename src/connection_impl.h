@@ -14,6 +14,8 @@
 #include "logger.h"
 #include "negotiation_response.h"
 #include "cancellation_token_source.h"
+#include "connect_trace_recorder.h"
+#include "url_builder.h"
 
 namespace signalr
 {
@@ -37,11 +39,17 @@ namespace signalr
         ~connection_impl();
 
         void start(std::function<void(std::exception_ptr)> callback) noexcept;
+        // reconnects the transport of a dropped stateful reconnect connection with the same connection token, without negotiating
+        void resume(std::function<void(std::exception_ptr)> callback) noexcept;
         void send(const std::string &data, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept;
         void stop(std::function<void(std::exception_ptr)> callback, std::exception_ptr exception) noexcept;
 
         connection_state get_connection_state() const noexcept;
         std::string get_connection_id() const noexcept;
+        // whether the server agreed to stateful reconnect during the last negotiate
+        bool is_stateful_reconnect() const noexcept;
+        // timing of the connect attempts, begun and finished by the hub connection which owns the handshake
+        connect_trace_recorder& get_connect_trace() noexcept;
 
         void set_message_received(const std::function<void(std::string&&)>& message_received);
         void set_disconnected(const std::function<void(std::exception_ptr)>& disconnected);
@@ -50,6 +58,10 @@ namespace signalr
     private:
         std::shared_ptr<scheduler> m_scheduler;
         std::string m_base_url;
+        // m_base_url split once, and the last negotiate redirect target so reconnects do not parse it again
+        std::shared_ptr<const url_builder::endpoint> m_base_endpoint;
+        std::shared_ptr<const url_builder::endpoint> m_redirect_endpoint;
+        std::mutex m_endpoint_lock;
         std::atomic<connection_state> m_connection_state;
         logger m_logger;
         std::shared_ptr<transport> m_transport;
@@ -66,16 +78,28 @@ namespace signalr
         cancellation_token_source m_start_completed_event;
         std::string m_connection_id;
         std::string m_connection_token;
+        bool m_stateful_reconnect;
+        // url the transport connected to after negotiate redirects, reused by resume()
+        std::string m_transport_url;
+        // transport picked by the last negotiate, reused by resume()
+        transport_type m_transport_type;
+        // access token of the last negotiate redirect, kept with the cached negotiate result
+        std::string m_negotiate_access_token;
         std::function<std::shared_ptr<http_client>(const signalr_client_config&)> m_http_client_factory;
+        connect_trace_recorder m_connect_trace;
 
         connection_impl(const std::string& url, trace_level trace_level, const std::shared_ptr<log_writer>& log_writer,
             std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory, std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory, bool skip_negotiation);
 
-        void start_transport(const std::string& url, std::function<void(std::shared_ptr<transport>, std::exception_ptr)> callback);
+        void start_transport(const std::string& url, transport_type transport_type, std::function<void(std::shared_ptr<transport>, std::exception_ptr)> callback);
         void send_connect_request(const std::shared_ptr<transport>& transport,
             const std::string& url, std::function<void(std::exception_ptr)> callback);
-        void start_negotiate(const std::string& url, std::function<void(std::exception_ptr)> callback);
-        void start_negotiate_internal(const std::string& url, int redirect_count, std::function<void(std::shared_ptr<transport> transport, std::exception_ptr)> callback);
+        void start_negotiate(const std::string& url, std::function<void(std::exception_ptr)> callback, bool resume = false);
+        // transports before `first_transport` in the order of preference are skipped, they failed to connect already
+        void start_negotiate_internal(const std::string& url, int redirect_count, std::function<void(std::shared_ptr<transport> transport, std::exception_ptr)> callback,
+            bool from_cache = false, size_t first_transport = 0);
+
+        std::shared_ptr<const url_builder::endpoint> endpoint_for(const std::string& url);
 
         void process_response(std::string&& response);
 
@@ -0,0 +1,257 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "dns_cache.h"
+#include "lwip/dns.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+#include "lwip/tcpip.h"
+#include "esp_log.h"
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace signalr
+{
+    namespace dns_cache
+    {
+        namespace
+        {
+            // the hub and a negotiate redirect target, with room for one more before the oldest is dropped
+            constexpr size_t MAX_ENTRIES = 4;
+
+            struct entry
+            {
+                std::string address;
+                std::chrono::steady_clock::time_point resolved;
+                bool expired = false;
+                bool refreshing = false;
+            };
+
+            std::mutex s_lock;
+            std::map<std::string, entry> s_entries;
+
+            bool is_address(const std::string& host)
+            {
+                in_addr ipv4;
+                in6_addr ipv6;
+                return inet_pton(AF_INET, host.c_str(), &ipv4) == 1 || inet_pton(AF_INET6, host.c_str(), &ipv6) == 1;
+            }
+
+            bool lookup(const std::string& host, std::string& address)
+            {
+                addrinfo hints;
+                memset(&hints, 0, sizeof(hints));
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = SOCK_STREAM;
+
+                addrinfo* result = nullptr;
+                int err = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+                if (err != 0 || result == nullptr)
+                {
+                    ESP_LOGW("DNS_CACHE", "resolving %s failed (%d)", host.c_str(), err);
+                    return false;
+                }
+
+                char buffer[INET6_ADDRSTRLEN] = {};
+                const char* printed = nullptr;
+                if (result->ai_family == AF_INET)
+                {
+                    printed = inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr, buffer, sizeof(buffer));
+                }
+                else if (result->ai_family == AF_INET6)
+                {
+                    printed = inet_ntop(AF_INET6, &reinterpret_cast<sockaddr_in6*>(result->ai_addr)->sin6_addr, buffer, sizeof(buffer));
+                }
+                freeaddrinfo(result);
+
+                if (printed == nullptr)
+                {
+                    return false;
+                }
+                address = printed;
+                return true;
+            }
+
+            void store(const std::string& host, const std::string& address)
+            {
+                std::lock_guard<std::mutex> lock(s_lock);
+
+                if (s_entries.size() >= MAX_ENTRIES && s_entries.find(host) == s_entries.end())
+                {
+                    auto oldest = s_entries.begin();
+                    for (auto it = s_entries.begin(); it != s_entries.end(); ++it)
+                    {
+                        if (it->second.resolved < oldest->second.resolved)
+                        {
+                            oldest = it;
+                        }
+                    }
+                    s_entries.erase(oldest);
+                }
+
+                entry& stored = s_entries[host];
+                if (stored.address != address && !stored.address.empty())
+                {
+                    ESP_LOGI("DNS_CACHE", "%s moved from %s to %s", host.c_str(), stored.address.c_str(), address.c_str());
+                }
+                stored.address = address;
+                stored.resolved = std::chrono::steady_clock::now();
+                stored.expired = false;
+                stored.refreshing = false;
+            }
+
+            void refresh_done(std::unique_ptr<std::string> host, const ip_addr_t* ip)
+            {
+                char buffer[IPADDR_STRLEN_MAX] = {};
+                if (ip != nullptr && ipaddr_ntoa_r(ip, buffer, sizeof(buffer)) != nullptr)
+                {
+                    store(*host, buffer);
+                    return;
+                }
+
+                // keep serving the old address, the next lookup tries again
+                ESP_LOGW("DNS_CACHE", "refreshing %s failed", host->c_str());
+                std::lock_guard<std::mutex> lock(s_lock);
+                auto it = s_entries.find(*host);
+                if (it != s_entries.end())
+                {
+                    it->second.refreshing = false;
+                }
+            }
+
+            // lwIP callbacks, both run on the tcpip thread and own the host name they are given
+            void refresh_found(const char*, const ip_addr_t* ip, void* param)
+            {
+                refresh_done(std::unique_ptr<std::string>(static_cast<std::string*>(param)), ip);
+            }
+
+            void start_refresh(void* param)
+            {
+                ip_addr_t ip;
+                err_t err = dns_gethostbyname(static_cast<std::string*>(param)->c_str(), &ip, refresh_found, param);
+                if (err == ERR_INPROGRESS)
+                {
+                    // refresh_found runs once the server answered or the query timed out
+                    return;
+                }
+
+                refresh_done(std::unique_ptr<std::string>(static_cast<std::string*>(param)), err == ERR_OK ? &ip : nullptr);
+            }
+
+            // false if the url has no host name that could be replaced (no scheme, user info, ipv6 literal)
+            bool split_url(const std::string& url, size_t& host_start, size_t& host_end, size_t& authority_end)
+            {
+                auto scheme_end = url.find("://");
+                if (scheme_end == std::string::npos)
+                {
+                    return false;
+                }
+
+                host_start = scheme_end + 3;
+                authority_end = url.find_first_of("/?#", host_start);
+                if (authority_end == std::string::npos)
+                {
+                    authority_end = url.size();
+                }
+
+                if (host_start == authority_end || url[host_start] == '[' ||
+                    url.find('@', host_start) < authority_end)
+                {
+                    return false;
+                }
+
+                host_end = url.find(':', host_start);
+                if (host_end == std::string::npos || host_end > authority_end)
+                {
+                    host_end = authority_end;
+                }
+                return true;
+            }
+        }
+
+        status resolve_url(const std::string& url, std::chrono::milliseconds ttl, resolved_url& resolved)
+        {
+            size_t host_start, host_end, authority_end;
+            if (ttl.count() <= 0 || !split_url(url, host_start, host_end, authority_end))
+            {
+                return status::bypassed;
+            }
+
+            std::string host = url.substr(host_start, host_end - host_start);
+            if (is_address(host))
+            {
+                return status::bypassed;
+            }
+
+            std::string address;
+            bool cached = false;
+            bool refresh = false;
+            {
+                std::lock_guard<std::mutex> lock(s_lock);
+                auto it = s_entries.find(host);
+                if (it != s_entries.end())
+                {
+                    cached = true;
+                    address = it->second.address;
+
+                    bool stale = it->second.expired || std::chrono::steady_clock::now() - it->second.resolved > ttl;
+                    if (stale && !it->second.refreshing)
+                    {
+                        it->second.refreshing = true;
+                        refresh = true;
+                    }
+                }
+            }
+
+            // the query is sent from the tcpip thread and its answer stored there, nothing waits for it. Queued outside
+            // the lock, as the tcpip thread takes it to store the answer
+            if (refresh)
+            {
+                auto param = new std::string(host);
+                if (tcpip_try_callback(start_refresh, param) != ERR_OK)
+                {
+                    // the tcpip mailbox is full, the next lookup tries again
+                    refresh_done(std::unique_ptr<std::string>(param), nullptr);
+                }
+            }
+
+            if (!cached)
+            {
+                if (!lookup(host, address))
+                {
+                    resolved.host = std::move(host);
+                    return status::failed;
+                }
+                store(host, address);
+            }
+
+            resolved.address = address;
+            resolved.authority = url.substr(host_start, authority_end - host_start);
+            resolved.url = url.substr(0, host_start);
+            if (address.find(':') != std::string::npos)
+            {
+                resolved.url.append("[").append(address).append("]");
+            }
+            else
+            {
+                resolved.url.append(address);
+            }
+            resolved.url.append(url, host_end, std::string::npos);
+            resolved.host = std::move(host);
+            return status::resolved;
+        }
+
+        void expire(const std::string& host)
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+            auto it = s_entries.find(host);
+            if (it != s_entries.end())
+            {
+                it->second.expired = true;
+            }
+        }
+    }
+}
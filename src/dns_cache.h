@@ -0,0 +1,47 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace signalr
+{
+    // A url with its host name replaced by a cached address, plus what the request still needs of the name
+    struct resolved_url
+    {
+        // same url with the address in place of the host name, ipv6 addresses in brackets
+        std::string url;
+        // host name, for the TLS server name and the certificate check
+        std::string host;
+        // host name with the port of the original url, for the Host header
+        std::string authority;
+        std::string address;
+    };
+
+    // Resolved addresses keyed by host name, shared by all connections of the program, so a reconnect does not wait
+    // for a DNS round trip and still works while the DNS server is unreachable.
+    //
+    // An entry is used as is while it is younger than the ttl of the lookup. After that it is still used, and refreshed
+    // in the background with an asynchronous query of the lwIP resolver; a refresh that fails keeps the old address.
+    // The resolver's own table follows the TTL of the DNS record, so the ttl here acts as a floor on it.
+    namespace dns_cache
+    {
+        enum class status
+        {
+            // the cache is off or the url has an address already, connect with the url as it is
+            bypassed,
+            resolved,
+            // the host has no cached address and cannot be resolved right now
+            failed
+        };
+
+        status resolve_url(const std::string& url, std::chrono::milliseconds ttl, resolved_url& resolved);
+
+        // for connects to a cached address that failed: the next lookup still gets the address but refreshes it, in
+        // case the host moved
+        void expire(const std::string& host);
+    }
+}
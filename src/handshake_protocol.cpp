@@ -5,17 +5,23 @@
 #include "handshake_protocol.h"
 #include "json_helpers.h"
 #include "signalr_exception.h"
+#include <cctype>
 
 namespace signalr
 {
     namespace handshake
     {
         std::string write_handshake(const std::unique_ptr<hub_protocol>& protocol)
+        {
+            return write_handshake(protocol, protocol->version());
+        }
+
+        std::string write_handshake(const std::unique_ptr<hub_protocol>& protocol, int version)
         {
             auto map = std::map<std::string, signalr::value>
             {
                 { "protocol", signalr::value(protocol->name()) },
-                { "version", signalr::value((double)protocol->version()) }
+                { "version", signalr::value((double)version) }
             };
 
             auto writer = getJsonWriter();
@@ -41,5 +47,46 @@ namespace signalr
             auto remaining_data = response.substr(pos + 1);
             return std::forward_as_tuple(remaining_data, createValue(root));
         }
+
+        bool is_success_response(const std::string& response, size_t& length) noexcept
+        {
+            size_t pos = 0;
+            const size_t size = response.size();
+            while (pos < size && isspace((unsigned char)response[pos]))
+            {
+                ++pos;
+            }
+            if (size - pos < 2 || response[pos] != '{')
+            {
+                return false;
+            }
+            ++pos;
+            while (pos < size && isspace((unsigned char)response[pos]))
+            {
+                ++pos;
+            }
+            if (pos == size || response[pos] != '}')
+            {
+                return false;
+            }
+            ++pos;
+            while (pos < size && isspace((unsigned char)response[pos]))
+            {
+                ++pos;
+            }
+
+            // the WebSocket adapter may already have stripped the separator of a frame that holds only the handshake
+            if (pos == size)
+            {
+                length = size;
+                return true;
+            }
+            if (response[pos] == record_separator)
+            {
+                length = pos + 1;
+                return true;
+            }
+            return false;
+        }
     }
 }
\ No newline at end of file
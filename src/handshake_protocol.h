@@ -13,6 +13,11 @@ namespace signalr
     namespace handshake
     {
         std::string write_handshake(const std::unique_ptr<hub_protocol>&);
+        // `version` overrides the protocol version, stateful reconnect needs version 2 of the JSON protocol
+        std::string write_handshake(const std::unique_ptr<hub_protocol>&, int version);
         std::tuple<std::string, signalr::value> parse_handshake(const std::string&);
+        // true if `response` starts with the empty object a server answers a successful handshake with. `length` is
+        // set to the size of that frame including its separator, the rest of `response` are regular messages
+        bool is_success_response(const std::string& response, size_t& length) noexcept;
     }
 }
\ No newline at end of file
@@ -73,6 +73,16 @@ namespace signalr
         return m_pImpl->on(event_name, handler);
     }
 
+    void hub_connection::on_raw(const std::string& event_name, const raw_method_invoked_handler& handler)
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("on_raw() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->on_raw(event_name, handler);
+    }
+
     void hub_connection::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
     {
         if (!m_pImpl)
@@ -84,6 +94,18 @@ namespace signalr
         return m_pImpl->invoke(method_name, arguments, callback);
     }
 
+    void hub_connection::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception("invoke() cannot be called on destructed hub_connection instance")));
+            return;
+        }
+
+        return m_pImpl->invoke(method_name, arguments, callback, timeout);
+    }
+
     void hub_connection::send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept
     {
         if (!m_pImpl)
@@ -95,6 +117,73 @@ namespace signalr
         m_pImpl->send(method_name, arguments, callback);
     }
 
+    stream_handle hub_connection::stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept
+    {
+        if (!m_pImpl)
+        {
+            on_complete(std::make_exception_ptr(signalr_exception("stream() cannot be called on destructed hub_connection instance")));
+            return stream_handle();
+        }
+
+        return m_pImpl->stream(method_name, arguments, on_item, on_complete);
+    }
+
+    stream_writer hub_connection::send_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(std::make_exception_ptr(signalr_exception("send_with_stream() cannot be called on destructed hub_connection instance")));
+            return stream_writer();
+        }
+
+        return m_pImpl->send_with_stream(method_name, arguments, callback);
+    }
+
+    stream_writer hub_connection::invoke_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception("invoke_with_stream() cannot be called on destructed hub_connection instance")));
+            return stream_writer();
+        }
+
+        return m_pImpl->invoke_with_stream(method_name, arguments, callback);
+    }
+
+    prepared_invocation hub_connection::prepare(const std::string& method_name)
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("prepare() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->prepare(method_name);
+    }
+
+    void hub_connection::cork()
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("cork() cannot be called on destructed hub_connection instance");
+        }
+
+        m_pImpl->cork();
+    }
+
+    void hub_connection::uncork(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (!m_pImpl)
+        {
+            callback(std::make_exception_ptr(signalr_exception("uncork() cannot be called on destructed hub_connection instance")));
+            return;
+        }
+
+        m_pImpl->uncork(callback);
+    }
+
     connection_state hub_connection::get_connection_state() const
     {
         if (!m_pImpl)
@@ -115,6 +204,56 @@ namespace signalr
         return m_pImpl->get_connection_id();
     }
 
+    size_t hub_connection::get_timed_out_invocation_count() const
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("get_timed_out_invocation_count() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->get_timed_out_invocation_count();
+    }
+
+    offline_buffer_stats hub_connection::get_offline_buffer_stats() const
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("get_offline_buffer_stats() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->get_offline_buffer_stats();
+    }
+
+    connect_trace hub_connection::get_last_connect_trace() const
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("get_last_connect_trace() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->get_last_connect_trace();
+    }
+
+    connect_trace_stats hub_connection::get_connect_trace_stats() const
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("get_connect_trace_stats() cannot be called on destructed hub_connection instance");
+        }
+
+        return m_pImpl->get_connect_trace_stats();
+    }
+
+    void hub_connection::set_network_available(bool available)
+    {
+        if (!m_pImpl)
+        {
+            throw signalr_exception("set_network_available() cannot be called on destructed hub_connection instance");
+        }
+
+        m_pImpl->set_network_available(available);
+    }
+
     void hub_connection::set_disconnected(const std::function<void(std::exception_ptr)>& disconnected_callback)
     {
         if (!m_pImpl)
@@ -99,6 +99,18 @@ namespace signalr
         return *this;
     }
 
+    hub_connection_builder& hub_connection_builder::with_automatic_reconnect(std::shared_ptr<reconnect_policy> policy)
+    {
+        if (!policy)
+        {
+            throw std::runtime_error("policy must not be null.");
+        }
+
+        m_auto_reconnect_enabled = true;
+        m_reconnect_policy = std::move(policy);
+        return *this;
+    }
+
 #ifdef USE_MSGPACK
     hub_connection_builder& hub_connection_builder::with_messagepack_hub_protocol()
     {
@@ -143,6 +155,7 @@ namespace signalr
             signalr_client_config config;
             config.enable_auto_reconnect(true);
             config.set_reconnect_delays(m_reconnect_delays);
+            config.set_reconnect_policy(m_reconnect_policy);
             config.set_max_reconnect_attempts(-1); // Infinite retries by default
             
             // Apply the config - this will merge with any existing settings
@@ -16,22 +16,38 @@
 #include "websocket_client.h"
 #include "signalr_default_scheduler.h"
 #include "memory_utils.h"
+#include "json_allocator.h"
+#include "stream_item_buffer.h"
+#include "reconnect_worker.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
 #include "esp_log.h"
+#include <algorithm>
 
-// OPTIMIZED: Reconnect task stack size - dynamically determined
 namespace {
-    inline uint32_t get_reconnect_stack_size() {
-#ifdef CONFIG_SIGNALR_RECONNECT_STACK_SIZE
-        // Use Kconfig value if specified
-        return CONFIG_SIGNALR_RECONNECT_STACK_SIZE;
+#ifdef CONFIG_SIGNALR_STREAM_BUFFER_SIZE
+    constexpr size_t STREAM_BUFFER_CAPACITY = CONFIG_SIGNALR_STREAM_BUFFER_SIZE;
 #else
-        // Fall back to dynamic sizing based on PSRAM availability
-        return signalr::memory::get_recommended_stack_size("reconnect");
+    constexpr size_t STREAM_BUFFER_CAPACITY = 16;
+#endif
+
+#ifdef CONFIG_SIGNALR_MAX_MESSAGE_SIZE
+    constexpr size_t MAX_BATCH_SIZE = CONFIG_SIGNALR_MAX_MESSAGE_SIZE;
+#else
+    constexpr size_t MAX_BATCH_SIZE = 4096;
+#endif
+
+#ifdef CONFIG_SIGNALR_MESSAGE_ARENA_SIZE
+    constexpr size_t MESSAGE_ARENA_SIZE = CONFIG_SIGNALR_MESSAGE_ARENA_SIZE;
+#else
+    constexpr size_t MESSAGE_ARENA_SIZE = 1024;
+#endif
+
+#ifdef CONFIG_SIGNALR_MAX_QUEUE_SIZE
+    constexpr size_t HANDSHAKE_QUEUE_SIZE = CONFIG_SIGNALR_MAX_QUEUE_SIZE;
+#else
+    constexpr size_t HANDSHAKE_QUEUE_SIZE = 20;
 #endif
-    }
 }
 
 namespace signalr
@@ -42,12 +58,21 @@ namespace signalr
         static std::function<void(const char*, const signalr::value&)> create_hub_invocation_callback(const logger& logger,
             const std::function<void(const signalr::value&)>& set_result,
             const std::function<void(const std::exception_ptr e)>& set_exception);
+
+        // messages counted by stateful reconnect acks, pings and the ack/sequence messages themselves are not
+        static bool is_sequenced(message_type type)
+        {
+            return type == message_type::invocation || type == message_type::stream_item || type == message_type::completion ||
+                type == message_type::stream_invocation || type == message_type::cancel_invocation;
+        }
     }
 
     std::shared_ptr<hub_connection_impl> hub_connection_impl::create(const std::string& url, std::unique_ptr<hub_protocol>&& hub_protocol,
         trace_level trace_level, const std::shared_ptr<log_writer>& log_writer, std::function<std::shared_ptr<http_client>(const signalr_client_config&)> http_client_factory,
         std::function<std::shared_ptr<websocket_client>(const signalr_client_config&)> websocket_factory, const bool skip_negotiation)
     {
+        install_json_allocator();
+
         auto connection = std::shared_ptr<hub_connection_impl>(new hub_connection_impl(url, std::move(hub_protocol),
             trace_level, log_writer, http_client_factory, websocket_factory, skip_negotiation));
 
@@ -62,11 +87,16 @@ namespace signalr
         : m_connection(connection_impl::create(url, trace_level, log_writer, http_client_factory, websocket_factory, skip_negotiation))
             , m_logger(log_writer, trace_level),
         m_callback_manager("connection went out of scope before invocation result was received"),
-        m_handshakeReceived(false), m_disconnected([](std::exception_ptr) noexcept {}), m_protocol(std::move(hub_protocol)),
-        m_reconnecting(false), m_reconnect_attempts(0)
+        m_message_arena(MESSAGE_ARENA_SIZE), m_handshakeReceived(false), m_disconnected([](std::exception_ptr) noexcept {}), m_protocol(std::move(hub_protocol)),
+        m_next_stream_id(0), m_batch(MAX_BATCH_SIZE), m_handshake_pending(false), m_awaiting_first_message(false), m_stateful_reconnect(false), m_received_sequence_id(0), m_processed_sequence_id(0),
+        m_acked_sequence_id(0), m_resuming(false), m_keepalive_generation(0), m_reconnecting(false), m_reconnect_attempts(0),
+        m_last_reconnect_delay(0), m_network_available(true)
     {
         hub_message ping_msg(signalr::message_type::ping);
         m_cached_ping = m_protocol->write_message(&ping_msg);
+
+        m_offline_buffer.configure(m_signalr_client_config.get_offline_buffer_max_messages(),
+            m_signalr_client_config.get_offline_buffer_max_bytes(), m_signalr_client_config.get_offline_buffer_policy());
     }
 
     void hub_connection_impl::initialize()
@@ -94,6 +124,20 @@ namespace signalr
     }
 
     void hub_connection_impl::on(const std::string& event_name, const std::function<void(const std::vector<signalr::value>&)>& handler)
+    {
+        hub_subscription subscription;
+        subscription.handler = handler;
+        add_subscription(event_name, std::move(subscription));
+    }
+
+    void hub_connection_impl::on_raw(const std::string& event_name, const std::function<void(const std::string&, const signalr::raw_arguments&)>& handler)
+    {
+        hub_subscription subscription;
+        subscription.raw_handler = handler;
+        add_subscription(event_name, std::move(subscription));
+    }
+
+    void hub_connection_impl::add_subscription(const std::string& event_name, hub_subscription&& subscription)
     {
         if (event_name.length() == 0)
         {
@@ -116,14 +160,30 @@ namespace signalr
                 "an action for this event has already been registered. event name: " + event_name);
         }
 
-        m_subscriptions.insert({event_name, handler});
+        m_subscriptions.insert({event_name, std::move(subscription)});
         ESP_LOGI("HUB_CONN", "on('%s') SUCCESS: handler registered, total subscriptions=%d", 
                  event_name.c_str(), (int)m_subscriptions.size());
     }
 
+    void hub_connection_impl::compile_targets()
+    {
+        std::vector<std::string> names;
+        std::vector<hub_subscription> handlers;
+        names.reserve(m_subscriptions.size());
+        handlers.reserve(m_subscriptions.size());
+        for (const auto& subscription : m_subscriptions)
+        {
+            names.push_back(subscription.first);
+            handlers.push_back(subscription.second);
+        }
+
+        m_targets = target_table(names);
+        m_target_handlers = std::move(handlers);
+    }
+
     void hub_connection_impl::start(std::function<void(std::exception_ptr)> callback) noexcept
     {
-        if (m_connection->get_connection_state() != connection_state::disconnected)
+        if (m_connection->get_connection_state() != connection_state::disconnected || m_resuming.load())
         {
             callback(std::make_exception_ptr(signalr_exception(
                 "the connection can only be started if it is in the disconnected state")));
@@ -136,10 +196,33 @@ namespace signalr
             m_reconnect_attempts.store(0);
         }
 
+        try
+        {
+            // handlers can't change until the connection is disconnected again
+            compile_targets();
+        }
+        catch (...)
+        {
+            callback(std::current_exception());
+            return;
+        }
+
         m_connection->set_client_config(m_signalr_client_config);
+        // a new connection starts numbering from scratch, only resume() carries the sequence state over
+        m_stateful_reconnect.store(false);
+        m_replay_buffer.reset(m_signalr_client_config.get_stateful_reconnect_buffer_size());
+        m_received_sequence_id = 0;
+        m_processed_sequence_id.store(0);
+        m_acked_sequence_id.store(0);
         m_handshakeTask = std::make_shared<completion_event>();
         m_disconnect_cts = std::make_shared<cancellation_token_source>();
         m_handshakeReceived = false;
+        {
+            std::lock_guard<std::mutex> lock(m_handshake_queue_lock);
+            m_handshake_pending = true;
+        }
+        m_awaiting_first_message = false;
+        m_connection->get_connect_trace().begin(m_reconnecting.load());
         std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
         m_connection->start([weak_connection, callback](std::exception_ptr start_exception)
             {
@@ -154,6 +237,8 @@ namespace signalr
                 if (start_exception)
                 {
                     assert(connection->get_connection_state() == connection_state::disconnected);
+                    connection->fail_handshake_queue(start_exception);
+                    connection->m_connection->get_connect_trace().finish(false);
                     // connection didn't start, don't call stop
                     callback(start_exception);
                     return;
@@ -241,6 +326,8 @@ namespace signalr
                     if (exception != nullptr)
                     {
                         connection->m_logger.log(trace_level::warning, "handshake failed, stopping connection");
+                        connection->fail_handshake_queue(exception);
+                        connection->m_connection->get_connect_trace().finish(false);
                         connection->m_connection->stop([callback, exception](std::exception_ptr)
                             {
                                 callback(exception);
@@ -249,11 +336,18 @@ namespace signalr
                     else
                     {
                         connection->m_logger.log(trace_level::info, "handshake succeeded, starting keepalive");
+                        connection->flush_offline_buffer();
+                        connection->flush_handshake_queue();
                         connection->start_keepalive();
                     }
                 };
 
-                auto handshake_request = handshake::write_handshake(connection->m_protocol);
+                // stateful reconnect needs version 2 of the protocol, the server only agrees to it in negotiate when asked
+                auto stateful_reconnect = connection->m_connection->is_stateful_reconnect();
+                connection->m_stateful_reconnect.store(stateful_reconnect);
+                auto handshake_request = stateful_reconnect
+                    ? handshake::write_handshake(connection->m_protocol, 2)
+                    : handshake::write_handshake(connection->m_protocol);
                 auto handshake_task = connection->m_handshakeTask;
                 auto handshake_timeout = connection->m_signalr_client_config.get_handshake_timeout();
 
@@ -301,6 +395,7 @@ namespace signalr
                         return true;
                     });
 
+                connection->m_connection->get_connect_trace().mark(connect_trace_recorder::phase::handshake_sent);
                 connection->m_connection->send(handshake_request, connection->m_protocol->transfer_format(),
                     [handle_handshake, handshake_request_done, handshake_request_lock](std::exception_ptr exception)
                 {
@@ -324,6 +419,10 @@ namespace signalr
 
     void hub_connection_impl::stop(std::function<void(std::exception_ptr)> callback, bool is_dtor) noexcept
     {
+        m_offline_buffer.fail_all(std::make_exception_ptr(signalr_exception("connection was stopped before the buffered message was sent")));
+        fail_handshake_queue(std::make_exception_ptr(signalr_exception("connection was stopped before the handshake completed")));
+        m_connection->get_connect_trace().finish(false);
+
         // Cancel any ongoing reconnection attempts
         {
             std::lock_guard<std::mutex> lock(m_reconnect_lock);
@@ -347,6 +446,9 @@ namespace signalr
             }
         }
 
+        // a resume in progress put off failing the pending invocations and streams
+        abandon_resume(nullptr);
+
         if (get_connection_state() == connection_state::disconnected)
         {
             // don't log if already disconnected and stop called from dtor, it's just noise
@@ -402,12 +504,27 @@ namespace signalr
 
     void hub_connection_impl::process_message(std::string&& response)
     {
-        ESP_LOGI("HUB_CONN", ">>> process_message CALLED, message length: %d <<<", response.length());
-        ESP_LOGI("HUB_CONN", "process_message: message content: %s", response.c_str());
+        ESP_LOGD("HUB_CONN", ">>> process_message CALLED, message length: %d <<<", response.length());
+        ESP_LOGD("HUB_CONN", "process_message: message content: %s", response.c_str());
         
         try
         {
-            if (!m_handshakeReceived)
+            size_t handshake_length;
+            if (!m_handshakeReceived && handshake::is_success_response(response, handshake_length))
+            {
+                // the common case, checked in place without copying the frame or parsing it
+                ESP_LOGI("HUB_CONN", "process_message: Handshake successful! Setting m_handshakeTask...");
+                m_handshakeReceived = true;
+                complete_connect_trace();
+                m_handshakeTask->set();
+
+                if (handshake_length == response.size())
+                {
+                    return;
+                }
+                response.erase(0, handshake_length);
+            }
+            else if (!m_handshakeReceived)
             {
                 ESP_LOGI("HUB_CONN", "process_message: Handshake NOT received yet, parsing handshake...");
                 // Our WebSocket adapter strips the 0x1E record separator when queuing messages.
@@ -448,6 +565,7 @@ namespace signalr
 
                     ESP_LOGI("HUB_CONN", "process_message: Handshake successful! Setting m_handshakeTask...");
                     m_handshakeReceived = true;
+                    complete_connect_trace();
                     m_handshakeTask->set();
                     ESP_LOGI("HUB_CONN", "process_message: m_handshakeTask->set() called!");
 
@@ -459,18 +577,31 @@ namespace signalr
                 }
             }
 
-            ESP_LOGI("HUB_CONN", "process_message: Resetting server timeout...");
+            if (m_awaiting_first_message)
+            {
+                m_awaiting_first_message = false;
+                m_connection->get_connect_trace().mark(connect_trace_recorder::phase::first_message);
+            }
+
+            ESP_LOGD("HUB_CONN", "process_message: Resetting server timeout...");
             reset_server_timeout();
             
             // Ensure message has record separator for proper parsing
             // WebSocket adapter may strip the 0x1E record separator
             if (response.find(record_separator) == std::string::npos) {
-                ESP_LOGW("HUB_CONN", "process_message: Adding missing record_separator to message");
+                ESP_LOGD("HUB_CONN", "process_message: Adding missing record_separator to message");
                 response.push_back(record_separator);
             }
             
-            auto messages = m_protocol->parse_messages(response);
-            ESP_LOGI("HUB_CONN", "process_message: Parsed %d message(s)", (int)messages.size());
+            // the parsed message objects only live until this frame is dispatched, so they come from the arena and
+            // the previous frame's block is recycled here; handlers run outside of the scope
+            hub_message_list messages;
+            {
+                m_message_arena.reset();
+                memory::arena_scope arena(m_message_arena);
+                messages = m_protocol->parse_messages(response, &m_targets);
+            }
+            ESP_LOGD("HUB_CONN", "process_message: Parsed %d message(s)", (int)messages.size());
 
             for (const auto& val : messages)
             {
@@ -480,34 +611,38 @@ namespace signalr
                     throw std::runtime_error("null message received");
                 }
 
+                if (m_stateful_reconnect.load() && is_sequenced(val->message_type))
+                {
+                    // after a resume the server replays what we had not acked yet, some of it may have been handled already
+                    if (++m_received_sequence_id <= m_processed_sequence_id.load())
+                    {
+                        continue;
+                    }
+                    m_processed_sequence_id.store(m_received_sequence_id);
+                }
+
                 switch (val->message_type)
                 {
                 case message_type::invocation:
                 {
-                    auto invocation = static_cast<invocation_message*>(val.get());
-                    ESP_LOGI("HUB_CONN", "Looking for handler: target='%s', subscriptions count=%d", 
-                             invocation->target.c_str(), (int)m_subscriptions.size());
-                    auto event = m_subscriptions.find(invocation->target);
-                    if (event != m_subscriptions.end())
-                    {
-                        ESP_LOGI("HUB_CONN", "Handler FOUND for '%s', calling...", invocation->target.c_str());
-                        const auto& args = invocation->arguments;
-                        event->second(args);
-                        ESP_LOGI("HUB_CONN", "Handler '%s' call completed", invocation->target.c_str());
-                    }
-                    else
-                    {
-                        ESP_LOGW("HUB_CONN", "Handler NOT FOUND for '%s'", invocation->target.c_str());
-                        m_logger.log(trace_level::info, "handler not found");
-                    }
+                    dispatch_invocation(*static_cast<invocation_message*>(val.get()));
                     break;
                 }
                 case message_type::stream_invocation:
                     // Sent to server only, should not be received by client
                     throw std::runtime_error("Received unexpected message type 'StreamInvocation'");
                 case message_type::stream_item:
-                    // TODO
+                {
+                    auto stream_item = static_cast<stream_item_message*>(val.get());
+                    if (!m_callback_manager.invoke_item(stream_item->invocation_id, std::move(stream_item->item)))
+                    {
+                        if (m_logger.is_enabled(trace_level::info))
+                        {
+                            m_logger.log(trace_level::info, std::string("no stream found for id: ").append(stream_item->invocation_id));
+                        }
+                    }
                     break;
+                }
                 case message_type::completion:
                 {
                     auto completion = static_cast<completion_message*>(val.get());
@@ -526,6 +661,22 @@ namespace signalr
                 case message_type::close:
                     // TODO
                     break;
+                case message_type::ack:
+                {
+                    m_replay_buffer.ack(static_cast<ack_message*>(val.get())->sequence_id);
+                    break;
+                }
+                case message_type::sequence:
+                {
+                    auto sequence_id = static_cast<sequence_message*>(val.get())->sequence_id;
+                    if (sequence_id > m_processed_sequence_id.load() + 1)
+                    {
+                        throw std::runtime_error("sequence id " + std::to_string(sequence_id) +
+                            " is ahead of the last received message, messages were lost");
+                    }
+                    m_received_sequence_id = sequence_id - 1;
+                    break;
+                }
                 default:
                     throw std::runtime_error("unknown message type '" + std::to_string(static_cast<int>(val->message_type)) + "' received");
                     break;
@@ -547,6 +698,45 @@ namespace signalr
         }
     }
 
+    void hub_connection_impl::dispatch_invocation(const invocation_message& invocation)
+    {
+        const hub_subscription* subscription = nullptr;
+        const std::string* target = nullptr;
+        if (invocation.target_id != target_table::not_found)
+        {
+            subscription = &m_target_handlers[(size_t)invocation.target_id];
+            target = &m_targets.name(invocation.target_id);
+        }
+        else
+        {
+            // escaped target names are not resolved by the parser
+            auto event = m_subscriptions.find(invocation.target);
+            if (event != m_subscriptions.end())
+            {
+                subscription = &event->second;
+                target = &event->first;
+            }
+        }
+
+        if (subscription == nullptr)
+        {
+            if (m_logger.is_enabled(trace_level::info))
+            {
+                m_logger.log(trace_level::info, std::string("handler not found for target: ").append(invocation.target));
+            }
+            return;
+        }
+
+        if (subscription->raw_handler)
+        {
+            subscription->raw_handler(*target, invocation.arguments_view);
+        }
+        else
+        {
+            subscription->handler(invocation.arguments_view.decode_all());
+        }
+    }
+
     bool hub_connection_impl::invoke_callback(completion_message* completion)
     {
         const char* error = nullptr;
@@ -570,14 +760,41 @@ namespace signalr
 
     void hub_connection_impl::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
     {
-        const auto& callback_id = m_callback_manager.register_callback(
-            create_hub_invocation_callback(m_logger, [callback](const signalr::value& result) { callback(result, nullptr); },
-                [callback](const std::exception_ptr e) { callback(signalr::value(), e); }));
+        invoke(method_name, arguments, callback, m_signalr_client_config.get_invocation_timeout());
+    }
+
+    void hub_connection_impl::invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback,
+        std::chrono::milliseconds timeout) noexcept
+    {
+        std::string callback_id;
+        try
+        {
+            callback_id = register_invocation(callback, timeout);
+        }
+        catch (...)
+        {
+            callback(signalr::value(), std::current_exception());
+            return;
+        }
 
         invoke_hub_method(method_name, arguments, callback_id, nullptr,
             [callback](const std::exception_ptr e){ callback(signalr::value(), e); });
     }
 
+    std::string hub_connection_impl::register_invocation(std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout)
+    {
+        int64_t deadline = 0;
+        if (timeout > std::chrono::milliseconds::zero())
+        {
+            deadline = std::chrono::duration_cast<std::chrono::milliseconds>((std::chrono::steady_clock::now() + timeout).time_since_epoch()).count();
+        }
+
+        return m_callback_manager.register_callback(
+            create_hub_invocation_callback(m_logger, [callback](const signalr::value& result) { callback(result, nullptr); },
+                [callback](const std::exception_ptr e) { callback(signalr::value(), e); }),
+            nullptr, deadline);
+    }
+
     void hub_connection_impl::send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept
     {
         invoke_hub_method(method_name, arguments, "",
@@ -585,103 +802,717 @@ namespace signalr
             [callback](const std::exception_ptr e){ callback(e); });
     }
 
-    void hub_connection_impl::invoke_hub_method(const std::string& method_name, const std::vector<signalr::value>& arguments,
-        const std::string& callback_id, std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept
+    prepared_invocation hub_connection_impl::prepare(const std::string& method_name)
+    {
+        return prepared_invocation(shared_from_this(), std::make_shared<invocation_template>(method_name));
+    }
+
+    void hub_connection_impl::send_prepared(const std::shared_ptr<invocation_template>& prepared, const std::vector<signalr::value>& arguments,
+        std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        invoke_prepared_method(*prepared, arguments, "",
+            [callback]() { callback(nullptr); },
+            [callback](const std::exception_ptr e){ callback(e); });
+    }
+
+    void hub_connection_impl::invoke_prepared(const std::shared_ptr<invocation_template>& prepared, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
     {
-        m_logger.log(trace_level::info, std::string("invoke_hub_method: method=").append(method_name).append(", args_count=").append(std::to_string(arguments.size())));
+        std::string callback_id;
         try
         {
-            invocation_message invocation(callback_id, method_name, arguments);
-            m_logger.log(trace_level::info, "invoke_hub_method: calling write_message...");
-            auto message = m_protocol->write_message(&invocation);
-            m_logger.log(trace_level::info, std::string("invoke_hub_method: message serialized, length=").append(std::to_string(message.length())));
+            callback_id = register_invocation(callback, m_signalr_client_config.get_invocation_timeout());
+        }
+        catch (...)
+        {
+            callback(signalr::value(), std::current_exception());
+            return;
+        }
 
-            // weak_ptr prevents a circular dependency leading to memory leak and other problems
-            auto weak_hub_connection = std::weak_ptr<hub_connection_impl>(shared_from_this());
+        invoke_prepared_method(*prepared, arguments, callback_id, nullptr,
+            [callback](const std::exception_ptr e){ callback(signalr::value(), e); });
+    }
 
-            m_logger.log(trace_level::info, "invoke_hub_method: calling m_connection->send()...");
-            m_connection->send(message, m_protocol->transfer_format(), [set_completion, set_exception, weak_hub_connection, callback_id](std::exception_ptr exception)
+    stream_handle hub_connection_impl::stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept
+    {
+        auto buffer = stream_item_buffer::create(STREAM_BUFFER_CAPACITY, m_signalr_client_config.get_scheduler(), on_item, on_complete);
+
+        std::string callback_id;
+        try
+        {
+            callback_id = m_callback_manager.register_callback(
+                [buffer](const char* error, const signalr::value&)
                 {
-                    if (exception)
-                    {
-                        auto hub_connection = weak_hub_connection.lock();
-                        if (hub_connection)
-                        {
-                            hub_connection->m_callback_manager.remove_callback(callback_id);
-                        }
-                        set_exception(exception);
-                    }
-                    else
-                    {
-                        if (callback_id.empty())
-                        {
-                            // complete nonBlocking call
-                            set_completion();
-                        }
-                    }
+                    buffer->complete(error != nullptr ? std::make_exception_ptr(hub_exception(error)) : nullptr);
+                },
+                [buffer](signalr::value&& item)
+                {
+                    buffer->push(std::move(item));
                 });
-
-            reset_send_ping();
         }
-        catch (const std::exception& e)
+        catch (...)
         {
-            m_logger.log(trace_level::error, std::string("invoke_hub_method: EXCEPTION CAUGHT: ").append(e.what()));
-            m_callback_manager.remove_callback(callback_id);
-            if (m_logger.is_enabled(trace_level::warning))
-            {
-                m_logger.log(trace_level::warning, std::string("failed to send invocation: ").append(e.what()));
-            }
-            set_exception(std::current_exception());
+            on_complete(std::current_exception());
+            return stream_handle();
         }
-    }
 
-    connection_state hub_connection_impl::get_connection_state() const noexcept
-    {
-        return m_connection->get_connection_state();
-    }
+        std::weak_ptr<hub_connection_impl> weak_hub_connection = shared_from_this();
+        buffer->set_cancel_invocation([weak_hub_connection, callback_id]()
+            {
+                auto hub_connection = weak_hub_connection.lock();
+                if (hub_connection)
+                {
+                    hub_connection->send_cancel_invocation(callback_id);
+                }
+            });
 
-    std::string hub_connection_impl::get_connection_id() const
-    {
-        return m_connection->get_connection_id();
-    }
+        invoke_hub_method(method_name, arguments, callback_id, nullptr,
+            [buffer](const std::exception_ptr e){ buffer->complete(e); }, message_type::stream_invocation);
 
-    void hub_connection_impl::set_client_config(const signalr_client_config& config)
-    {
-        m_signalr_client_config = config;
-        m_connection->set_client_config(config);
+        return stream_handle(buffer);
     }
 
-    void hub_connection_impl::set_disconnected(const std::function<void(std::exception_ptr)>& disconnected)
+    stream_writer hub_connection_impl::send_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(std::exception_ptr)> callback) noexcept
     {
-        m_disconnected = disconnected;
+        std::shared_ptr<client_stream> stream;
+        try
+        {
+            stream = create_client_stream();
+        }
+        catch (...)
+        {
+            callback(std::current_exception());
+            return stream_writer();
+        }
+
+        invoke_hub_method(method_name, arguments, "",
+            [callback]() { callback(nullptr); },
+            [callback, stream](const std::exception_ptr e)
+            {
+                stream->close(e);
+                callback(e);
+            }, message_type::invocation, std::vector<std::string>{ stream->id() });
+
+        return stream_writer(stream);
     }
 
-    void hub_connection_impl::reset_send_ping()
+    stream_writer hub_connection_impl::invoke_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
     {
-        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_keepalive_interval()).time_since_epoch();
-        m_nextActivationSendPing.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
+        std::shared_ptr<client_stream> stream;
+        try
+        {
+            stream = create_client_stream();
+        }
+        catch (...)
+        {
+            callback(signalr::value(), std::current_exception());
+            return stream_writer();
+        }
+
+        auto set_exception = [callback, stream](const std::exception_ptr e)
+        {
+            stream->close(e);
+            callback(signalr::value(), e);
+        };
+
+        std::string callback_id;
+        try
+        {
+            callback_id = m_callback_manager.register_callback(
+                create_hub_invocation_callback(m_logger, [callback, stream](const signalr::value& result)
+                    {
+                        // anything still queued would be ignored by the server once the method has returned
+                        stream->close(std::make_exception_ptr(signalr_exception("the hub method returned before the stream was completed")));
+                        callback(result, nullptr);
+                    }, set_exception));
+        }
+        catch (...)
+        {
+            set_exception(std::current_exception());
+            return stream_writer();
+        }
+
+        invoke_hub_method(method_name, arguments, callback_id, nullptr, set_exception,
+            message_type::invocation, std::vector<std::string>{ stream->id() });
+
+        return stream_writer(stream);
     }
 
-    void hub_connection_impl::reset_server_timeout()
+    std::shared_ptr<client_stream> hub_connection_impl::create_client_stream()
     {
-        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_server_timeout()).time_since_epoch();
-        m_nextActivationServerTimeout.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
+        std::weak_ptr<hub_connection_impl> weak_hub_connection = shared_from_this();
+
+        // stream ids are tracked by the server separately from invocation ids
+        auto stream = client_stream::create(std::to_string(m_next_stream_id++), m_signalr_client_config.get_stream_upload_window(),
+            m_signalr_client_config.get_scheduler(),
+            [weak_hub_connection](const hub_message& message)
+            {
+                auto hub_connection = weak_hub_connection.lock();
+                if (!hub_connection)
+                {
+                    throw signalr_exception("the hub connection was destroyed before the stream was completed");
+                }
+                return hub_connection->m_protocol->write_message(&message);
+            },
+            [weak_hub_connection](const std::string& payload, std::function<void(std::exception_ptr)> callback)
+            {
+                auto hub_connection = weak_hub_connection.lock();
+                if (!hub_connection)
+                {
+                    callback(std::make_exception_ptr(signalr_exception("the hub connection was destroyed before the stream was completed")));
+                    return;
+                }
+                // items and the completion go through the same queues as the invocation that declares the stream, so they
+                // never reach the server ahead of it. A buffered item completes once it is sent, which holds the window
+                hub_connection->send_message(payload, callback, /* buffer_offline */ true);
+            });
+
+        std::lock_guard<std::mutex> lock(m_client_streams_lock);
+        m_client_streams.erase(std::remove_if(m_client_streams.begin(), m_client_streams.end(),
+            [](const std::weak_ptr<client_stream>& entry)
+            {
+                auto stream = entry.lock();
+                return !stream || !stream->is_open();
+            }), m_client_streams.end());
+        m_client_streams.push_back(stream);
+
+        return stream;
     }
 
-    void hub_connection_impl::start_keepalive()
+    void hub_connection_impl::close_client_streams(std::exception_ptr reason)
     {
-        m_logger.log(trace_level::info, "starting keep alive timer.");
+        std::vector<std::weak_ptr<client_stream>> streams;
 
-        auto send_ping = [](std::shared_ptr<hub_connection_impl> connection)
         {
-            if (!connection)
+            std::lock_guard<std::mutex> lock(m_client_streams_lock);
+            streams.swap(m_client_streams);
+        }
+
+        for (auto& entry : streams)
+        {
+            auto stream = entry.lock();
+            if (stream)
             {
-                return;
+                stream->close(reason);
             }
+        }
+    }
 
-            if (connection->get_connection_state() != connection_state::connected)
+    void hub_connection_impl::send_cancel_invocation(const std::string& invocation_id) noexcept
+    {
+        // stop tracking first, items and the completion the server already sent are dropped
+        m_callback_manager.remove_callback(invocation_id);
+
+        try
+        {
+            cancel_invocation_message cancel(invocation_id);
+            auto weak_hub_connection = std::weak_ptr<hub_connection_impl>(shared_from_this());
+            send_message(m_protocol->write_message(&cancel), [weak_hub_connection](std::exception_ptr exception)
+                {
+                    auto hub_connection = weak_hub_connection.lock();
+                    if (exception && hub_connection && hub_connection->m_logger.is_enabled(trace_level::warning))
+                    {
+                        hub_connection->m_logger.log(trace_level::warning, "failed to send stream cancellation");
+                    }
+                }, /* buffer_offline */ true);
+        }
+        catch (const std::exception& e)
+        {
+            if (m_logger.is_enabled(trace_level::warning))
             {
-                return;
+                m_logger.log(trace_level::warning, std::string("failed to send stream cancellation: ").append(e.what()));
+            }
+        }
+    }
+
+    void hub_connection_impl::invoke_hub_method(const std::string& method_name, const std::vector<signalr::value>& arguments,
+        const std::string& callback_id, std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception,
+        signalr::message_type invocation_type, const std::vector<std::string>& stream_ids) noexcept
+    {
+        try
+        {
+            invocation_message invocation(callback_id, method_name, arguments, stream_ids);
+            invocation.message_type = invocation_type;
+            auto message = m_protocol->write_message(&invocation);
+            if (m_logger.is_enabled(trace_level::debug))
+            {
+                m_logger.log(trace_level::debug, std::string("invoke_hub_method: method=").append(method_name)
+                    .append(", args_count=").append(std::to_string(arguments.size()))
+                    .append(", length=").append(std::to_string(message.length())));
+            }
+
+            send_invocation(message, callback_id, set_completion, set_exception);
+        }
+        catch (const std::exception& e)
+        {
+            m_logger.log(trace_level::error, std::string("invoke_hub_method: EXCEPTION CAUGHT: ").append(e.what()));
+            m_callback_manager.remove_callback(callback_id);
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to send invocation: ").append(e.what()));
+            }
+            set_exception(std::current_exception());
+        }
+    }
+
+    void hub_connection_impl::invoke_prepared_method(invocation_template& prepared, const std::vector<signalr::value>& arguments, const std::string& callback_id,
+        std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept
+    {
+        // the JSON layout of the template only applies to the JSON protocol
+        if (m_protocol->name() != "json")
+        {
+            invoke_hub_method(prepared.target(), arguments, callback_id, set_completion, set_exception);
+            return;
+        }
+
+        // sends are synchronous, so the buffer is free again once send_invocation returns. A call made from one of
+        // the completion callbacks, or from another task at the same time, serializes into its own string
+        std::string local_buffer;
+        auto buffer = prepared.acquire_buffer();
+        auto owns_buffer = buffer != nullptr;
+        if (!owns_buffer)
+        {
+            buffer = &local_buffer;
+        }
+
+        try
+        {
+            prepared.write(*buffer, arguments, callback_id);
+        }
+        catch (const std::exception& e)
+        {
+            if (owns_buffer)
+            {
+                prepared.release_buffer();
+            }
+            m_callback_manager.remove_callback(callback_id);
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to send invocation: ").append(e.what()));
+            }
+            set_exception(std::current_exception());
+            return;
+        }
+
+        send_invocation(*buffer, callback_id, set_completion, set_exception);
+
+        if (owns_buffer)
+        {
+            prepared.release_buffer();
+        }
+    }
+
+    void hub_connection_impl::send_invocation(const std::string& message, const std::string& callback_id,
+        std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept
+    {
+        try
+        {
+            // weak_ptr prevents a circular dependency leading to memory leak and other problems
+            auto weak_hub_connection = std::weak_ptr<hub_connection_impl>(shared_from_this());
+
+            send_message(message, [set_completion, set_exception, weak_hub_connection, callback_id](std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        auto hub_connection = weak_hub_connection.lock();
+                        if (hub_connection)
+                        {
+                            hub_connection->m_callback_manager.remove_callback(callback_id);
+                        }
+                        set_exception(exception);
+                    }
+                    else
+                    {
+                        if (callback_id.empty())
+                        {
+                            // complete nonBlocking call
+                            set_completion();
+                        }
+                    }
+                }, /* buffer_offline */ true);
+        }
+        catch (const std::exception& e)
+        {
+            m_logger.log(trace_level::error, std::string("send_invocation: EXCEPTION CAUGHT: ").append(e.what()));
+            m_callback_manager.remove_callback(callback_id);
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to send invocation: ").append(e.what()));
+            }
+            set_exception(std::current_exception());
+        }
+    }
+
+    void hub_connection_impl::cork() noexcept
+    {
+        m_batch.cork();
+    }
+
+    void hub_connection_impl::uncork(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::string payload;
+        message_batch::callback_list callbacks;
+        try
+        {
+            if (!m_batch.uncork(callback, payload, callbacks))
+            {
+                return;
+            }
+        }
+        catch (...)
+        {
+            callback(std::current_exception());
+            return;
+        }
+
+        send_batch(payload, std::move(callbacks));
+    }
+
+    void hub_connection_impl::send_message(const std::string& payload, std::function<void(std::exception_ptr)> callback, bool buffer_offline) noexcept
+    {
+        if (buffer_offline && (m_offline_buffer.offer(payload, callback, get_connection_state() == connection_state::connected)
+            || queue_until_handshake(payload, callback)))
+        {
+            return;
+        }
+
+        if (m_stateful_reconnect.load())
+        {
+            callback = track_for_replay(payload, std::move(callback));
+        }
+
+        std::string full_batch;
+        message_batch::callback_list full_batch_callbacks;
+        if (m_batch.append(payload, callback, full_batch, full_batch_callbacks))
+        {
+            callback = nullptr;
+        }
+
+        if (!full_batch.empty())
+        {
+            send_batch(full_batch, std::move(full_batch_callbacks));
+        }
+
+        if (callback)
+        {
+            m_connection->send(payload, m_protocol->transfer_format(), callback);
+            reset_send_ping();
+        }
+    }
+
+    void hub_connection_impl::flush_offline_buffer() noexcept
+    {
+        outbound_buffer::message_list messages;
+        while (m_offline_buffer.take(messages))
+        {
+            if (m_logger.is_enabled(trace_level::info))
+            {
+                m_logger.log(trace_level::info, std::string("sending ").append(std::to_string(messages.size()))
+                    .append(" message(s) buffered while disconnected"));
+            }
+
+            // corked so the backlog goes out in as few frames as possible
+            cork();
+            for (auto& message : messages)
+            {
+                send_message(message.first, message.second);
+            }
+            uncork([](std::exception_ptr) {});
+            messages.clear();
+        }
+    }
+
+    bool hub_connection_impl::queue_until_handshake(const std::string& payload, const std::function<void(std::exception_ptr)>& callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_handshake_queue_lock);
+            if (!m_handshake_pending)
+            {
+                return false;
+            }
+
+            if (m_handshake_queue.size() < HANDSHAKE_QUEUE_SIZE)
+            {
+                m_handshake_queue.push_back(std::make_pair(payload, callback));
+                return true;
+            }
+        }
+
+        callback(std::make_exception_ptr(signalr_exception("too many messages were sent before the handshake completed")));
+        return true;
+    }
+
+    void hub_connection_impl::flush_handshake_queue() noexcept
+    {
+        // the queue stays open while it is flushed, so sends racing the flush line up behind it instead of overtaking it
+        outbound_buffer::message_list messages;
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_handshake_queue_lock);
+                if (m_handshake_queue.empty())
+                {
+                    m_handshake_pending = false;
+                    return;
+                }
+                messages.swap(m_handshake_queue);
+            }
+
+            if (m_logger.is_enabled(trace_level::info))
+            {
+                m_logger.log(trace_level::info, std::string("sending ").append(std::to_string(messages.size()))
+                    .append(" message(s) queued during the handshake"));
+            }
+
+            cork();
+            for (auto& message : messages)
+            {
+                send_message(message.first, message.second);
+            }
+            uncork([](std::exception_ptr) {});
+            messages.clear();
+        }
+    }
+
+    void hub_connection_impl::fail_handshake_queue(std::exception_ptr reason) noexcept
+    {
+        outbound_buffer::message_list messages;
+        {
+            std::lock_guard<std::mutex> lock(m_handshake_queue_lock);
+            m_handshake_pending = false;
+            messages.swap(m_handshake_queue);
+        }
+
+        for (auto& message : messages)
+        {
+            message.second(reason);
+        }
+    }
+
+    void hub_connection_impl::send_batch(const std::string& payload, std::vector<std::function<void(std::exception_ptr)>>&& callbacks) noexcept
+    {
+        if (payload.empty())
+        {
+            for (auto& callback : callbacks)
+            {
+                callback(nullptr);
+            }
+            return;
+        }
+
+        if (m_logger.is_enabled(trace_level::debug))
+        {
+            m_logger.log(trace_level::debug, std::string("sending ").append(std::to_string(payload.size()))
+                .append(" bytes of batched messages"));
+        }
+
+        auto batch_callbacks = std::make_shared<std::vector<std::function<void(std::exception_ptr)>>>(std::move(callbacks));
+        m_connection->send(payload, m_protocol->transfer_format(), [batch_callbacks](std::exception_ptr exception)
+            {
+                for (auto& callback : *batch_callbacks)
+                {
+                    callback(exception);
+                }
+            });
+        reset_send_ping();
+    }
+
+    std::function<void(std::exception_ptr)> hub_connection_impl::track_for_replay(const std::string& payload,
+        std::function<void(std::exception_ptr)> callback)
+    {
+        // recorded on completion rather than up front, a message the transport refused never reached the server's count
+        std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+        return [weak_connection, payload, callback](std::exception_ptr exception)
+        {
+            if (exception == nullptr)
+            {
+                auto connection = weak_connection.lock();
+                if (connection)
+                {
+                    connection->m_replay_buffer.add(payload);
+                }
+            }
+            callback(exception);
+        };
+    }
+
+    void hub_connection_impl::send_ack() noexcept
+    {
+        auto processed = m_processed_sequence_id.load();
+        if (processed <= m_acked_sequence_id.load())
+        {
+            return;
+        }
+
+        try
+        {
+            ack_message ack(processed);
+            std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+            m_connection->send(m_protocol->write_message(&ack), m_protocol->transfer_format(),
+                [weak_connection, processed](std::exception_ptr exception)
+                {
+                    auto connection = weak_connection.lock();
+                    if (connection && exception == nullptr)
+                    {
+                        // acks are cumulative, a failed one is covered by the next
+                        connection->m_acked_sequence_id.store(processed);
+                    }
+                });
+        }
+        catch (const std::exception& e)
+        {
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to send ack: ").append(e.what()));
+            }
+        }
+    }
+
+    void hub_connection_impl::replay_unacknowledged() noexcept
+    {
+        int64_t first_sequence_id = 0;
+        auto messages = m_replay_buffer.pending(first_sequence_id);
+
+        if (m_logger.is_enabled(trace_level::info))
+        {
+            m_logger.log(trace_level::info, std::string("resumed, replaying ").append(std::to_string(messages.size()))
+                .append(" unacknowledged message(s) from sequence id ").append(std::to_string(first_sequence_id)));
+        }
+
+        auto logger = m_logger;
+        auto on_sent = [logger](std::exception_ptr exception)
+        {
+            if (exception != nullptr && logger.is_enabled(trace_level::warning))
+            {
+                logger.log(trace_level::warning, "failed to replay unacknowledged messages");
+            }
+        };
+
+        try
+        {
+            // the sequence message tells the server which id the replayed messages start at, it drops the ones it already has
+            sequence_message sequence(first_sequence_id);
+            std::string frame = m_protocol->write_message(&sequence);
+            for (auto& message : messages)
+            {
+                if (frame.size() + message.size() > MAX_BATCH_SIZE)
+                {
+                    m_connection->send(frame, m_protocol->transfer_format(), on_sent);
+                    frame.clear();
+                }
+                frame.append(message);
+            }
+            m_connection->send(frame, m_protocol->transfer_format(), on_sent);
+            reset_send_ping();
+        }
+        catch (const std::exception& e)
+        {
+            if (m_logger.is_enabled(trace_level::warning))
+            {
+                m_logger.log(trace_level::warning, std::string("failed to replay unacknowledged messages: ").append(e.what()));
+            }
+        }
+    }
+
+    connection_state hub_connection_impl::get_connection_state() const noexcept
+    {
+        return m_connection->get_connection_state();
+    }
+
+    std::string hub_connection_impl::get_connection_id() const
+    {
+        return m_connection->get_connection_id();
+    }
+
+    size_t hub_connection_impl::get_timed_out_invocation_count() const
+    {
+        return m_callback_manager.timed_out();
+    }
+
+    offline_buffer_stats hub_connection_impl::get_offline_buffer_stats() const
+    {
+        return m_offline_buffer.stats();
+    }
+
+    connect_trace hub_connection_impl::get_last_connect_trace() const
+    {
+        return m_connection->get_connect_trace().last();
+    }
+
+    connect_trace_stats hub_connection_impl::get_connect_trace_stats() const
+    {
+        return m_connection->get_connect_trace().stats();
+    }
+
+    void hub_connection_impl::complete_connect_trace()
+    {
+        auto& recorder = m_connection->get_connect_trace();
+        recorder.mark(connect_trace_recorder::phase::handshake_acked);
+        recorder.finish(true);
+        m_awaiting_first_message = true;
+
+        if (m_logger.is_enabled(trace_level::info))
+        {
+            auto trace = recorder.last();
+            m_logger.log(trace_level::info, std::string("connected in ").append(std::to_string(trace.handshake_acked_ms))
+                .append(" ms: negotiate done at ").append(std::to_string(trace.negotiate_completed_ms))
+                .append(" (").append(std::to_string(trace.negotiate_requests)).append(" request(s)), websocket ")
+                .append(std::to_string(trace.websocket_started_ms)).append("->").append(std::to_string(trace.websocket_connected_ms))
+                .append(", handshake ").append(std::to_string(trace.handshake_sent_ms)).append("->")
+                .append(std::to_string(trace.handshake_acked_ms)));
+        }
+    }
+
+    void hub_connection_impl::set_network_available(bool available) noexcept
+    {
+        if (m_network_available.exchange(available) != available && m_logger.is_enabled(trace_level::info))
+        {
+            m_logger.log(trace_level::info, available ? "network reported available" : "network reported unavailable");
+        }
+    }
+
+    void hub_connection_impl::set_client_config(const signalr_client_config& config)
+    {
+        m_signalr_client_config = config;
+        m_connection->set_client_config(config);
+        m_offline_buffer.configure(config.get_offline_buffer_max_messages(), config.get_offline_buffer_max_bytes(),
+            config.get_offline_buffer_policy());
+    }
+
+    void hub_connection_impl::set_disconnected(const std::function<void(std::exception_ptr)>& disconnected)
+    {
+        m_disconnected = disconnected;
+    }
+
+    void hub_connection_impl::reset_send_ping()
+    {
+        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_keepalive_interval()).time_since_epoch();
+        m_nextActivationSendPing.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
+    }
+
+    void hub_connection_impl::reset_server_timeout()
+    {
+        auto timeMs = (std::chrono::steady_clock::now() + m_signalr_client_config.get_server_timeout()).time_since_epoch();
+        m_nextActivationServerTimeout.store(std::chrono::duration_cast<std::chrono::milliseconds>(timeMs).count());
+    }
+
+    void hub_connection_impl::start_keepalive()
+    {
+        m_logger.log(trace_level::info, "starting keep alive timer.");
+
+        auto send_ping = [](std::shared_ptr<hub_connection_impl> connection)
+        {
+            if (!connection)
+            {
+                return;
+            }
+
+            if (connection->get_connection_state() != connection_state::connected)
+            {
+                return;
             }
 
             try
@@ -720,9 +1551,10 @@ namespace signalr
         send_ping(shared_from_this());
         reset_server_timeout();
 
+        auto generation = ++m_keepalive_generation;
         std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
         timer(m_signalr_client_config.get_scheduler(),
-            [send_ping, weak_connection](std::chrono::milliseconds)
+            [send_ping, weak_connection, generation](std::chrono::milliseconds)
             {
                 auto connection = weak_connection.lock();
 
@@ -731,7 +1563,8 @@ namespace signalr
                     return true;
                 }
 
-                if (connection->get_connection_state() != connection_state::connected)
+                if (connection->get_connection_state() != connection_state::connected ||
+                    connection->m_keepalive_generation.load() != generation)
                 {
                     return true;
                 }
@@ -757,6 +1590,17 @@ namespace signalr
                     }
                 }
 
+                auto expired = connection->m_callback_manager.expire(timeNowmSeconds, "invocation timed out waiting for a completion from the server");
+                if (expired > 0 && connection->m_logger.is_enabled(trace_level::warning))
+                {
+                    connection->m_logger.log(trace_level::warning, std::to_string(expired).append(" invocation(s) timed out"));
+                }
+
+                if (connection->m_stateful_reconnect.load())
+                {
+                    connection->send_ack();
+                }
+
                 if (timeNowmSeconds > connection->m_nextActivationSendPing.load())
                 {
                     connection->m_logger.log(trace_level::info, "sending ping to server.");
@@ -790,7 +1634,7 @@ namespace signalr
         }
     }
 
-    void hub_connection_impl::handle_disconnection(std::exception_ptr exception)
+    void hub_connection_impl::handle_disconnection(std::exception_ptr exception, bool allow_resume)
     {
         // Log disconnection handling - this is a normal flow when connection drops
         ESP_LOGI("HUB_CONN", ">>> handle_disconnection CALLED <<<");
@@ -798,6 +1642,30 @@ namespace signalr
         
         // start may be waiting on the handshake response so we complete it here, this no-ops if already set
         m_handshakeTask->set(std::make_exception_ptr(signalr_exception("connection closed while handshake was in progress.")));
+
+        // a dropped stateful reconnect connection is resumed first. Pending invocations and streams stay as they are and
+        // the disconnected callback only runs if the resume does not work out
+        if (allow_resume && exception != nullptr && m_stateful_reconnect.load() && m_replay_buffer.complete())
+        {
+            bool resume = false;
+            {
+                std::lock_guard<std::mutex> lock(m_reconnect_lock);
+                if (!m_reconnecting.load())
+                {
+                    m_reconnecting.store(true);
+                    m_resuming.store(true);
+                    resume = true;
+                }
+            }
+
+            if (resume)
+            {
+                m_logger.log(trace_level::info, "connection lost, resuming it with stateful reconnect");
+                m_reconnect_cts = std::make_shared<cancellation_token_source>();
+                queue_reconnect(0, m_reconnect_cts, std::chrono::milliseconds(0));
+                return;
+            }
+        }
         
         try
         {
@@ -813,6 +1681,7 @@ namespace signalr
         }
 
         m_callback_manager.clear("connection was stopped before invocation result was received");
+        close_client_streams(std::make_exception_ptr(signalr_exception("connection was stopped before the stream was completed")));
 
         // Check if we should attempt to reconnect
         bool should_reconnect = false;
@@ -885,28 +1754,34 @@ namespace signalr
         }
     }
 
-    // Task function for reconnection - runs in its own task with dedicated stack
+    namespace
+    {
+        // how often a connection waiting for the network checks whether it is back
+        constexpr std::chrono::milliseconds NETWORK_POLL_INTERVAL(100);
+
+        // how long to wait before checking again on a start that outlived its attempt
+        constexpr std::chrono::milliseconds START_IN_PROGRESS_POLL_INTERVAL(1000);
+
+        // how long a reconnect attempt waits for start() or resume() to complete
+        constexpr std::chrono::milliseconds RECONNECT_ATTEMPT_TIMEOUT(60000);
+    }
+
+    // One reconnect attempt - runs on the reconnect worker, which has a stack large enough for start()
     // This is a friend function declared in hub_connection_impl.h
-    void reconnect_task_function(void* param)
+    void run_reconnect_attempt(void* param)
     {
-        // Take ownership of the parameters
-        auto* params = static_cast<reconnect_task_params*>(param);
+        // Take ownership of the parameters, they are handed back to the worker while waiting
+        std::unique_ptr<reconnect_task_params> params(static_cast<reconnect_task_params*>(param));
         std::weak_ptr<hub_connection_impl> weak_connection = params->weak_connection;
         int attempt = params->attempt;
         auto reconnect_cts = params->reconnect_cts;
-        delete params;  // Free the parameter struct
 
-        // Stack monitoring - CRITICAL for debugging stack overflow
-        UBaseType_t stack_start = uxTaskGetStackHighWaterMark(NULL);
-        uint32_t stack_allocated = get_reconnect_stack_size();
-        ESP_LOGI("HUB_CONN", "reconnect_task: started for attempt %d (stack: %u allocated, %u free)", 
-                 attempt, stack_allocated, stack_start * sizeof(StackType_t));
+        ESP_LOGI("HUB_CONN", "reconnect_task: started for attempt %d", attempt);
 
         // Check if reconnection was cancelled
         if (reconnect_cts->is_canceled())
         {
             ESP_LOGW("HUB_CONN", "reconnect_task: cancelled before start");
-            vTaskDelete(NULL);
             return;
         }
 
@@ -914,7 +1789,28 @@ namespace signalr
         if (!connection)
         {
             ESP_LOGW("HUB_CONN", "reconnect_task: connection destroyed");
-            vTaskDelete(NULL);
+            return;
+        }
+
+        // the delay is spent on a timer rather than in whoever asked for the reconnect, which may be the websocket task,
+        // or on the worker, which would hold up the attempts of other connections.
+        // While the application reports the network down nothing is tried and the delay only starts once it is back,
+        // so devices that lost the same access point don't all come back at the same moment
+        std::chrono::milliseconds wait(0);
+        if (!connection->m_network_available.load())
+        {
+            params->delayed = false;
+            wait = NETWORK_POLL_INTERVAL;
+        }
+        else if (!params->delayed && params->delay.count() > 0)
+        {
+            params->delayed = true;
+            wait = params->delay;
+        }
+
+        if (wait.count() > 0)
+        {
+            connection->requeue_reconnect(std::move(params), wait);
             return;
         }
 
@@ -922,43 +1818,125 @@ namespace signalr
         auto current_state = connection->get_connection_state();
         ESP_LOGI("HUB_CONN", "reconnect_task: attempt %d, current state=%d", attempt, (int)current_state);
 
+        bool resuming = connection->m_resuming.load();
+
         if (current_state != connection_state::disconnected)
         {
             ESP_LOGW("HUB_CONN", "reconnect_task: not in disconnected state (%d), aborting", (int)current_state);
-            vTaskDelete(NULL);
+            if (resuming)
+            {
+                connection->abandon_resume(std::make_exception_ptr(signalr_exception("the connection was not disconnected when resuming it")));
+            }
+            else if (current_state == connection_state::connected)
+            {
+                // a start that outlived an earlier attempt got through after all
+                std::lock_guard<std::mutex> lock(connection->m_reconnect_lock);
+                connection->m_reconnecting.store(false);
+                connection->m_reconnect_attempts.store(0);
+            }
+            else
+            {
+                // such a start is still running, look again once it has had time to finish
+                connection->requeue_reconnect(std::move(params), START_IN_PROGRESS_POLL_INTERVAL);
+            }
             return;
         }
 
-        // Use a semaphore to wait for start() to complete
-        SemaphoreHandle_t done_sem = xSemaphoreCreateBinary();
-        std::exception_ptr start_exception_result = nullptr;
-
         connection->m_logger.log(trace_level::info,
             std::string("starting reconnect attempt ").append(std::to_string(attempt)));
 
-        // Call start() - this is safe now because we're in our own task with enough stack
-        connection->start([done_sem, &start_exception_result](std::exception_ptr start_exception)
+        // start() completes on another task. The worker does not wait for it, the completion queues the rest of the
+        // attempt and a timer gives up on it after 60 seconds, whichever comes first
+        params->settled = std::make_shared<std::atomic<bool>>(false);
+        params->resuming = resuming;
+
+        auto timeout = std::unique_ptr<reconnect_task_params>(new reconnect_task_params(*params));
+        auto completion = std::make_shared<reconnect_task_params>(*params);
+        if (!reconnect_worker::post_after(pdMS_TO_TICKS(RECONNECT_ATTEMPT_TIMEOUT.count()), reconnect_attempt_timed_out,
+            timeout.get(), reconnect_job_dropped))
         {
-            start_exception_result = start_exception;
-            xSemaphoreGive(done_sem);
-        });
+            connection->fail_reconnect_queue(attempt);
+            return;
+        }
+        timeout.release();
 
-        // Wait for start() to complete (with 60 second timeout)
-        if (xSemaphoreTake(done_sem, pdMS_TO_TICKS(60000)) != pdTRUE)
+        auto on_started = [completion](std::exception_ptr exception)
+            {
+                if (completion->settled->exchange(true))
+                {
+                    // timed out already
+                    return;
+                }
+
+                auto connection = completion->weak_connection.lock();
+                if (!connection)
+                {
+                    return;
+                }
+
+                std::unique_ptr<reconnect_task_params> params(new reconnect_task_params(*completion));
+                params->exception = exception;
+                connection->requeue_reconnect(std::move(params), std::chrono::milliseconds(0), finish_reconnect_attempt);
+            };
+
+        if (resuming)
+        {
+            connection->resume(on_started);
+        }
+        else
+        {
+            connection->start(on_started);
+        }
+    }
+
+    // Gives up on an attempt whose start() did not complete in time - runs on the reconnect worker
+    void reconnect_attempt_timed_out(void* param)
+    {
+        std::unique_ptr<reconnect_task_params> params(static_cast<reconnect_task_params*>(param));
+        if (params->settled->exchange(true))
         {
-            ESP_LOGE("HUB_CONN", "reconnect_task: timeout waiting for start()");
-            vSemaphoreDelete(done_sem);
-            vTaskDelete(NULL);
             return;
         }
-        vSemaphoreDelete(done_sem);
+
+        ESP_LOGE("HUB_CONN", "reconnect_task: timeout waiting for start()");
+        // counts as a failed attempt, so the next one is scheduled or the reconnect gives up
+        params->exception = std::make_exception_ptr(signalr_exception(params->resuming
+            ? "timed out resuming the connection" : "timed out waiting for the connection to start"));
+        finish_reconnect_attempt(params.release());
+    }
+
+    // The outcome of one reconnect attempt - runs on the reconnect worker
+    void finish_reconnect_attempt(void* param)
+    {
+        std::unique_ptr<reconnect_task_params> params(static_cast<reconnect_task_params*>(param));
+        int attempt = params->attempt;
+        auto start_exception_result = params->exception;
 
         // Re-acquire connection (it may have been destroyed during start)
-        connection = weak_connection.lock();
+        auto connection = params->weak_connection.lock();
         if (!connection)
         {
             ESP_LOGW("HUB_CONN", "reconnect_task: connection destroyed after start");
-            vTaskDelete(NULL);
+            return;
+        }
+
+        if (params->resuming)
+        {
+            if (start_exception_result)
+            {
+                ESP_LOGW("HUB_CONN", "resume failed, falling back to a new connection");
+                // after stop() the token is canceled and stop already ran the cleanup
+                connection->abandon_resume(params->reconnect_cts->is_canceled() ? nullptr : start_exception_result);
+            }
+            else
+            {
+                ESP_LOGI("HUB_CONN", "connection resumed");
+                connection->m_logger.log(trace_level::info, "connection resumed");
+                std::lock_guard<std::mutex> lock(connection->m_reconnect_lock);
+                connection->m_resuming.store(false);
+                connection->m_reconnecting.store(false);
+            }
+
             return;
         }
 
@@ -990,7 +1968,7 @@ namespace signalr
             if (should_retry)
             {
                 ESP_LOGI("HUB_CONN", "reconnect: will retry (attempt %d)", attempt + 1);
-                // Try again - this will create a new task
+                // Try again - this queues the next attempt on the worker
                 connection->attempt_reconnect();
             }
             else
@@ -1001,6 +1979,8 @@ namespace signalr
                     "reconnect failed: maximum retry attempts reached");
                 connection->m_reconnecting.store(false);
                 connection->m_reconnect_attempts.store(0);
+                connection->m_offline_buffer.fail_all(std::make_exception_ptr(
+                    signalr_exception("reconnect failed before the buffered message was sent")));
             }
         }
         else
@@ -1020,7 +2000,6 @@ namespace signalr
         }
 
         ESP_LOGI("HUB_CONN", "reconnect_task: exiting");
-        vTaskDelete(NULL);
     }
 
     void hub_connection_impl::attempt_reconnect()
@@ -1038,60 +2017,133 @@ namespace signalr
 
         // Create a new cancellation token for this reconnect attempt
         m_reconnect_cts = std::make_shared<cancellation_token_source>();
-        auto reconnect_cts = m_reconnect_cts;
+        queue_reconnect(attempt, m_reconnect_cts, delay);
+    }
+
+    void hub_connection_impl::queue_reconnect(int attempt, std::shared_ptr<cancellation_token_source> reconnect_cts,
+        std::chrono::milliseconds delay)
+    {
         std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
 
-        // Wait for the delay before starting reconnection
-        if (delay.count() > 0)
+        // Create parameters for the reconnect attempt, the worker takes ownership
+        std::unique_ptr<reconnect_task_params> params(new reconnect_task_params{weak_connection, attempt, reconnect_cts, delay, false});
+        requeue_reconnect(std::move(params), std::chrono::milliseconds(0));
+    }
+
+    void hub_connection_impl::requeue_reconnect(std::unique_ptr<reconnect_task_params> params, std::chrono::milliseconds wait,
+        void (*job)(void* param))
+    {
+        if (reconnect_worker::post_after(pdMS_TO_TICKS(wait.count()), job, params.get(), reconnect_job_dropped))
         {
-            vTaskDelay(pdMS_TO_TICKS(delay.count()));
+            params.release();
+            return;
         }
 
-        // Check if cancelled during delay
-        if (reconnect_cts->is_canceled())
+        fail_reconnect_queue(params->attempt);
+    }
+
+    void hub_connection_impl::fail_reconnect_queue(int attempt)
+    {
+        ESP_LOGE("HUB_CONN", "Failed to queue reconnect attempt %d!", attempt);
+        m_reconnecting.store(false);
+        m_reconnect_attempts.store(0);
+        abandon_resume(std::make_exception_ptr(signalr_exception("failed to queue resuming the connection")));
+    }
+
+    // A reconnect job the worker could not take in time - runs on the timer service task, so the cleanup goes to the
+    // scheduler
+    void reconnect_job_dropped(void* param)
+    {
+        std::unique_ptr<reconnect_task_params> params(static_cast<reconnect_task_params*>(param));
+
+        // only delayed jobs are dropped, a dropped timeout is moot once start() completed
+        if (params->settled && params->settled->exchange(true))
         {
-            ESP_LOGW("HUB_CONN", "attempt_reconnect: cancelled during delay");
             return;
         }
 
-        // Create parameters for the reconnect task
-        auto* params = new reconnect_task_params{weak_connection, attempt, reconnect_cts};
+        auto connection = params->weak_connection.lock();
+        if (!connection)
+        {
+            return;
+        }
 
-        // OPTIMIZED: Use dynamic stack size based on PSRAM availability
-        // CRITICAL: Must be at least 12KB for the deep call chain in start()
-        uint32_t reconnect_stack = get_reconnect_stack_size();
-        
-        ESP_LOGI("HUB_CONN", "Creating reconnect task with %u byte stack (PSRAM: %s)", 
-                 reconnect_stack, 
-                 signalr::memory::is_psram_available() ? "yes" : "no");
-        
-        // Create a dedicated task for reconnection with sufficient stack
-        BaseType_t result = xTaskCreate(
-            reconnect_task_function,
-            "signalr_reconn",
-            reconnect_stack,
-            params,
-            5,     // Same priority as other SignalR tasks
-            NULL
-        );
-
-        if (result != pdPASS)
-        {
-            ESP_LOGE("HUB_CONN", "Failed to create reconnect task (stack=%u)!", reconnect_stack);
-            delete params;
-            m_reconnecting.store(false);
-            m_reconnect_attempts.store(0);
+        std::weak_ptr<hub_connection_impl> weak_connection = params->weak_connection;
+        int attempt = params->attempt;
+        connection->m_signalr_client_config.get_scheduler()->schedule([weak_connection, attempt]()
+            {
+                auto connection = weak_connection.lock();
+                if (connection)
+                {
+                    connection->fail_reconnect_queue(attempt);
+                }
+            });
+    }
+
+    void hub_connection_impl::resume(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::weak_ptr<hub_connection_impl> weak_connection = shared_from_this();
+        m_connection->get_connect_trace().begin(true);
+        m_connection->resume([weak_connection, callback](std::exception_ptr exception)
+            {
+                auto connection = weak_connection.lock();
+                if (!connection)
+                {
+                    callback(std::make_exception_ptr(signalr_exception("the hub connection has been deconstructed")));
+                    return;
+                }
+
+                connection->m_connection->get_connect_trace().finish(exception == nullptr);
+
+                // no handshake on a resumed connection, the server picks up where it left off; messages sent
+                // while it was down follow the replay, as on a handshake
+                if (exception == nullptr)
+                {
+                    connection->replay_unacknowledged();
+                    connection->flush_offline_buffer();
+                    connection->start_keepalive();
+                }
+                callback(exception);
+            });
+    }
+
+    void hub_connection_impl::abandon_resume(std::exception_ptr exception)
+    {
+        if (!m_resuming.exchange(false))
+        {
+            return;
         }
-        else
+
         {
-            ESP_LOGD("HUB_CONN", "Created reconnect task with %u byte stack", reconnect_stack);
+            std::lock_guard<std::mutex> lock(m_reconnect_lock);
+            m_reconnecting.store(false);
         }
+
+        m_logger.log(trace_level::info, "the connection could not be resumed");
+        handle_disconnection(exception, false);
     }
 
     std::chrono::milliseconds hub_connection_impl::get_next_reconnect_delay()
     {
-        const auto& delays = m_signalr_client_config.get_reconnect_delays();
         int attempt = m_reconnect_attempts.load();
+        if (attempt == 0)
+        {
+            m_last_reconnect_delay = std::chrono::milliseconds(0);
+        }
+
+        auto policy = m_signalr_client_config.get_reconnect_policy();
+        if (policy)
+        {
+            reconnect_context context;
+            context.previous_attempts = attempt;
+            context.previous_delay = m_last_reconnect_delay;
+
+            auto delay = std::max(policy->next_delay(context), std::chrono::milliseconds(0));
+            m_last_reconnect_delay = delay;
+            return delay;
+        }
+
+        const auto& delays = m_signalr_client_config.get_reconnect_delays();
         
         if (delays.empty())
         {
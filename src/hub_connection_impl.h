@@ -11,16 +11,29 @@
 #include "completion_event.h"
 #include "signalr_value.h"
 #include "hub_protocol.h"
+#include "target_table.h"
 #include "logger.h"
 #include "cancellation_token_source.h"
 #include "connection_impl.h"
+#include "memory_utils.h"
+#include "stream_handle.h"
+#include "stream_writer.h"
+#include "prepared_invocation.h"
+#include "client_stream.h"
+#include "invocation_template.h"
+#include "message_batch.h"
+#include "outbound_buffer.h"
+#include "replay_buffer.h"
 
 namespace signalr
 {
-    // Forward declaration for reconnect task
+    // Forward declaration for the reconnect worker jobs
     class hub_connection_impl;
     struct reconnect_task_params;
-    void reconnect_task_function(void* param);
+    void run_reconnect_attempt(void* param);
+    void finish_reconnect_attempt(void* param);
+    void reconnect_attempt_timed_out(void* param);
+    void reconnect_job_dropped(void* param);
     class websocket_client;
 
     // Note:
@@ -33,12 +46,29 @@ namespace signalr
         std::weak_ptr<hub_connection_impl> weak_connection;
         int attempt;
         std::shared_ptr<cancellation_token_source> reconnect_cts;
+        std::chrono::milliseconds delay;
+        // set once the delay has passed with the network available
+        bool delayed;
+        // of a started attempt: set by its completion or its timeout, whichever comes first finishes the attempt
+        std::shared_ptr<std::atomic<bool>> settled;
+        bool resuming;
+        std::exception_ptr exception;
+    };
+
+    // A target is handled either with decoded arguments or with the raw argument view, never both
+    struct hub_subscription
+    {
+        std::function<void(const std::vector<signalr::value>&)> handler;
+        std::function<void(const std::string&, const signalr::raw_arguments&)> raw_handler;
     };
 
     class hub_connection_impl : public std::enable_shared_from_this<hub_connection_impl>
     {
-        // Allow reconnect_task_function to access private members
-        friend void reconnect_task_function(void* param);
+        // Allow the reconnect jobs to access private members
+        friend void run_reconnect_attempt(void* param);
+        friend void finish_reconnect_attempt(void* param);
+        friend void reconnect_attempt_timed_out(void* param);
+        friend void reconnect_job_dropped(void* param);
 
     public:
         static std::shared_ptr<hub_connection_impl> create(const std::string& url, std::unique_ptr<hub_protocol>&& hub_protocol,
@@ -49,15 +79,36 @@ namespace signalr
         hub_connection_impl& operator=(const hub_connection_impl&) = delete;
 
         void on(const std::string& event_name, const std::function<void(const std::vector<signalr::value>&)>& handler);
+        void on_raw(const std::string& event_name, const std::function<void(const std::string&, const signalr::raw_arguments&)>& handler);
 
         void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept;
+        void invoke(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback,
+            std::chrono::milliseconds timeout) noexcept;
         void send(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept;
+        stream_handle stream(const std::string& method_name, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&)> on_item, std::function<void(std::exception_ptr)> on_complete) noexcept;
+        stream_writer send_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept;
+        stream_writer invoke_with_stream(const std::string& method_name, const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept;
+
+        prepared_invocation prepare(const std::string& method_name);
+        void send_prepared(const std::shared_ptr<invocation_template>& prepared, const std::vector<signalr::value>& arguments,
+            std::function<void(std::exception_ptr)> callback) noexcept;
+        void invoke_prepared(const std::shared_ptr<invocation_template>& prepared, const std::vector<signalr::value>& arguments,
+            std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept;
+
+        void cork() noexcept;
+        void uncork(std::function<void(std::exception_ptr)> callback) noexcept;
 
         void start(std::function<void(std::exception_ptr)> callback) noexcept;
         void stop(std::function<void(std::exception_ptr)> callback, bool is_dtor = false) noexcept;
 
         connection_state get_connection_state() const noexcept;
         std::string get_connection_id() const;
+        size_t get_timed_out_invocation_count() const;
+        offline_buffer_stats get_offline_buffer_stats() const;
+        connect_trace get_last_connect_trace() const;
+        connect_trace_stats get_connect_trace_stats() const;
+        void set_network_available(bool available) noexcept;
 
         void set_client_config(const signalr_client_config& config);
         void set_disconnected(const std::function<void(std::exception_ptr)>& disconnected);
@@ -71,7 +122,12 @@ namespace signalr
         std::shared_ptr<connection_impl> m_connection;
         logger m_logger;
         callback_manager m_callback_manager;
-        std::unordered_map<std::string, std::function<void(const std::vector<signalr::value>&)>, case_insensitive_hash, case_insensitive_equals> m_subscriptions;
+        std::unordered_map<std::string, hub_subscription, case_insensitive_hash, case_insensitive_equals> m_subscriptions;
+        // compiled from m_subscriptions on start, indexes of m_targets match m_target_handlers
+        target_table m_targets;
+        std::vector<hub_subscription> m_target_handlers;
+        // backs the message objects of one received frame, only used by the task that runs process_message
+        memory::message_arena m_message_arena;
         bool m_handshakeReceived;
         std::shared_ptr<completion_event> m_handshakeTask;
         std::function<void(std::exception_ptr)> m_disconnected;
@@ -83,22 +139,87 @@ namespace signalr
         std::atomic<int64_t> m_nextActivationServerTimeout;
         std::atomic<int64_t> m_nextActivationSendPing;
 
+        // client-to-server streams that are still open, closed when the connection goes away
+        std::atomic<uint32_t> m_next_stream_id;
+        std::mutex m_client_streams_lock;
+        std::vector<std::weak_ptr<client_stream>> m_client_streams;
+
+        // messages sent between cork() and the outermost uncork(), flushed as one frame
+        message_batch m_batch;
+
+        // invocations made while disconnected, flushed after the next handshake
+        outbound_buffer m_offline_buffer;
+
+        // sends made between start() and the handshake response that the offline buffer did not take, sent right
+        // after the handshake instead of racing it on the wire
+        std::mutex m_handshake_queue_lock;
+        bool m_handshake_pending;
+        // set by the handshake response so the first message after it ends the connect trace of that attempt
+        std::atomic<bool> m_awaiting_first_message;
+        outbound_buffer::message_list m_handshake_queue;
+
+        // stateful reconnect, set from the negotiate response when the handshake is sent. Sequenced messages are
+        // counted in both directions: sent ones are kept in m_replay_buffer until the server acks them, received
+        // ones are acked from the keepalive timer and skipped when the server replays them after a resume
+        std::atomic<bool> m_stateful_reconnect;
+        replay_buffer m_replay_buffer;
+        // only touched by the task that runs process_message
+        int64_t m_received_sequence_id;
+        std::atomic<int64_t> m_processed_sequence_id;
+        std::atomic<int64_t> m_acked_sequence_id;
+        // set while the reconnect task resumes the transport, the invocations and streams are kept alive meanwhile
+        std::atomic<bool> m_resuming;
+        // bumped by start_keepalive so the timer of a previous transport stops even if it never saw it disconnect
+        std::atomic<uint32_t> m_keepalive_generation;
+
         std::mutex m_stop_callback_lock;
         std::vector<std::function<void(std::exception_ptr)>> m_stop_callbacks;
 
         // Reconnect state
         std::atomic<bool> m_reconnecting;
         std::atomic<int> m_reconnect_attempts;
+        // delay picked for the previous attempt, handed back to the reconnect policy
+        std::chrono::milliseconds m_last_reconnect_delay;
+        // fed by the application, reconnect attempts wait while it is false
+        std::atomic<bool> m_network_available;
         std::shared_ptr<cancellation_token_source> m_reconnect_cts;
         std::mutex m_reconnect_lock;
 
         void initialize();
 
+        void add_subscription(const std::string& event_name, hub_subscription&& subscription);
+        void compile_targets();
+        void dispatch_invocation(const invocation_message& invocation);
+
         void process_message(std::string&& message);
 
         void invoke_hub_method(const std::string& method_name, const std::vector<signalr::value>& arguments, const std::string& callback_id,
+            std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception,
+            signalr::message_type invocation_type = signalr::message_type::invocation,
+            const std::vector<std::string>& stream_ids = std::vector<std::string>()) noexcept;
+        void invoke_prepared_method(invocation_template& prepared, const std::vector<signalr::value>& arguments, const std::string& callback_id,
+            std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept;
+        void send_invocation(const std::string& message, const std::string& callback_id,
             std::function<void()> set_completion, std::function<void(const std::exception_ptr)> set_exception) noexcept;
+        // registers the completion of an invoke, throws when the callback table is at its limit
+        std::string register_invocation(std::function<void(const signalr::value&, std::exception_ptr)> callback, std::chrono::milliseconds timeout);
         bool invoke_callback(completion_message* completion);
+        void send_cancel_invocation(const std::string& invocation_id) noexcept;
+        // sends a serialized message, or appends it to the corked batch. `buffer_offline` lets the offline buffer hold it
+        void send_message(const std::string& payload, std::function<void(std::exception_ptr)> callback, bool buffer_offline = false) noexcept;
+        void flush_offline_buffer() noexcept;
+        // returns false when no handshake is pending and the caller should send the message itself
+        bool queue_until_handshake(const std::string& payload, const std::function<void(std::exception_ptr)>& callback);
+        void flush_handshake_queue() noexcept;
+        void fail_handshake_queue(std::exception_ptr reason) noexcept;
+        void complete_connect_trace();
+        void send_batch(const std::string& payload, std::vector<std::function<void(std::exception_ptr)>>&& callbacks) noexcept;
+        // wraps a send callback so the message is recorded for replay once the transport accepted it
+        std::function<void(std::exception_ptr)> track_for_replay(const std::string& payload, std::function<void(std::exception_ptr)> callback);
+        void send_ack() noexcept;
+        void replay_unacknowledged() noexcept;
+        std::shared_ptr<client_stream> create_client_stream();
+        void close_client_streams(std::exception_ptr reason);
 
         void reset_send_ping();
         void reset_server_timeout();
@@ -106,8 +227,17 @@ namespace signalr
         void start_keepalive();
 
         // Reconnect methods
-        void handle_disconnection(std::exception_ptr exception);
+        void handle_disconnection(std::exception_ptr exception, bool allow_resume = true);
         void attempt_reconnect();
+        void queue_reconnect(int attempt, std::shared_ptr<cancellation_token_source> reconnect_cts, std::chrono::milliseconds delay);
+        // hands an attempt back to the reconnect worker to run `job` after `wait`
+        void requeue_reconnect(std::unique_ptr<reconnect_task_params> params, std::chrono::milliseconds wait,
+            void (*job)(void* param) = run_reconnect_attempt);
+        // gives up reconnecting when the next step of an attempt could not be queued
+        void fail_reconnect_queue(int attempt);
+        void resume(std::function<void(std::exception_ptr)> callback) noexcept;
+        // runs the cleanup handle_disconnection skipped when a resume is given up, once
+        void abandon_resume(std::exception_ptr exception);
         std::chrono::milliseconds get_next_reconnect_delay();
     };
 }
@@ -5,9 +5,14 @@
 #pragma once
 
 #include "signalr_value.h"
+#include "raw_arguments.h"
 #include "transfer_format.h"
 #include "message_type.h"
+#include "target_table.h"
+#include "memory_utils.h"
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace signalr
 {
@@ -17,6 +22,10 @@ namespace signalr
 
         virtual ~hub_message() {}
 
+        // received messages only live until the frame is dispatched, take them from the message arena when one is active
+        static void* operator new(size_t size) { return memory::arena_alloc(size); }
+        static void operator delete(void* ptr) { memory::arena_free(ptr); }
+
         signalr::message_type message_type;
     };
 
@@ -41,9 +50,38 @@ namespace signalr
             : hub_invocation_message(invocation_id, signalr::message_type::invocation), target(target), arguments(args), stream_ids(stream_ids)
         { }
 
+        // used for received invocations, the arguments stay serialized until a handler asks for them
+        invocation_message(std::string&& invocation_id, std::string&& target, const signalr::raw_arguments& arguments_view, int target_id = target_table::not_found)
+            : hub_invocation_message(invocation_id, signalr::message_type::invocation), target(target), arguments_view(arguments_view), target_id(target_id)
+        { }
+
         std::string target;
         std::vector<signalr::value> arguments;
         std::vector<std::string> stream_ids;
+        // only valid while the buffer the message was parsed from is alive
+        signalr::raw_arguments arguments_view;
+        // index into the target table the message was parsed with, `target` is left empty when it was resolved
+        int target_id = target_table::not_found;
+    };
+
+    struct stream_item_message : hub_invocation_message
+    {
+        stream_item_message(const std::string& invocation_id, const signalr::value& item)
+            : hub_invocation_message(invocation_id, signalr::message_type::stream_item), item(item)
+        { }
+
+        stream_item_message(std::string&& invocation_id, signalr::value&& item)
+            : hub_invocation_message(invocation_id, signalr::message_type::stream_item), item(std::move(item))
+        { }
+
+        signalr::value item;
+    };
+
+    struct cancel_invocation_message : hub_invocation_message
+    {
+        cancel_invocation_message(const std::string& invocation_id)
+            : hub_invocation_message(invocation_id, signalr::message_type::cancel_invocation)
+        { }
     };
 
     struct completion_message : hub_invocation_message
@@ -66,11 +104,30 @@ namespace signalr
         ping_message() : hub_message(signalr::message_type::ping) {}
     };
 
+    // Stateful reconnect: acknowledges every sequenced message up to and including `sequence_id`
+    struct ack_message : hub_message
+    {
+        ack_message(int64_t sequence_id) : hub_message(signalr::message_type::ack), sequence_id(sequence_id) {}
+
+        int64_t sequence_id;
+    };
+
+    // Stateful reconnect: the sequenced messages that follow start at `sequence_id`
+    struct sequence_message : hub_message
+    {
+        sequence_message(int64_t sequence_id) : hub_message(signalr::message_type::sequence), sequence_id(sequence_id) {}
+
+        int64_t sequence_id;
+    };
+
+    typedef std::vector<std::unique_ptr<hub_message>, memory::arena_allocator<std::unique_ptr<hub_message>>> hub_message_list;
+
     class hub_protocol
     {
     public:
         virtual std::string write_message(const hub_message*) const = 0;
-        virtual std::vector<std::unique_ptr<hub_message>> parse_messages(const std::string&) const = 0;
+        // `targets` is optional, when given invocation targets are resolved against it instead of being copied out
+        virtual hub_message_list parse_messages(const std::string&, const target_table* targets) const = 0;
         virtual const std::string& name() const = 0;
         virtual int version() const = 0;
         virtual signalr::transfer_format transfer_format() const = 0;
@@ -0,0 +1,63 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "invocation_template.h"
+#include "json_helpers.h"
+#include "message_type.h"
+
+namespace signalr
+{
+    invocation_template::invocation_template(const std::string& target)
+        : m_target(target), m_buffer_in_use(false)
+    {
+        m_prefix.append("{\"type\":").append(std::to_string(static_cast<int>(message_type::invocation))).append(",\"target\":");
+        appendJsonString(m_prefix, target);
+        m_prefix.append(",\"arguments\":[");
+    }
+
+    const std::string& invocation_template::target() const noexcept
+    {
+        return m_target;
+    }
+
+    void invocation_template::write(std::string& out, const std::vector<signalr::value>& arguments, const std::string& invocation_id) const
+    {
+        out.append(m_prefix);
+        for (size_t i = 0; i < arguments.size(); ++i)
+        {
+            if (i > 0)
+            {
+                out.push_back(',');
+            }
+            appendJson(out, arguments[i]);
+        }
+        out.push_back(']');
+
+        if (!invocation_id.empty())
+        {
+            out.append(",\"invocationId\":");
+            appendJsonString(out, invocation_id);
+        }
+
+        out.push_back('}');
+        out.push_back(record_separator);
+    }
+
+    std::string* invocation_template::acquire_buffer() noexcept
+    {
+        if (m_buffer_in_use.exchange(true))
+        {
+            return nullptr;
+        }
+
+        // keeps the capacity of the previous message
+        m_buffer.clear();
+        return &m_buffer;
+    }
+
+    void invocation_template::release_buffer() noexcept
+    {
+        m_buffer_in_use.store(false);
+    }
+}
@@ -0,0 +1,39 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "signalr_value.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // JSON invocation of one hub method with the parts that do not depend on the arguments serialized up front
+    class invocation_template
+    {
+    public:
+        explicit invocation_template(const std::string& target);
+
+        invocation_template(const invocation_template&) = delete;
+        invocation_template& operator=(const invocation_template&) = delete;
+
+        const std::string& target() const noexcept;
+
+        // appends the complete message, including the record separator. `invocation_id` is empty for a non-blocking send
+        void write(std::string& out, const std::vector<signalr::value>& arguments, const std::string& invocation_id) const;
+
+        // hands out the reusable output buffer, returns nullptr if it is in use (e.g. a send from a completion callback)
+        std::string* acquire_buffer() noexcept;
+        void release_buffer() noexcept;
+
+    private:
+        std::string m_target;
+        // {"type":1,"target":"<target>","arguments":[
+        std::string m_prefix;
+        std::string m_buffer;
+        std::atomic<bool> m_buffer_in_use;
+    };
+}
@@ -569,6 +569,26 @@ bool json_reader::parse(const std::string& document, json_value& root, bool coll
     return true;
 }
 
+bool json_reader::parse(const char* document, size_t length, json_value& root) {
+    cJSON* parsed = cJSON_ParseWithLength(document, length);
+
+    if (!parsed) {
+        const char* error = cJSON_GetErrorPtr();
+        if (error) {
+            m_error_message = std::string("JSON parse error: ") + error;
+        } else {
+            m_error_message = "JSON parse error: Unknown error";
+        }
+        return false;
+    }
+
+    root.release();
+    root.m_node = parsed;
+    root.m_owns_node = true;
+
+    return true;
+}
+
 std::string json_reader::get_formatted_error_messages() const {
     return m_error_message;
 }
@@ -0,0 +1,75 @@
+#include "json_allocator.h"
+#include "signalr_memory_stats.h"
+#include "memory_utils.h"
+#include "sdkconfig.h"
+#include "esp_memory_utils.h"
+#include "esp_log.h"
+#include "cJSON.h"
+#include <atomic>
+
+static const char* JSON_ALLOCATOR_TAG = "JSON_ALLOC";
+
+namespace signalr {
+
+#if defined(CONFIG_SIGNALR_JSON_PSRAM_HOOKS) && defined(CONFIG_SPIRAM)
+
+namespace {
+
+std::atomic<uint32_t> s_psram_allocations(0);
+std::atomic<uint32_t> s_internal_allocations(0);
+std::atomic<uint32_t> s_internal_bytes_saved(0);
+
+void* json_malloc(size_t size) {
+    // heap_caps memory, so strings the application releases with free() are fine
+    void* ptr = memory::alloc_prefer_psram(size, 0);
+    if (ptr) {
+        if (esp_ptr_external_ram(ptr)) {
+            s_psram_allocations.fetch_add(1, std::memory_order_relaxed);
+            s_internal_bytes_saved.fetch_add((uint32_t)size, std::memory_order_relaxed);
+        } else {
+            s_internal_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return ptr;
+}
+
+void json_free(void* ptr) {
+    // also covers anything cJSON allocated with plain malloc before the hooks were installed
+    memory::free_memory(ptr);
+}
+
+} // namespace
+
+void install_json_allocator() {
+    static const bool installed = []() {
+        cJSON_Hooks hooks;
+        hooks.malloc_fn = json_malloc;
+        hooks.free_fn = json_free;
+        cJSON_InitHooks(&hooks);
+        ESP_LOGI(JSON_ALLOCATOR_TAG, "cJSON hooks installed, allocations prefer PSRAM");
+        return true;
+    }();
+    (void)installed;
+}
+
+json_memory_stats get_json_memory_stats() noexcept {
+    json_memory_stats stats = {};
+    stats.psram_allocations = s_psram_allocations.load(std::memory_order_relaxed);
+    stats.internal_allocations = s_internal_allocations.load(std::memory_order_relaxed);
+    stats.internal_bytes_saved = s_internal_bytes_saved.load(std::memory_order_relaxed);
+    return stats;
+}
+
+#else
+
+void install_json_allocator() {
+}
+
+json_memory_stats get_json_memory_stats() noexcept {
+    json_memory_stats stats = {};
+    return stats;
+}
+
+#endif
+
+} // namespace signalr
@@ -0,0 +1,19 @@
+// ESP32 SignalR Client - cJSON allocation hooks
+// Routes cJSON's allocations to PSRAM, keeping the churn of building and
+// parsing JSON out of the internal heap.
+
+#pragma once
+
+namespace signalr {
+
+/**
+ * Install the cJSON hooks once for the process. Safe to call repeatedly and
+ * from any task. Does nothing unless CONFIG_SIGNALR_JSON_PSRAM_HOOKS is set.
+ *
+ * The hooks are global to cJSON, so they also serve the application's own cJSON
+ * usage. They only choose the heap: everything they hand out can still be
+ * released with free(), as can memory allocated before they were installed.
+ */
+void install_json_allocator();
+
+} // namespace signalr
@@ -3,7 +3,13 @@
 // See the LICENSE file in the project root for more information.
 
 #include "json_helpers.h"
+#include "json_scanner.h"
+#include "signalr_exception.h"
 #include <cmath>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <stdint.h>
 #include "esp_log.h"
 
@@ -52,6 +58,92 @@ namespace signalr
         }
     }
 
+    namespace
+    {
+        const int max_value_depth = 32;
+
+        signalr::value createValue(const json_scanner::span& json, int depth)
+        {
+            if (depth > max_value_depth)
+            {
+                throw signalr_exception("invalid JSON: nesting too deep");
+            }
+
+            switch (json.data[0])
+            {
+            case '"':
+            {
+                std::string str;
+                if (!json_scanner::read_string(json, str))
+                {
+                    throw signalr_exception("invalid JSON: malformed string");
+                }
+                return signalr::value(std::move(str));
+            }
+            case '[':
+            {
+                std::vector<signalr::value> vec;
+                json_scanner::array_reader reader(json.data, json.data + json.length);
+                json_scanner::span element;
+                while (reader.next(element))
+                {
+                    vec.push_back(createValue(element, depth + 1));
+                }
+                return signalr::value(std::move(vec));
+            }
+            case '{':
+            {
+                std::map<std::string, signalr::value> map;
+                json_scanner::object_reader reader(json.data, json.data + json.length);
+                json_scanner::span key;
+                json_scanner::span member;
+                while (reader.next(key, member))
+                {
+                    // keys come back without their quotes, widen the span again so escapes are decoded like any string
+                    std::string name;
+                    json_scanner::read_string(json_scanner::span{ key.data - 1, key.length + 2 }, name);
+                    map.insert({ std::move(name), createValue(member, depth + 1) });
+                }
+                return signalr::value(std::move(map));
+            }
+            default:
+                break;
+            }
+
+            if (json.length == 4 && memcmp(json.data, "true", 4) == 0)
+            {
+                return signalr::value(true);
+            }
+            if (json.length == 5 && memcmp(json.data, "false", 5) == 0)
+            {
+                return signalr::value(false);
+            }
+            if (json.length == 4 && memcmp(json.data, "null", 4) == 0)
+            {
+                return signalr::value();
+            }
+
+            double number;
+            if (!json_scanner::read_number(json, number))
+            {
+                throw signalr_exception("invalid JSON: unexpected value '" + std::string(json.data, json.length) + "'");
+            }
+            return signalr::value(number);
+        }
+    }
+
+    signalr::value createValue(const char* json, size_t length)
+    {
+        auto end = json + length;
+        auto begin = json_scanner::skip_whitespace(json, end);
+        auto value_end = json_scanner::skip_value(begin, end);
+        if (value_end == nullptr || json_scanner::skip_whitespace(value_end, end) != end)
+        {
+            throw signalr_exception("invalid JSON: expected a single value");
+        }
+        return createValue(json_scanner::span{ begin, (size_t)(value_end - begin) }, 0);
+    }
+
     char getBase64Value(uint32_t i)
     {
         char index = (char)i;
@@ -200,6 +292,138 @@ namespace signalr
         }
     }
 
+    namespace
+    {
+        // mirrors cJSON's print_number: integers as %d, otherwise the shortest of %1.15g and %1.17g that round-trips
+        void appendNumber(std::string& out, double value)
+        {
+            if (std::isnan(value) || std::isinf(value))
+            {
+                out.append("null");
+                return;
+            }
+
+            char buffer[26];
+            int length;
+            double intPart;
+            if (std::modf(value, &intPart) == 0 && value >= (double)INT_MIN && value <= (double)INT_MAX)
+            {
+                length = snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(intPart));
+            }
+            else
+            {
+                length = snprintf(buffer, sizeof(buffer), "%1.15g", value);
+                if (strtod(buffer, nullptr) != value)
+                {
+                    length = snprintf(buffer, sizeof(buffer), "%1.17g", value);
+                }
+            }
+
+            out.append(buffer, (size_t)length);
+        }
+    }
+
+    // mirrors cJSON's print_string_ptr, only quotes, backslashes and control characters are escaped
+    void appendJsonString(std::string& out, const std::string& str)
+    {
+        out.push_back('"');
+        size_t start = 0;
+        for (size_t i = 0; i < str.size(); ++i)
+        {
+            auto c = (unsigned char)str[i];
+            if (c >= 32 && c != '"' && c != '\\')
+            {
+                continue;
+            }
+
+            out.append(str, start, i - start);
+            start = i + 1;
+            switch (c)
+            {
+            case '"': out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+            {
+                char escaped[7];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out.append(escaped, 6);
+                break;
+            }
+            }
+        }
+        out.append(str, start, std::string::npos);
+        out.push_back('"');
+    }
+
+    void appendJson(std::string& out, const signalr::value& v)
+    {
+        switch (v.type())
+        {
+        case signalr::value_type::boolean:
+            out.append(v.as_bool() ? "true" : "false");
+            break;
+        case signalr::value_type::float64:
+            appendNumber(out, v.as_double());
+            break;
+        case signalr::value_type::string:
+        {
+            const auto& str = v.as_string();
+            if (str.length() > 65536) {
+                ESP_LOGE(JSON_HELPERS_TAG, "String too large for JSON: %d bytes (max 64KB)", str.length());
+                throw std::runtime_error("String too large: " + std::to_string(str.length()) + " bytes (max 64KB)");
+            }
+            appendJsonString(out, str);
+            break;
+        }
+        case signalr::value_type::array:
+        {
+            out.push_back('[');
+            bool first = true;
+            for (auto& val : v.as_array())
+            {
+                if (!first)
+                {
+                    out.push_back(',');
+                }
+                first = false;
+                appendJson(out, val);
+            }
+            out.push_back(']');
+            break;
+        }
+        case signalr::value_type::map:
+        {
+            out.push_back('{');
+            bool first = true;
+            for (auto& val : v.as_map())
+            {
+                if (!first)
+                {
+                    out.push_back(',');
+                }
+                first = false;
+                appendJsonString(out, val.first);
+                out.push_back(':');
+                appendJson(out, val.second);
+            }
+            out.push_back('}');
+            break;
+        }
+        case signalr::value_type::binary:
+            appendJsonString(out, base64Encode(v.as_binary()));
+            break;
+        case signalr::value_type::null:
+        default:
+            out.append("null");
+            break;
+        }
+    }
+
     json_stream_writer_builder getJsonWriter()
     {
         return json_stream_writer_builder();
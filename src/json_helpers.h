@@ -14,8 +14,15 @@ namespace signalr
 
     signalr::value createValue(const json_value& v);
 
+    // converts JSON text directly, without building an intermediate cJSON tree
+    signalr::value createValue(const char* json, size_t length);
+
     json_value createJson(const signalr::value& v);
 
+    // appends the JSON text of a value without building a cJSON tree, formatted the way cJSON prints createJson(v)
+    void appendJson(std::string& out, const signalr::value& v);
+    void appendJsonString(std::string& out, const std::string& str);
+
     std::string base64Encode(const std::vector<uint8_t>& data);
 
     json_stream_writer_builder getJsonWriter();
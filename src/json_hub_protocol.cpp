@@ -5,7 +5,9 @@
 #include "json_hub_protocol.h"
 #include "message_type.h"
 #include "json_helpers.h"
+#include "json_scanner.h"
 #include "signalr_exception.h"
+#include <cstring>
 
 namespace signalr
 {
@@ -19,6 +21,7 @@ namespace signalr
             switch (hub_message->message_type)
             {
             case message_type::invocation:
+            case message_type::stream_invocation:
             {
                 auto invocation = static_cast<invocation_message const*>(hub_message);
                 object["type"] = json_value::from_int(static_cast<int>(invocation->message_type));
@@ -28,7 +31,15 @@ namespace signalr
                 }
                 object["target"] = json_value::from_string(invocation->target);
                 object["arguments"] = createJson(invocation->arguments);
-                // TODO: streamIds
+                if (!invocation->stream_ids.empty())
+                {
+                    json_value stream_ids = json_value::array();
+                    for (const auto& stream_id : invocation->stream_ids)
+                    {
+                        stream_ids.append(json_value::from_string(stream_id));
+                    }
+                    object["streamIds"] = std::move(stream_ids);
+                }
 
                 break;
             }
@@ -47,12 +58,41 @@ namespace signalr
                 }
                 break;
             }
+            case message_type::stream_item:
+            {
+                auto stream_item = static_cast<stream_item_message const*>(hub_message);
+                object["type"] = json_value::from_int(static_cast<int>(stream_item->message_type));
+                object["invocationId"] = json_value::from_string(stream_item->invocation_id);
+                object["item"] = createJson(stream_item->item);
+                break;
+            }
+            case message_type::cancel_invocation:
+            {
+                auto cancel = static_cast<cancel_invocation_message const*>(hub_message);
+                object["type"] = json_value::from_int(static_cast<int>(cancel->message_type));
+                object["invocationId"] = json_value::from_string(cancel->invocation_id);
+                break;
+            }
             case message_type::ping:
             {
                 auto ping = static_cast<ping_message const*>(hub_message);
                 object["type"] = json_value::from_int(static_cast<int>(ping->message_type));
                 break;
             }
+            case message_type::ack:
+            {
+                auto ack = static_cast<ack_message const*>(hub_message);
+                object["type"] = json_value::from_int(static_cast<int>(ack->message_type));
+                object["sequenceId"] = json_value::from_double(static_cast<double>(ack->sequence_id));
+                break;
+            }
+            case message_type::sequence:
+            {
+                auto sequence = static_cast<sequence_message const*>(hub_message);
+                object["type"] = json_value::from_int(static_cast<int>(sequence->message_type));
+                object["sequenceId"] = json_value::from_double(static_cast<double>(sequence->sequence_id));
+                break;
+            }
             // TODO: other message types
             default:
                 break;
@@ -72,14 +112,14 @@ namespace signalr
         }
     }
 
-    std::vector<std::unique_ptr<hub_message>> json_hub_protocol::parse_messages(const std::string& message) const
+    hub_message_list json_hub_protocol::parse_messages(const std::string& message, const target_table* targets) const
     {
-        std::vector<std::unique_ptr<hub_message>> vec;
+        hub_message_list vec;
         size_t offset = 0;
         auto pos = message.find(record_separator, offset);
         while (pos != std::string::npos)
         {
-            auto hub_message = parse_message(message.c_str() + offset, pos - offset);
+            auto hub_message = parse_message(message.c_str() + offset, pos - offset, targets);
             if (hub_message != nullptr)
             {
                 vec.push_back(std::move(hub_message));
@@ -93,131 +133,179 @@ namespace signalr
         return vec;
     }
 
-    std::unique_ptr<hub_message> json_hub_protocol::parse_message(const char* begin, size_t length) const
+    std::unique_ptr<hub_message> json_hub_protocol::parse_message(const char* begin, size_t length, const target_table* targets) const
     {
-        json_value root;
-        auto reader = getJsonReader();
-
-        std::string json_str(begin, length);
-        if (!reader->parse(json_str, root))
+        // Walk the top-level members in place instead of converting the whole message into a signalr::value tree.
+        // Invocation arguments are kept as a slice of the receive buffer and only decoded when a handler needs them.
+        json_scanner::object_reader reader(begin, begin + length);
+        if (!reader.is_object())
         {
-            throw signalr_exception(reader->get_formatted_error_messages());
+            throw signalr_exception("Message was not a 'map' type");
         }
 
-        // TODO: manually go through the json object to avoid short-lived allocations
-        auto value = createValue(root);
+        json_scanner::span type{ nullptr, 0 };
+        json_scanner::span target{ nullptr, 0 };
+        json_scanner::span arguments{ nullptr, 0 };
+        json_scanner::span invocation_id{ nullptr, 0 };
+        json_scanner::span result{ nullptr, 0 };
+        json_scanner::span error{ nullptr, 0 };
+        json_scanner::span item{ nullptr, 0 };
+        json_scanner::span sequence_id{ nullptr, 0 };
 
-        if (!value.is_map())
+        json_scanner::span key;
+        json_scanner::span member;
+        while (reader.next(key, member))
         {
-            throw signalr_exception("Message was not a 'map' type");
+            if (json_scanner::key_equals(key, "type"))
+            {
+                type = member;
+            }
+            else if (json_scanner::key_equals(key, "target"))
+            {
+                target = member;
+            }
+            else if (json_scanner::key_equals(key, "arguments"))
+            {
+                arguments = member;
+            }
+            else if (json_scanner::key_equals(key, "invocationId"))
+            {
+                invocation_id = member;
+            }
+            else if (json_scanner::key_equals(key, "result"))
+            {
+                result = member;
+            }
+            else if (json_scanner::key_equals(key, "error"))
+            {
+                error = member;
+            }
+            else if (json_scanner::key_equals(key, "item"))
+            {
+                item = member;
+            }
+            else if (json_scanner::key_equals(key, "sequenceId"))
+            {
+                sequence_id = member;
+            }
         }
 
-        const auto& obj = value.as_map();
-
-        auto found = obj.find("type");
-        if (found == obj.end())
+        if (type.empty())
         {
             throw signalr_exception("Field 'type' not found");
         }
 
+        double type_value;
+        if (!json_scanner::read_number(type, type_value))
+        {
+            throw signalr_exception("Expected 'type' to be of type 'number'");
+        }
+
         std::unique_ptr<hub_message> hub_message;
 
 #pragma warning (push)
         // not all cases handled (we have a default so it's fine)
 #pragma warning (disable: 4061)
-        switch (static_cast<message_type>(static_cast<int>(found->second.as_double())))
+        switch (static_cast<message_type>(static_cast<int>(type_value)))
         {
         case message_type::invocation:
         {
-            found = obj.find("target");
-            if (found == obj.end())
+            if (target.empty())
             {
                 throw signalr_exception("Field 'target' not found for 'invocation' message");
             }
-            if (!found->second.is_string())
+            if (target.data[0] != '"' || target.length < 2)
+            {
+                throw signalr_exception("Expected 'target' to be of type 'string'");
+            }
+
+            // registered targets resolve straight from the buffer, only unknown or escaped names are copied out
+            int target_id = target_table::not_found;
+            if (targets != nullptr && memchr(target.data, '\\', target.length) == nullptr)
+            {
+                target_id = targets->find(target.data + 1, target.length - 2);
+            }
+
+            std::string target_name;
+            if (target_id == target_table::not_found && !json_scanner::read_string(target, target_name))
             {
                 throw signalr_exception("Expected 'target' to be of type 'string'");
             }
 
-            found = obj.find("arguments");
-            if (found == obj.end())
+            if (arguments.empty())
             {
                 throw signalr_exception("Field 'arguments' not found for 'invocation' message");
             }
-            if (!found->second.is_array())
+            if (arguments.data[0] != '[')
             {
                 throw signalr_exception("Expected 'arguments' to be of type 'array'");
             }
 
-            std::string invocation_id;
-            found = obj.find("invocationId");
-            if (found == obj.end())
+            std::string id;
+            if (!invocation_id.empty() && !json_scanner::read_string(invocation_id, id))
             {
-                invocation_id = "";
+                throw signalr_exception("Expected 'invocationId' to be of type 'string'");
             }
-            else
+
+            hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(std::move(id),
+                std::move(target_name), raw_arguments(arguments.data, arguments.length), target_id));
+
+            break;
+        }
+        case message_type::stream_item:
+        {
+            if (invocation_id.empty())
             {
-                if (!found->second.is_string())
-                {
-                    throw signalr_exception("Expected 'invocationId' to be of type 'string'");
-                }
-                invocation_id = found->second.as_string();
+                throw signalr_exception("Field 'invocationId' not found for 'stream_item' message");
+            }
+            std::string id;
+            if (!json_scanner::read_string(invocation_id, id))
+            {
+                throw signalr_exception("Expected 'invocationId' to be of type 'string'");
+            }
+
+            if (item.empty())
+            {
+                throw signalr_exception("Field 'item' not found for 'stream_item' message");
             }
 
-            hub_message = std::unique_ptr<signalr::hub_message>(new invocation_message(invocation_id,
-                obj.find("target")->second.as_string(), obj.find("arguments")->second.as_array()));
+            hub_message = std::unique_ptr<signalr::hub_message>(new stream_item_message(std::move(id),
+                createValue(item.data, item.length)));
 
             break;
         }
         case message_type::completion:
         {
-            bool has_result = false;
-            signalr::value result;
-            found = obj.find("result");
-            if (found != obj.end())
+            bool has_result = !result.empty();
+            signalr::value result_value;
+            if (has_result)
             {
-                has_result = true;
-                result = found->second;
+                result_value = createValue(result.data, result.length);
             }
 
-            std::string error;
-            found = obj.find("error");
-            if (found == obj.end())
-            {
-                error = "";
-            }
-            else
+            std::string error_message;
+            if (!error.empty() && !json_scanner::read_string(error, error_message))
             {
-                if (found->second.is_string())
-                {
-                    error = found->second.as_string();
-                }
-                else
-                {
-                    throw signalr_exception("Expected 'error' to be of type 'string'");
-                }
+                throw signalr_exception("Expected 'error' to be of type 'string'");
             }
 
-            found = obj.find("invocationId");
-            if (found == obj.end())
+            if (invocation_id.empty())
             {
                 throw signalr_exception("Field 'invocationId' not found for 'completion' message");
             }
-            else
+            std::string id;
+            if (!json_scanner::read_string(invocation_id, id))
             {
-                if (!found->second.is_string())
-                {
-                    throw signalr_exception("Expected 'invocationId' to be of type 'string'");
-                }
+                throw signalr_exception("Expected 'invocationId' to be of type 'string'");
             }
 
-            if (!error.empty() && has_result)
+            if (!error_message.empty() && has_result)
             {
                 throw signalr_exception("The 'error' and 'result' properties are mutually exclusive.");
             }
 
-            hub_message = std::unique_ptr<signalr::hub_message>(new completion_message(obj.find("invocationId")->second.as_string(),
-                error, result, has_result));
+            hub_message = std::unique_ptr<signalr::hub_message>(new completion_message(std::move(id),
+                std::move(error_message), std::move(result_value), has_result));
 
             break;
         }
@@ -226,6 +314,29 @@ namespace signalr
             hub_message = std::unique_ptr<signalr::hub_message>(new ping_message());
             break;
         }
+        case message_type::ack:
+        case message_type::sequence:
+        {
+            double sequence_value;
+            if (sequence_id.empty())
+            {
+                throw signalr_exception("Field 'sequenceId' not found");
+            }
+            if (!json_scanner::read_number(sequence_id, sequence_value))
+            {
+                throw signalr_exception("Expected 'sequenceId' to be of type 'number'");
+            }
+
+            if (static_cast<message_type>(static_cast<int>(type_value)) == message_type::ack)
+            {
+                hub_message = std::unique_ptr<signalr::hub_message>(new ack_message(static_cast<int64_t>(sequence_value)));
+            }
+            else
+            {
+                hub_message = std::unique_ptr<signalr::hub_message>(new sequence_message(static_cast<int64_t>(sequence_value)));
+            }
+            break;
+        }
         // TODO: other message types
         default:
             // Future protocol changes can add message types, old clients can ignore them
@@ -236,4 +347,4 @@ namespace signalr
 
         return hub_message;
     }
-}
\ No newline at end of file
+}
@@ -13,7 +13,7 @@ namespace signalr
     {
     public:
         std::string write_message(const hub_message*) const;
-        std::vector<std::unique_ptr<hub_message>> parse_messages(const std::string&) const;
+        hub_message_list parse_messages(const std::string&, const target_table* targets) const;
 
         const std::string& name() const
         {
@@ -32,7 +32,7 @@ namespace signalr
 
         ~json_hub_protocol() {}
     private:
-        std::unique_ptr<hub_message> parse_message(const char* begin, size_t length) const;
+        std::unique_ptr<hub_message> parse_message(const char* begin, size_t length, const target_table* targets) const;
 
         std::string m_protocol_name = "json";
     };
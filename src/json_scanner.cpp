@@ -0,0 +1,433 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "json_scanner.h"
+#include "signalr_exception.h"
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+namespace signalr
+{
+    namespace json_scanner
+    {
+        namespace
+        {
+            const char* skip_string(const char* p, const char* end)
+            {
+                // p points at the opening quote
+                ++p;
+                while (p < end)
+                {
+                    if (*p == '\\')
+                    {
+                        p += 2;
+                        continue;
+                    }
+                    if (*p == '"')
+                    {
+                        return p + 1;
+                    }
+                    ++p;
+                }
+                return nullptr;
+            }
+
+            const char* skip_literal(const char* p, const char* end)
+            {
+                while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= '0' && *p <= '9') ||
+                    *p == '-' || *p == '+' || *p == '.' || *p == 'E'))
+                {
+                    ++p;
+                }
+                return p;
+            }
+
+            int hex_value(char c)
+            {
+                if (c >= '0' && c <= '9') return c - '0';
+                if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+                if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+                return -1;
+            }
+
+            bool read_hex4(const char* p, const char* end, unsigned int& out)
+            {
+                if (end - p < 4)
+                {
+                    return false;
+                }
+                out = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    int v = hex_value(p[i]);
+                    if (v < 0)
+                    {
+                        return false;
+                    }
+                    out = (out << 4) | (unsigned int)v;
+                }
+                return true;
+            }
+
+            char* append_utf8(char* out, unsigned int code_point)
+            {
+                if (code_point < 0x80)
+                {
+                    *out++ = (char)code_point;
+                }
+                else if (code_point < 0x800)
+                {
+                    *out++ = (char)(0xC0 | (code_point >> 6));
+                    *out++ = (char)(0x80 | (code_point & 0x3F));
+                }
+                else if (code_point < 0x10000)
+                {
+                    *out++ = (char)(0xE0 | (code_point >> 12));
+                    *out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (code_point & 0x3F));
+                }
+                else
+                {
+                    *out++ = (char)(0xF0 | (code_point >> 18));
+                    *out++ = (char)(0x80 | ((code_point >> 12) & 0x3F));
+                    *out++ = (char)(0x80 | ((code_point >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (code_point & 0x3F));
+                }
+                return out;
+            }
+        }
+
+        const char* skip_whitespace(const char* p, const char* end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            {
+                ++p;
+            }
+            return p;
+        }
+
+        const char* skip_value(const char* p, const char* end)
+        {
+            p = skip_whitespace(p, end);
+            if (p >= end)
+            {
+                return nullptr;
+            }
+
+            if (*p == '"')
+            {
+                return skip_string(p, end);
+            }
+
+            if (*p != '{' && *p != '[')
+            {
+                auto literal_end = skip_literal(p, end);
+                return literal_end == p ? nullptr : literal_end;
+            }
+
+            // objects and arrays only need their brackets balanced, strings are skipped so that brackets inside of
+            // them are not counted
+            int depth = 0;
+            while (p < end)
+            {
+                switch (*p)
+                {
+                case '"':
+                    p = skip_string(p, end);
+                    if (p == nullptr)
+                    {
+                        return nullptr;
+                    }
+                    continue;
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+                case '}':
+                case ']':
+                    if (--depth == 0)
+                    {
+                        return p + 1;
+                    }
+                    break;
+                default:
+                    break;
+                }
+                ++p;
+            }
+            return nullptr;
+        }
+
+        bool key_equals(const span& key, const char* literal)
+        {
+            return key.length == strlen(literal) && memcmp(key.data, literal, key.length) == 0;
+        }
+
+        bool read_string(const span& value, std::string& out)
+        {
+            if (value.data == nullptr || value.length < 2)
+            {
+                return false;
+            }
+
+            out.resize(value.length - 2);
+            size_t length;
+            if (!read_string(value, &out[0], length))
+            {
+                return false;
+            }
+            out.resize(length);
+            return true;
+        }
+
+        bool read_string(const span& value, char* out, size_t& out_length)
+        {
+            if (value.data == nullptr || value.length < 2 || value.data[0] != '"' || value.data[value.length - 1] != '"')
+            {
+                return false;
+            }
+
+            const char* p = value.data + 1;
+            const char* end = value.data + value.length - 1;
+            char* dest = out;
+
+            const char* escape = (const char*)memchr(p, '\\', (size_t)(end - p));
+            if (escape == nullptr)
+            {
+                memcpy(dest, p, (size_t)(end - p));
+                out_length = (size_t)(end - p);
+                return true;
+            }
+
+            memcpy(dest, p, (size_t)(escape - p));
+            dest += escape - p;
+            p = escape;
+            // set at a \u0000, the string ends there as it did with cJSON. The rest is still checked for bad escapes
+            char* nul = nullptr;
+            while (p < end)
+            {
+                if (*p != '\\')
+                {
+                    *dest++ = *p++;
+                    continue;
+                }
+
+                if (++p >= end)
+                {
+                    return false;
+                }
+
+                switch (*p)
+                {
+                case '"': *dest++ = '"'; break;
+                case '\\': *dest++ = '\\'; break;
+                case '/': *dest++ = '/'; break;
+                case 'b': *dest++ = '\b'; break;
+                case 'f': *dest++ = '\f'; break;
+                case 'n': *dest++ = '\n'; break;
+                case 'r': *dest++ = '\r'; break;
+                case 't': *dest++ = '\t'; break;
+                case 'u':
+                {
+                    unsigned int code_point;
+                    if (!read_hex4(p + 1, end, code_point))
+                    {
+                        return false;
+                    }
+                    p += 4;
+
+                    // combine UTF-16 surrogate pairs, half of a pair on its own has no UTF-8 encoding
+                    if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+                    {
+                        return false;
+                    }
+                    if (code_point >= 0xD800 && code_point <= 0xDBFF)
+                    {
+                        unsigned int low;
+                        if (end - p <= 6 || p[1] != '\\' || p[2] != 'u' || !read_hex4(p + 3, end, low) || low < 0xDC00 || low > 0xDFFF)
+                        {
+                            return false;
+                        }
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+
+                    if (code_point == 0)
+                    {
+                        if (nul == nullptr)
+                        {
+                            nul = dest;
+                        }
+                        break;
+                    }
+                    // an escape sequence is at least as long as the UTF-8 it decodes to, so this can't overflow `out`
+                    dest = append_utf8(dest, code_point);
+                    break;
+                }
+                default:
+                    return false;
+                }
+                ++p;
+            }
+            out_length = (size_t)((nul != nullptr ? nul : dest) - out);
+            return true;
+        }
+
+        bool read_number(const span& value, double& out)
+        {
+            if (value.data == nullptr || value.length == 0 || value.length > 31 ||
+                !((value.data[0] >= '0' && value.data[0] <= '9') || value.data[0] == '-'))
+            {
+                return false;
+            }
+
+            // integers are the common case, anything up to 15 digits converts to a double exactly
+            size_t digits_begin = value.data[0] == '-' ? 1 : 0;
+            if (value.length - digits_begin <= 15 && value.length > digits_begin)
+            {
+                int64_t integer = 0;
+                size_t i = digits_begin;
+                for (; i < value.length && value.data[i] >= '0' && value.data[i] <= '9'; ++i)
+                {
+                    integer = integer * 10 + (value.data[i] - '0');
+                }
+                if (i == value.length)
+                {
+                    out = (double)(digits_begin ? -integer : integer);
+                    return true;
+                }
+            }
+
+            // the span is not null terminated, copy it so strtod can't read past the value
+            char buffer[32];
+            memcpy(buffer, value.data, value.length);
+            buffer[value.length] = '\0';
+
+            char* parse_end;
+            out = strtod(buffer, &parse_end);
+            return parse_end == buffer + value.length;
+        }
+
+        object_reader::object_reader(const char* begin, const char* end)
+            : m_pos(skip_whitespace(begin, end)), m_end(end), m_is_object(false), m_first(true)
+        {
+            if (m_pos < m_end && *m_pos == '{')
+            {
+                m_is_object = true;
+                ++m_pos;
+            }
+        }
+
+        bool object_reader::is_object() const
+        {
+            return m_is_object;
+        }
+
+        bool object_reader::next(span& key, span& value)
+        {
+            if (!m_is_object || m_pos == nullptr)
+            {
+                return false;
+            }
+
+            m_pos = skip_whitespace(m_pos, m_end);
+            if (m_pos < m_end && *m_pos == '}')
+            {
+                m_pos = nullptr;
+                return false;
+            }
+
+            if (!m_first)
+            {
+                if (m_pos >= m_end || *m_pos != ',')
+                {
+                    throw signalr_exception("invalid JSON: expected ',' or '}' in object");
+                }
+                m_pos = skip_whitespace(m_pos + 1, m_end);
+            }
+            m_first = false;
+
+            if (m_pos >= m_end || *m_pos != '"')
+            {
+                throw signalr_exception("invalid JSON: expected a property name");
+            }
+
+            auto key_end = skip_string(m_pos, m_end);
+            if (key_end == nullptr)
+            {
+                throw signalr_exception("invalid JSON: unterminated property name");
+            }
+            key.data = m_pos + 1;
+            key.length = (size_t)(key_end - m_pos - 2);
+
+            m_pos = skip_whitespace(key_end, m_end);
+            if (m_pos >= m_end || *m_pos != ':')
+            {
+                throw signalr_exception("invalid JSON: expected ':' after property name");
+            }
+
+            auto value_begin = skip_whitespace(m_pos + 1, m_end);
+            auto value_end = skip_value(value_begin, m_end);
+            if (value_end == nullptr)
+            {
+                throw signalr_exception("invalid JSON: malformed value for property '" + std::string(key.data, key.length) + "'");
+            }
+            value.data = value_begin;
+            value.length = (size_t)(value_end - value_begin);
+            m_pos = value_end;
+            return true;
+        }
+
+        array_reader::array_reader(const char* begin, const char* end)
+            : m_pos(skip_whitespace(begin, end)), m_end(end), m_is_array(false), m_first(true)
+        {
+            if (m_pos < m_end && *m_pos == '[')
+            {
+                m_is_array = true;
+                ++m_pos;
+            }
+        }
+
+        bool array_reader::is_array() const
+        {
+            return m_is_array;
+        }
+
+        bool array_reader::next(span& element)
+        {
+            if (!m_is_array || m_pos == nullptr)
+            {
+                return false;
+            }
+
+            m_pos = skip_whitespace(m_pos, m_end);
+            if (m_pos < m_end && *m_pos == ']')
+            {
+                m_pos = nullptr;
+                return false;
+            }
+
+            if (!m_first)
+            {
+                if (m_pos >= m_end || *m_pos != ',')
+                {
+                    throw signalr_exception("invalid JSON: expected ',' or ']' in array");
+                }
+                m_pos = skip_whitespace(m_pos + 1, m_end);
+            }
+            m_first = false;
+
+            auto element_end = skip_value(m_pos, m_end);
+            if (element_end == nullptr)
+            {
+                throw signalr_exception("invalid JSON: malformed array element");
+            }
+            element.data = m_pos;
+            element.length = (size_t)(element_end - m_pos);
+            m_pos = element_end;
+            return true;
+        }
+    }
+}
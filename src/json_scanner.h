@@ -0,0 +1,78 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace signalr
+{
+    // Helpers for walking JSON text in place without building a DOM. Values are only validated as far as needed to
+    // find where they end; anything that is actually consumed is fully parsed by the caller.
+    namespace json_scanner
+    {
+        struct span
+        {
+            const char* data;
+            size_t length;
+
+            bool empty() const { return data == nullptr; }
+        };
+
+        const char* skip_whitespace(const char* p, const char* end);
+
+        // returns a pointer one past the value starting at `p` (after optional whitespace) or nullptr if malformed
+        const char* skip_value(const char* p, const char* end);
+
+        // compares the raw (still escaped) contents of a key with a literal
+        bool key_equals(const span& key, const char* literal);
+
+        // decodes a JSON string value (including the quotes) into `out`, returns false if `value` is not a string or
+        // escapes half of a surrogate pair. The decoded string ends at an escaped NUL, the way cJSON's did
+        bool read_string(const span& value, std::string& out);
+
+        // same as above but decodes into `out` which needs room for at least `value.length - 2` bytes
+        bool read_string(const span& value, char* out, size_t& out_length);
+
+        // returns false if `value` is not a number
+        bool read_number(const span& value, double& out);
+
+        // Reads the members of a JSON object one at a time. Keys are returned without quotes and still escaped.
+        class object_reader
+        {
+        public:
+            object_reader(const char* begin, const char* end);
+
+            bool is_object() const;
+
+            // returns false once the closing brace has been consumed, throws signalr_exception on malformed input
+            bool next(span& key, span& value);
+
+        private:
+            const char* m_pos;
+            const char* m_end;
+            bool m_is_object;
+            bool m_first;
+        };
+
+        // Reads the elements of a JSON array one at a time.
+        class array_reader
+        {
+        public:
+            array_reader(const char* begin, const char* end);
+
+            bool is_array() const;
+
+            // returns false once the closing bracket has been consumed, throws signalr_exception on malformed input
+            bool next(span& element);
+
+        private:
+            const char* m_pos;
+            const char* m_end;
+            bool m_is_array;
+            bool m_first;
+        };
+    }
+}
@@ -0,0 +1,618 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "long_polling_transport.h"
+#include "signalr_exception.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <condition_variable>
+
+#pragma warning (push)
+#pragma warning (disable : 5204 4355)
+#include <future>
+#pragma warning (pop)
+
+namespace signalr
+{
+    namespace
+    {
+        // only reads the responses, the batches are handled on the dispatch task
+#ifdef CONFIG_SIGNALR_LONG_POLLING_STACK_SIZE
+        constexpr uint32_t POLL_TASK_STACK_SIZE = CONFIG_SIGNALR_LONG_POLLING_STACK_SIZE;
+#else
+        constexpr uint32_t POLL_TASK_STACK_SIZE = 8192;
+#endif
+
+        // the same work as the callback task of the WebSocket client
+#ifdef CONFIG_SIGNALR_CALLBACK_STACK_SIZE
+        constexpr uint32_t DISPATCH_TASK_STACK_SIZE = CONFIG_SIGNALR_CALLBACK_STACK_SIZE;
+#else
+        constexpr uint32_t DISPATCH_TASK_STACK_SIZE = 5120;
+#endif
+
+        // responses waiting for the dispatch task before the next poll waits for it, bounds the memory a fast server
+        // can make the client buffer
+        constexpr size_t MAX_QUEUED_BATCHES = 2;
+
+        // queued sends are joined into one POST up to this size, a larger message goes out on its own
+        constexpr size_t MAX_SEND_BATCH_SIZE = 16 * 1024;
+
+        // the DELETE after stop() only tells the server to drop the connection early, it is not waited for long
+        constexpr std::chrono::seconds DELETE_TIMEOUT(5);
+    }
+
+    struct long_polling_transport::poll_state
+    {
+        std::weak_ptr<long_polling_transport> transport;
+        std::shared_ptr<http_client> client;
+        std::string url;
+        std::map<std::string, std::string> headers;
+        logger log;
+        // canceled by stop() to end the poll and the sends in flight
+        std::shared_ptr<cancellation_token_source> cts;
+        // canceled once both tasks have exited
+        std::shared_ptr<cancellation_token_source> done;
+
+        std::mutex lock;
+        std::condition_variable changed;
+        std::deque<std::string> batches;
+        bool polling = true;
+        int running = 0;
+        // polling ended without stop(), the connection is reported as closed once the last batch was handled
+        bool ended = false;
+        // null if the server ended the connection
+        std::exception_ptr error;
+
+        explicit poll_state(const logger& logger)
+            : log(logger)
+        { }
+
+        // false if the connection is gone, `error` tells why unless it was stop() or the server
+        bool poll(std::string& content)
+        {
+            http_request request;
+            request.method = http_method::GET;
+            request.headers = headers;
+            // the server answers an empty poll after 90 seconds, within the default timeout
+            request.body_handler = [&content](const char* data, size_t length)
+            {
+                content.append(data, length);
+            };
+
+            int status_code = 0;
+            std::exception_ptr exception;
+            client->send(url, request, [&content, &status_code, &exception](const http_response& response, std::exception_ptr request_exception)
+                {
+                    status_code = response.status_code;
+                    exception = request_exception;
+                    if (content.empty())
+                    {
+                        // a client without body_handler support
+                        content = response.content;
+                    }
+                }, get_cancellation_token(cts));
+
+            if (cts->is_canceled())
+            {
+                return false;
+            }
+
+            if (exception != nullptr)
+            {
+                error = exception;
+                return false;
+            }
+
+            if (status_code == 204)
+            {
+                // the server closed the connection
+                return false;
+            }
+
+            if (status_code != 200)
+            {
+                error = std::make_exception_ptr(signalr_exception(
+                    std::string("poll failed with status code ").append(std::to_string(status_code))));
+                return false;
+            }
+            return true;
+        }
+
+        // without it the server keeps the connection until the poll it expected does not come
+        void send_delete()
+        {
+            try
+            {
+                auto delete_cts = std::make_shared<cancellation_token_source>();
+                http_request request;
+                request.method = http_method::DELETE;
+                request.headers = headers;
+                request.timeout = DELETE_TIMEOUT;
+                // the request is never canceled, stop() already returned
+                client->send(url, request, [this](const http_response&, std::exception_ptr exception)
+                    {
+                        if (exception != nullptr)
+                        {
+                            log.log(trace_level::debug, "the DELETE request of the long polling transport failed");
+                        }
+                    }, get_cancellation_token(delete_cts));
+            }
+            catch (const std::exception& e)
+            {
+                ESP_LOGW("LP_TRANSPORT", "sending the DELETE request threw: %s", e.what());
+            }
+        }
+    };
+
+    std::shared_ptr<signalr::transport> long_polling_transport::create(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+        const signalr_client_config& signalr_client_config, const logger& logger)
+    {
+        return std::shared_ptr<transport>(
+            new long_polling_transport(http_client_factory, signalr_client_config, logger));
+    }
+
+    long_polling_transport::long_polling_transport(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+        const signalr_client_config& signalr_client_config, const logger& logger)
+        : transport(logger), m_http_client_factory(http_client_factory), m_signalr_client_config(signalr_client_config),
+        m_process_response_callback([](std::string&&, std::exception_ptr) {}), m_close_callback([](std::exception_ptr) {}),
+        m_disconnected(true), m_sending(false)
+    { }
+
+    long_polling_transport::~long_polling_transport()
+    {
+        try
+        {
+            std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+            stop([promise](std::exception_ptr) { promise->set_value(); });
+            promise->get_future().get();
+        }
+        catch (...) // must not throw from the destructor
+        {}
+    }
+
+    transport_type long_polling_transport::get_transport_type() const noexcept
+    {
+        return transport_type::long_polling;
+    }
+
+    void long_polling_transport::poll_task(void* param)
+    {
+        // vTaskDelete does not return, every local is destroyed before it
+        {
+            auto holder = static_cast<std::shared_ptr<poll_state>*>(param);
+            std::shared_ptr<poll_state> state = std::move(*holder);
+            delete holder;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(state->lock);
+                    state->changed.wait(lock, [&state]() { return state->batches.size() < MAX_QUEUED_BATCHES || state->cts->is_canceled(); });
+                }
+
+                std::string content;
+                if (!state->poll(content))
+                {
+                    break;
+                }
+
+                if (!content.empty())
+                {
+                    ESP_LOGD("LP_TRANSPORT", "poll returned %zu bytes", content.length());
+                    std::lock_guard<std::mutex> lock(state->lock);
+                    state->batches.push_back(std::move(content));
+                    state->changed.notify_all();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(state->lock);
+                state->polling = false;
+                state->ended = !state->cts->is_canceled();
+                state->changed.notify_all();
+            }
+
+            task_exited(state);
+
+            // sent from here as the HTTP client blocks, stop() and whoever waits for the transport to be done do not
+            // wait for it
+            if (!state->ended)
+            {
+                state->send_delete();
+            }
+        }
+        vTaskDelete(nullptr);
+    }
+
+    void long_polling_transport::dispatch_task(void* param)
+    {
+        // vTaskDelete does not return, every local is destroyed before it
+        {
+            auto holder = static_cast<std::shared_ptr<poll_state>*>(param);
+            std::shared_ptr<poll_state> state = std::move(*holder);
+            delete holder;
+
+            while (true)
+            {
+                std::string batch;
+                {
+                    std::unique_lock<std::mutex> lock(state->lock);
+                    state->changed.wait(lock, [&state]() { return !state->batches.empty() || !state->polling; });
+                    if (state->batches.empty())
+                    {
+                        break;
+                    }
+                    batch = std::move(state->batches.front());
+                    state->batches.pop_front();
+                    // the poll task may be waiting for room
+                    state->changed.notify_all();
+                }
+
+                if (state->cts->is_canceled())
+                {
+                    // stopped, the rest is dropped
+                    continue;
+                }
+
+                auto transport = state->transport.lock();
+                if (!transport)
+                {
+                    continue;
+                }
+
+                try
+                {
+                    transport->m_process_response_callback(std::move(batch), nullptr);
+                }
+                catch (const std::exception& e)
+                {
+                    state->log.log(trace_level::error, std::string("[long polling transport] processing a message failed: ")
+                        .append(e.what()));
+                }
+                catch (...)
+                {
+                    state->log.log(trace_level::error, "[long polling transport] processing a message failed");
+                }
+            }
+
+            task_exited(state);
+        }
+        vTaskDelete(nullptr);
+    }
+
+    void long_polling_transport::task_exited(const std::shared_ptr<poll_state>& state)
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->lock);
+            if (--state->running > 0)
+            {
+                return;
+            }
+        }
+
+        // released after done is canceled, the transport destructor waits for that
+        std::shared_ptr<long_polling_transport> transport;
+        if (state->ended)
+        {
+            transport = state->transport.lock();
+            if (transport)
+            {
+                bool disconnected;
+                {
+                    std::lock_guard<std::mutex> lock(transport->m_start_stop_lock);
+                    disconnected = transport->m_disconnected;
+                    // stop() must not call the close callback a second time
+                    transport->m_disconnected = true;
+                }
+
+                if (!disconnected)
+                {
+                    if (state->error != nullptr)
+                    {
+                        try
+                        {
+                            std::rethrow_exception(state->error);
+                        }
+                        catch (const std::exception& e)
+                        {
+                            transport->m_logger.log(trace_level::error, std::string("[long polling transport] connection lost: ")
+                                .append(e.what()));
+                        }
+                    }
+                    else
+                    {
+                        transport->m_logger.log(trace_level::info, "[long polling transport] the server closed the connection");
+                    }
+                    transport->m_close_callback(state->error);
+                }
+            }
+        }
+
+        try
+        {
+            state->done->cancel();
+        }
+        catch (const std::exception& e)
+        {
+            ESP_LOGW("LP_TRANSPORT", "stop callback threw: %s", e.what());
+        }
+    }
+
+    void long_polling_transport::start(const std::string& url, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::shared_ptr<poll_state> state;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+
+            if (!m_disconnected)
+            {
+                callback(std::make_exception_ptr(signalr_exception("transport already connected")));
+                return;
+            }
+
+            // without the query, which carries the connection token
+            m_logger.log(trace_level::info,
+                std::string("[long polling transport] connecting to: ")
+                .append(url, 0, url.find('?')));
+
+            try
+            {
+                state = std::make_shared<poll_state>(m_logger);
+                state->transport = shared_from_this();
+                state->client = m_http_client_factory(m_signalr_client_config);
+                state->url = url;
+                state->headers = m_signalr_client_config.get_http_headers();
+                state->cts = std::make_shared<cancellation_token_source>();
+                state->done = std::make_shared<cancellation_token_source>();
+                // no task runs yet, stop() must not wait for them
+                state->done->cancel();
+            }
+            catch (...)
+            {
+                callback(std::current_exception());
+                return;
+            }
+
+            auto weak_state = std::weak_ptr<poll_state>(state);
+            state->cts->register_callback([weak_state]()
+                {
+                    auto state = weak_state.lock();
+                    if (state)
+                    {
+                        std::lock_guard<std::mutex> lock(state->lock);
+                        state->changed.notify_all();
+                    }
+                });
+
+            m_url = url;
+            m_poll_state = state;
+            m_disconnected = false;
+        }
+
+        // the server answers the first poll right away, it tells whether the connection was accepted
+        std::string content;
+        std::exception_ptr exception;
+        if (!state->poll(content))
+        {
+            exception = state->error != nullptr ? state->error
+                : std::make_exception_ptr(state->cts->is_canceled()
+                    ? signalr_exception("the transport was stopped while connecting")
+                    : signalr_exception("the server closed the connection while connecting"));
+        }
+        else
+        {
+            if (!content.empty())
+            {
+                state->batches.push_back(std::move(content));
+            }
+
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+            if (m_disconnected)
+            {
+                exception = std::make_exception_ptr(signalr_exception("the transport was stopped while connecting"));
+            }
+            else
+            {
+                state->done->reset();
+                state->running = 1;
+                auto param = new std::shared_ptr<poll_state>(state);
+                if (xTaskCreate(dispatch_task, "signalr_lp_rx", DISPATCH_TASK_STACK_SIZE, param, 5, nullptr) != pdPASS)
+                {
+                    delete param;
+                    state->running = 0;
+                    state->done->cancel();
+                    exception = std::make_exception_ptr(signalr_exception("failed to create the long polling dispatch task"));
+                }
+                else
+                {
+                    {
+                        std::lock_guard<std::mutex> state_lock(state->lock);
+                        ++state->running;
+                    }
+
+                    param = new std::shared_ptr<poll_state>(state);
+                    if (xTaskCreate(poll_task, "signalr_lp", POLL_TASK_STACK_SIZE, param, 5, nullptr) != pdPASS)
+                    {
+                        delete param;
+                        {
+                            // the dispatch task exits and completes `done`
+                            std::lock_guard<std::mutex> state_lock(state->lock);
+                            --state->running;
+                            state->polling = false;
+                            state->changed.notify_all();
+                        }
+                        exception = std::make_exception_ptr(signalr_exception("failed to create the long polling task"));
+                    }
+                }
+            }
+        }
+
+        if (exception != nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_start_stop_lock);
+                m_disconnected = true;
+            }
+
+            // stopped while connecting, there is no poll task to send the DELETE
+            if (state->cts->is_canceled())
+            {
+                state->send_delete();
+            }
+
+            try
+            {
+                std::rethrow_exception(exception);
+            }
+            catch (const std::exception& e)
+            {
+                m_logger.log(trace_level::error,
+                    std::string("[long polling transport] exception when connecting to the server: ")
+                    .append(e.what()));
+            }
+            callback(exception);
+            return;
+        }
+
+        callback(nullptr);
+    }
+
+    void long_polling_transport::stop(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::shared_ptr<poll_state> state;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+
+            if (m_disconnected)
+            {
+                callback(nullptr);
+                return;
+            }
+
+            m_disconnected = true;
+            state = m_poll_state;
+        }
+
+        auto logger = m_logger;
+        auto close_callback = m_close_callback;
+
+        m_logger.log(trace_level::debug, "stopping long polling transport");
+
+        try
+        {
+            state->cts->cancel();
+        }
+        catch (const std::exception& e)
+        {
+            ESP_LOGW("LP_TRANSPORT", "canceling the poll threw: %s", e.what());
+        }
+
+        // the poll task sends the DELETE once its poll returned
+        state->done->register_callback([logger, callback, close_callback]()
+            {
+                logger.log(trace_level::debug, "long polling transport stopped");
+
+                close_callback(nullptr);
+
+                callback(nullptr);
+            });
+    }
+
+    void long_polling_transport::on_close(std::function<void(std::exception_ptr)> callback)
+    {
+        m_close_callback = callback;
+    }
+
+    void long_polling_transport::on_receive(std::function<void(std::string&&, std::exception_ptr)> callback)
+    {
+        m_process_response_callback = callback;
+    }
+
+    void long_polling_transport::send(const std::string& payload, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::string url;
+        std::shared_ptr<cancellation_token_source> cts;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+            if (m_disconnected)
+            {
+                callback(std::make_exception_ptr(signalr_exception("cannot send data when the transport is not connected")));
+                return;
+            }
+            url = m_url;
+            cts = m_poll_state->cts;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_send_lock);
+            m_pending_sends.push_back(pending_send{ payload, callback });
+            if (m_sending)
+            {
+                // the call that is sending takes it along with its next POST
+                return;
+            }
+            m_sending = true;
+        }
+
+        // Messages are framed by the hub protocol, so the server reads any number of them from one POST. Callbacks of
+        // messages queued by other calls run on this task.
+        while (true)
+        {
+            std::vector<pending_send> batch;
+            std::string content;
+            {
+                std::lock_guard<std::mutex> lock(m_send_lock);
+                if (m_pending_sends.empty())
+                {
+                    m_sending = false;
+                    return;
+                }
+
+                while (!m_pending_sends.empty() && (batch.empty()
+                    || content.size() + m_pending_sends.front().payload.size() <= MAX_SEND_BATCH_SIZE))
+                {
+                    content.append(m_pending_sends.front().payload);
+                    batch.push_back(std::move(m_pending_sends.front()));
+                    m_pending_sends.pop_front();
+                }
+            }
+
+            if (batch.size() > 1)
+            {
+                ESP_LOGD("LP_TRANSPORT", "sending %d messages in one request", (int)batch.size());
+            }
+
+            std::exception_ptr exception;
+            try
+            {
+                http_request request;
+                request.method = http_method::POST;
+                request.headers = m_signalr_client_config.get_http_headers();
+                request.headers["Content-Type"] = transfer_format == transfer_format::binary
+                    ? "application/octet-stream" : "text/plain;charset=UTF-8";
+                request.content = std::move(content);
+                m_http_client_factory(m_signalr_client_config)->send(url, request,
+                    [&exception](const http_response& response, std::exception_ptr request_exception)
+                    {
+                        exception = request_exception;
+                        if (exception == nullptr && response.status_code != 200)
+                        {
+                            exception = std::make_exception_ptr(signalr_exception(
+                                std::string("send failed with status code ").append(std::to_string(response.status_code))));
+                        }
+                    }, get_cancellation_token(cts));
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            for (auto& sent : batch)
+            {
+                sent.callback(exception);
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "transport.h"
+#include "logger.h"
+#include "http_client.h"
+#include "signalr_client_config.h"
+#include "cancellation_token_source.h"
+
+namespace signalr
+{
+    // Receives with a GET that the server holds until it has messages, and sends as POSTs to the same url. The next
+    // GET is issued as soon as a response arrives and the batch is handled on a second task, so the server can
+    // answer it while the client is still busy with the previous one. Sends that are queued while a POST is in flight
+    // go out together in the next one.
+    class long_polling_transport : public transport, public std::enable_shared_from_this<long_polling_transport>
+    {
+    public:
+        static std::shared_ptr<transport> create(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+            const signalr_client_config& signalr_client_config, const logger& logger);
+
+        ~long_polling_transport();
+
+        long_polling_transport(const long_polling_transport&) = delete;
+
+        long_polling_transport& operator=(const long_polling_transport&) = delete;
+
+        transport_type get_transport_type() const noexcept override;
+
+        void start(const std::string& url, std::function<void(std::exception_ptr)> callback) noexcept override;
+        void stop(std::function<void(std::exception_ptr)> callback) noexcept override;
+        void on_close(std::function<void(std::exception_ptr)> callback) override;
+
+        void send(const std::string& payload, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept override;
+
+        void on_receive(std::function<void(std::string&&, std::exception_ptr)>) override;
+
+    private:
+        long_polling_transport(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+            const signalr_client_config& signalr_client_config, const logger& logger);
+
+        // state shared by the poll task and the dispatch task of one start()
+        struct poll_state;
+
+        struct pending_send
+        {
+            std::string payload;
+            std::function<void(std::exception_ptr)> callback;
+        };
+
+        static void poll_task(void* param);
+        static void dispatch_task(void* param);
+        static void task_exited(const std::shared_ptr<poll_state>& state);
+
+        std::function<std::shared_ptr<http_client>(const signalr_client_config&)> m_http_client_factory;
+        signalr_client_config m_signalr_client_config;
+        std::function<void(std::string&&, std::exception_ptr)> m_process_response_callback;
+        std::function<void(std::exception_ptr)> m_close_callback;
+
+        std::mutex m_start_stop_lock;
+        bool m_disconnected;
+        std::string m_url;
+        std::shared_ptr<poll_state> m_poll_state;
+
+        std::mutex m_send_lock;
+        std::deque<pending_send> m_pending_sends;
+        // a send() call is posting the queue, the others only add to it
+        bool m_sending;
+    };
+}
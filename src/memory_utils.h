@@ -14,6 +14,7 @@
 #include <memory>
 #include <vector>
 #include <cstring>
+#include <new>
 
 namespace signalr {
 namespace memory {
@@ -375,9 +376,16 @@ void execute_with_stack_check(Func&& func, const char* context = "callback") {
 /**
  * Simple fixed-size memory pool for frequently allocated objects
  * Reduces heap fragmentation from repeated small allocations
+ *
+ * Free blocks are threaded into a singly linked list through their first word,
+ * so allocate() and deallocate() are O(1).
  */
 template<size_t BLOCK_SIZE, size_t BLOCK_COUNT>
 class memory_pool {
+    static_assert(BLOCK_SIZE >= sizeof(void*) && BLOCK_SIZE % sizeof(void*) == 0,
+                  "BLOCK_SIZE must hold and be aligned for the free list link");
+    static_assert(BLOCK_COUNT > 0, "BLOCK_COUNT must not be 0");
+
 public:
     memory_pool() {
         m_mutex = xSemaphoreCreateMutex();
@@ -385,7 +393,11 @@ public:
         // Try to allocate pool in PSRAM
         m_pool = static_cast<uint8_t*>(alloc_prefer_psram(BLOCK_SIZE * BLOCK_COUNT, 2048));
         if (m_pool) {
-            memset(m_used, 0, sizeof(m_used));
+            for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+                uint8_t* next = i + 1 < BLOCK_COUNT ? m_pool + ((i + 1) * BLOCK_SIZE) : nullptr;
+                *reinterpret_cast<uint8_t**>(m_pool + (i * BLOCK_SIZE)) = next;
+            }
+            m_free = m_pool;
             ESP_LOGI(MEM_TAG, "Memory pool created: %u blocks x %u bytes",
                      (unsigned)BLOCK_COUNT, (unsigned)BLOCK_SIZE);
         } else {
@@ -397,54 +409,244 @@ public:
         if (m_mutex) vSemaphoreDelete(m_mutex);
         if (m_pool) free_memory(m_pool);
     }
+
+    memory_pool(const memory_pool&) = delete;
+    memory_pool& operator=(const memory_pool&) = delete;
     
     void* allocate() {
         if (!m_pool || !m_mutex) return nullptr;
         
         xSemaphoreTake(m_mutex, portMAX_DELAY);
         
-        for (size_t i = 0; i < BLOCK_COUNT; ++i) {
-            if (!m_used[i]) {
-                m_used[i] = true;
-                xSemaphoreGive(m_mutex);
-                return m_pool + (i * BLOCK_SIZE);
+        uint8_t* block = m_free;
+        if (block) {
+            m_free = *reinterpret_cast<uint8_t**>(block);
+            if (++m_in_use > m_peak) {
+                m_peak = m_in_use;
             }
         }
         
         xSemaphoreGive(m_mutex);
-        ESP_LOGW(MEM_TAG, "Memory pool exhausted");
-        return nullptr;
+        if (!block) {
+            // callers are expected to fall back to the heap, this can happen often under load
+            ESP_LOGD(MEM_TAG, "Memory pool exhausted");
+        }
+        return block;
     }
     
     void deallocate(void* ptr) {
         if (!m_pool || !ptr) return;
         
         uint8_t* p = static_cast<uint8_t*>(ptr);
-        if (p < m_pool || p >= m_pool + (BLOCK_SIZE * BLOCK_COUNT)) {
+        if (!owns(p) || (p - m_pool) % BLOCK_SIZE != 0) {
             ESP_LOGE(MEM_TAG, "Invalid pointer passed to pool deallocate");
             return;
         }
         
-        size_t index = (p - m_pool) / BLOCK_SIZE;
-        
         xSemaphoreTake(m_mutex, portMAX_DELAY);
-        m_used[index] = false;
+        *reinterpret_cast<uint8_t**>(p) = m_free;
+        m_free = p;
+        --m_in_use;
         xSemaphoreGive(m_mutex);
     }
+
+    bool owns(const void* ptr) const {
+        const uint8_t* p = static_cast<const uint8_t*>(ptr);
+        return m_pool && p >= m_pool && p < m_pool + (BLOCK_SIZE * BLOCK_COUNT);
+    }
+
+    // address of the backing block, nullptr if it could not be allocated
+    const void* data() const { return m_pool; }
     
     size_t available() const {
-        size_t count = 0;
-        for (size_t i = 0; i < BLOCK_COUNT; ++i) {
-            if (!m_used[i]) ++count;
-        }
-        return count;
+        return m_pool ? BLOCK_COUNT - m_in_use : 0;
     }
+
+    size_t in_use() const { return m_in_use; }
+    size_t peak() const { return m_peak; }
+    static constexpr size_t block_size() { return BLOCK_SIZE; }
+    static constexpr size_t capacity() { return BLOCK_COUNT; }
     
 private:
     uint8_t* m_pool = nullptr;
-    bool m_used[BLOCK_COUNT] = {false};
+    uint8_t* m_free = nullptr;
+    size_t m_in_use = 0;
+    size_t m_peak = 0;
     SemaphoreHandle_t m_mutex = nullptr;
 };
 
+// ============================================================================
+// Per-message arena (bump allocator reset after every received frame)
+// ============================================================================
+
+/**
+ * Bump allocator for the short-lived objects created while a received frame is
+ * parsed and dispatched. Allocation is a pointer increment, individual frees are
+ * no-ops and the whole block is recycled by reset() once the frame is done, so
+ * the receive path stops churning the general heap.
+ *
+ * The block is allocated lazily, in PSRAM when available. When it is full (or
+ * the capacity is 0) callers fall back to the heap. Not thread safe: an arena
+ * belongs to the task that processes messages for one connection.
+ */
+class message_arena {
+public:
+    static const size_t alignment = 8;
+
+    explicit message_arena(size_t capacity)
+        : m_buffer(nullptr), m_capacity(capacity), m_used(0), m_live(0),
+          m_high_water(0), m_overflows(0) {}
+
+    ~message_arena() {
+        free_memory(m_buffer);
+    }
+
+    message_arena(const message_arena&) = delete;
+    message_arena& operator=(const message_arena&) = delete;
+
+    // returns nullptr when the request doesn't fit, the caller falls back to the heap
+    void* allocate(size_t size) {
+        size = (size + alignment - 1) & ~(alignment - 1);
+        if (m_buffer == nullptr && m_capacity > 0) {
+            m_buffer = static_cast<uint8_t*>(alloc_prefer_psram(m_capacity, 0));
+            if (m_buffer == nullptr) {
+                ESP_LOGW(MEM_TAG, "message arena: allocation failed for %u bytes", (unsigned)m_capacity);
+                m_capacity = 0;
+            }
+        }
+        if (m_buffer == nullptr || size > m_capacity - m_used) {
+            ++m_overflows;
+            return nullptr;
+        }
+        void* ptr = m_buffer + m_used;
+        m_used += size;
+        ++m_live;
+        return ptr;
+    }
+
+    void release() {
+        --m_live;
+    }
+
+    // recycles the block, refused while anything allocated from it is still alive
+    bool reset() {
+        if (m_high_water < m_used) {
+            m_high_water = m_used;
+        }
+        if (m_live != 0) {
+            ESP_LOGW(MEM_TAG, "message arena: %u allocations still alive, not resetting", (unsigned)m_live);
+            return false;
+        }
+        m_used = 0;
+        return true;
+    }
+
+    size_t capacity() const { return m_capacity; }
+    size_t used() const { return m_used; }
+    size_t high_water() const { return m_high_water > m_used ? m_high_water : m_used; }
+    size_t overflows() const { return m_overflows; }
+
+private:
+    uint8_t* m_buffer;
+    size_t m_capacity;
+    size_t m_used;
+    size_t m_live;
+    size_t m_high_water;
+    size_t m_overflows;
+};
+
+/**
+ * The arena arena_alloc() draws from on the calling task, or nullptr.
+ */
+inline message_arena*& current_arena() {
+    static thread_local message_arena* current = nullptr;
+    return current;
+}
+
+/**
+ * Makes an arena current on this task for the lifetime of the scope.
+ * Only wrap library code in it; user callbacks must not run inside one since
+ * the memory is reclaimed when the next frame arrives.
+ */
+class arena_scope {
+public:
+    explicit arena_scope(message_arena& arena) : m_previous(current_arena()) {
+        current_arena() = &arena;
+    }
+
+    ~arena_scope() {
+        current_arena() = m_previous;
+    }
+
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+
+private:
+    message_arena* m_previous;
+};
+
+// every block carries its owning arena (or nullptr for heap blocks) so it can
+// be released without knowing which arena, if any, was current when it was made
+static const size_t ARENA_HEADER_SIZE = message_arena::alignment;
+
+/**
+ * Allocate from the current arena, falling back to the heap. Throws std::bad_alloc.
+ * Release with arena_free().
+ */
+inline void* arena_alloc(size_t size) {
+    message_arena* arena = current_arena();
+    void* block = arena ? arena->allocate(size + ARENA_HEADER_SIZE) : nullptr;
+    if (block == nullptr) {
+        arena = nullptr;
+        block = heap_caps_malloc(size + ARENA_HEADER_SIZE, MALLOC_CAP_DEFAULT);
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    *static_cast<message_arena**>(block) = arena;
+    return static_cast<uint8_t*>(block) + ARENA_HEADER_SIZE;
+}
+
+inline void arena_free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    void* block = static_cast<uint8_t*>(ptr) - ARENA_HEADER_SIZE;
+    message_arena* owner = *static_cast<message_arena**>(block);
+    if (owner) {
+        owner->release();
+    } else {
+        heap_caps_free(block);
+    }
+}
+
+/**
+ * Standard allocator over arena_alloc/arena_free, for containers that only live
+ * while a frame is processed.
+ */
+template<typename T>
+struct arena_allocator {
+    typedef T value_type;
+
+    arena_allocator() noexcept {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_alloc(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        arena_free(ptr);
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const arena_allocator<T>&, const arena_allocator<U>&) { return true; }
+
+template<typename T, typename U>
+inline bool operator!=(const arena_allocator<T>&, const arena_allocator<U>&) { return false; }
+
 } // namespace memory
 } // namespace signalr
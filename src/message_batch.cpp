@@ -0,0 +1,63 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "message_batch.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    message_batch::message_batch(size_t max_size)
+        : m_max_size(max_size), m_depth(0)
+    { }
+
+    void message_batch::cork()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        ++m_depth;
+    }
+
+    bool message_batch::uncork(const std::function<void(std::exception_ptr)>& callback, std::string& payload, callback_list& callbacks)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_depth == 0)
+        {
+            throw signalr_exception("uncork() was called without a matching cork()");
+        }
+
+        m_callbacks.push_back(callback);
+        if (--m_depth > 0)
+        {
+            return false;
+        }
+
+        payload.swap(m_payload);
+        callbacks.swap(m_callbacks);
+        return true;
+    }
+
+    bool message_batch::append(const std::string& message, const std::function<void(std::exception_ptr)>& callback,
+        std::string& full_payload, callback_list& full_callbacks)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_depth == 0)
+        {
+            return false;
+        }
+
+        // the server reads a frame into one buffer, flush early rather than letting the batch outgrow it
+        if (!m_payload.empty() && m_payload.size() + message.size() > m_max_size)
+        {
+            full_payload.swap(m_payload);
+            full_callbacks.swap(m_callbacks);
+        }
+
+        if (m_payload.capacity() < m_max_size)
+        {
+            m_payload.reserve(m_max_size);
+        }
+        m_payload.append(message);
+        m_callbacks.push_back(callback);
+        return true;
+    }
+}
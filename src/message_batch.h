@@ -0,0 +1,47 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // Serialized messages sent between cork() and the outermost uncork(), gathered into one frame. The JSON protocol
+    // ends every message with 0x1E, so the server splits the frame as usual.
+    class message_batch
+    {
+    public:
+        typedef std::vector<std::function<void(std::exception_ptr)>> callback_list;
+
+        // a batch is handed back early rather than growing past `max_size` bytes
+        explicit message_batch(size_t max_size);
+
+        message_batch(const message_batch&) = delete;
+        message_batch& operator=(const message_batch&) = delete;
+
+        void cork();
+
+        // the callback completes with the frame that carries the messages of this scope. Returns true when the
+        // outermost cork was released, the caller then sends `payload` and owns `callbacks`. Throws when there is
+        // no matching cork()
+        bool uncork(const std::function<void(std::exception_ptr)>& callback, std::string& payload, callback_list& callbacks);
+
+        // appends the message while corked, returns false when the caller should send it itself. A batch that
+        // would grow too large is moved into `full_payload` and `full_callbacks` for the caller to send first
+        bool append(const std::string& message, const std::function<void(std::exception_ptr)>& callback,
+            std::string& full_payload, callback_list& full_callbacks);
+
+    private:
+        const size_t m_max_size;
+        std::mutex m_lock;
+        int m_depth;
+        std::string m_payload;
+        callback_list m_callbacks;
+    };
+}
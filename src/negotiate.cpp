@@ -5,7 +5,7 @@
 #include "negotiate.h"
 #include "url_builder.h"
 #include "signalr_exception.h"
-#include "json_helpers.h"
+#include "negotiate_parser.h"
 #include "cancellation_token_source.h"
 
 namespace signalr
@@ -14,15 +14,19 @@ namespace signalr
     {
         const int negotiate_version = 1;
 
-        void negotiate(std::shared_ptr<http_client> client, const std::string& base_url,
+        void negotiate(std::shared_ptr<http_client> client, const url_builder::endpoint& base,
             const signalr_client_config& config,
             std::function<void(negotiation_response&&, std::exception_ptr)> callback, cancellation_token token) noexcept
         {
             std::string negotiate_url;
             try
             {
-                negotiate_url = url_builder::build_negotiate(base_url);
-                negotiate_url = url_builder::add_query_string(negotiate_url, "negotiateVersion=" + std::to_string(negotiate_version));
+                std::string query_string = "negotiateVersion=" + std::to_string(negotiate_version);
+                if (config.is_stateful_reconnect_enabled())
+                {
+                    query_string.append("&useStatefulReconnect=true");
+                }
+                negotiate_url = url_builder::build_negotiate(base, query_string);
             }
             catch (...)
             {
@@ -34,11 +38,40 @@ namespace signalr
             http_request request;
             request.method = http_method::POST;
             request.headers = config.get_http_headers();
+            // a redirect or the negotiate of the next reconnect goes to the same server
+            request.keep_alive = true;
+            request.negotiate = true;
 #ifdef USE_CPPRESTSDK
             request.timeout = config.get_http_client_config().timeout();
 #endif
 
-            client->send(negotiate_url, request, [callback, token](const http_response& http_response, std::exception_ptr exception)
+            // the body is parsed as it arrives, a parse error is kept until the request completes
+            struct parse_state
+            {
+                negotiate_parser parser;
+                std::exception_ptr error;
+                bool streamed = false;
+            };
+            auto state = std::make_shared<parse_state>();
+            request.body_handler = [state](const char* data, size_t length)
+            {
+                state->streamed = true;
+                if (state->error)
+                {
+                    return;
+                }
+
+                try
+                {
+                    state->parser.feed(data, length);
+                }
+                catch (...)
+                {
+                    state->error = std::current_exception();
+                }
+            };
+
+            client->send(negotiate_url, request, [callback, token, state](const http_response& http_response, std::exception_ptr exception)
             {
                 if (exception != nullptr)
                 {
@@ -61,80 +94,40 @@ namespace signalr
 
                 try
                 {
-                    json_value negotiation_response_json;
-                    auto reader = getJsonReader();
-
-                    if (!reader->parse(http_response.content, negotiation_response_json))
+                    if (state->error)
                     {
-                        throw signalr_exception(reader->get_formatted_error_messages());
+                        std::rethrow_exception(state->error);
                     }
 
-                    negotiation_response response;
-
-                    if (negotiation_response_json.is_member("error"))
+                    // http clients without body_handler support hand over the whole body instead
+                    if (!state->streamed)
                     {
-                        response.error = negotiation_response_json["error"].as_string();
-                        callback(std::move(response), nullptr);
-                        return;
+                        state->parser.feed(http_response.content.data(), http_response.content.size());
                     }
+                    state->parser.finish();
 
-                    int server_negotiate_version = 0;
-                    if (negotiation_response_json.is_member("negotiateVersion"))
-                    {
-                        server_negotiate_version = negotiation_response_json["negotiateVersion"].as_int();
-                    }
+                    negotiation_response response = std::move(state->parser.response());
 
-                    if (negotiation_response_json.is_member("connectionId"))
+                    if (!response.error.empty())
                     {
-                        response.connectionId = negotiation_response_json["connectionId"].as_string();
+                        negotiation_response error_response;
+                        error_response.error = std::move(response.error);
+                        callback(std::move(error_response), nullptr);
+                        return;
                     }
 
-                    if (negotiation_response_json.is_member("connectionToken"))
+                    if (state->parser.has_protocol_version())
                     {
-                        response.connectionToken = negotiation_response_json["connectionToken"].as_string();
+                        callback({}, std::make_exception_ptr(
+                            signalr_exception("Detected a connection attempt to an ASP.NET SignalR Server. This client only supports connecting to an ASP.NET Core SignalR Server. See https://aka.ms/signalr-core-differences for details.")));
+                        return;
                     }
 
-                    if (server_negotiate_version <= 0)
+                    if (state->parser.negotiate_version() <= 0)
                     {
                         response.connectionToken = response.connectionId;
                     }
 
-                    if (negotiation_response_json.is_member("availableTransports"))
-                    {
-                        const auto& transports = negotiation_response_json["availableTransports"];
-                        for (size_t i = 0; i < transports.size(); i++)
-                        {
-                            const auto& transportData = transports[i];
-                            available_transport transport;
-                            transport.transport = transportData["transport"].as_string();
-
-                            const auto& formats = transportData["transferFormats"];
-                            for (size_t j = 0; j < formats.size(); j++)
-                            {
-                                transport.transfer_formats.push_back(formats[j].as_string());
-                            }
-
-                            response.availableTransports.push_back(transport);
-                        }
-                    }
-
-                    if (negotiation_response_json.is_member("url"))
-                    {
-                        response.url = negotiation_response_json["url"].as_string();
-
-                        if (negotiation_response_json.is_member("accessToken"))
-                        {
-                            response.accessToken = negotiation_response_json["accessToken"].as_string();
-                        }
-                    }
-
-                    if (negotiation_response_json.is_member("ProtocolVersion"))
-                    {
-                        callback({}, std::make_exception_ptr(
-                            signalr_exception("Detected a connection attempt to an ASP.NET SignalR Server. This client only supports connecting to an ASP.NET Core SignalR Server. See https://aka.ms/signalr-core-differences for details.")));
-                        return;
-                    }
-
                     callback(std::move(response), nullptr);
                 }
                 catch (...)
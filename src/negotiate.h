@@ -7,12 +7,13 @@
 #include "signalr_client_config.h"
 #include "negotiation_response.h"
 #include "http_client.h"
+#include "url_builder.h"
 
 namespace signalr
 {
     namespace negotiate
     {
-        void negotiate(std::shared_ptr<http_client> client, const std::string& base_url,
+        void negotiate(std::shared_ptr<http_client> client, const url_builder::endpoint& base,
             const signalr_client_config& signalr_client_config,
             std::function<void(negotiation_response&&, std::exception_ptr)> callback, cancellation_token token) noexcept;
     }
@@ -0,0 +1,77 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "negotiate_cache.h"
+#include <map>
+#include <mutex>
+
+namespace signalr
+{
+    namespace negotiate_cache
+    {
+        namespace
+        {
+            // a device talks to one or two hubs, anything beyond that is most likely a url with a changing query string
+            constexpr size_t MAX_ENTRIES = 4;
+
+            struct timed_entry
+            {
+                negotiate_cache_entry entry;
+                std::chrono::steady_clock::time_point stored;
+            };
+
+            std::mutex s_lock;
+            std::map<std::string, timed_entry> s_entries;
+        }
+
+        bool lookup(const std::string& base_url, std::chrono::milliseconds ttl, negotiate_cache_entry& entry)
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+
+            auto it = s_entries.find(base_url);
+            if (it == s_entries.end())
+            {
+                return false;
+            }
+
+            if (std::chrono::steady_clock::now() - it->second.stored > ttl)
+            {
+                s_entries.erase(it);
+                return false;
+            }
+
+            entry = it->second.entry;
+            return true;
+        }
+
+        void store(const std::string& base_url, const negotiate_cache_entry& entry)
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+
+            auto now = std::chrono::steady_clock::now();
+            if (s_entries.size() >= MAX_ENTRIES && s_entries.find(base_url) == s_entries.end())
+            {
+                auto oldest = s_entries.begin();
+                for (auto it = s_entries.begin(); it != s_entries.end(); ++it)
+                {
+                    if (it->second.stored < oldest->second.stored)
+                    {
+                        oldest = it;
+                    }
+                }
+                s_entries.erase(oldest);
+            }
+
+            timed_entry& stored = s_entries[base_url];
+            stored.entry = entry;
+            stored.stored = now;
+        }
+
+        void invalidate(const std::string& base_url)
+        {
+            std::lock_guard<std::mutex> lock(s_lock);
+            s_entries.erase(base_url);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+namespace signalr
+{
+    // What a successful negotiate chain ended with, enough to reconnect without repeating it
+    struct negotiate_cache_entry
+    {
+        // url the last negotiate was sent to, after following redirects
+        std::string url;
+        // access token the last redirect handed out, empty if there was none
+        std::string access_token;
+        // the negotiate picked WebSockets, the only transport that can connect without a connection token
+        bool websockets_available = false;
+    };
+
+    // Negotiate results keyed by the base url of the connection, shared by all connections of the program. Entries are
+    // dropped when they get older than the ttl of the lookup or when a start that used them fails.
+    namespace negotiate_cache
+    {
+        // false if there is no entry for `base_url` or it is older than `ttl`
+        bool lookup(const std::string& base_url, std::chrono::milliseconds ttl, negotiate_cache_entry& entry);
+
+        void store(const std::string& base_url, const negotiate_cache_entry& entry);
+
+        void invalidate(const std::string& base_url);
+    }
+}
@@ -0,0 +1,352 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "negotiate_parser.h"
+#include "json_scanner.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    namespace
+    {
+        // access tokens handed out by negotiate redirects are the longest values, a few KB at most
+        constexpr size_t MAX_VALUE_LENGTH = 8192;
+        constexpr size_t MAX_DEPTH = 32;
+
+        bool is_whitespace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        bool is_literal_char(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'E';
+        }
+
+        void read_string_field(const std::string& token, std::string& field)
+        {
+            json_scanner::span value{ token.data(), token.size() };
+            if (!json_scanner::read_string(value, field))
+            {
+                field.clear();
+            }
+        }
+
+        [[noreturn]] void malformed()
+        {
+            throw signalr_exception("negotiate response is not valid JSON");
+        }
+    }
+
+    negotiate_parser::negotiate_parser()
+        : m_state(state::value), m_escape(false), m_capture(false), m_first_in_container(false),
+        m_negotiate_version(0), m_has_protocol_version(false)
+    { }
+
+    void negotiate_parser::feed(const char* data, size_t length)
+    {
+        size_t i = 0;
+        while (i < length)
+        {
+            char c = data[i];
+            switch (m_state)
+            {
+            case state::value:
+                if (!is_whitespace(c))
+                {
+                    begin_value(c);
+                }
+                break;
+
+            case state::key:
+                if (c == '"')
+                {
+                    m_token.clear();
+                    m_state = state::key_string;
+                }
+                else if (c == '}' && m_first_in_container)
+                {
+                    close(c);
+                }
+                else if (!is_whitespace(c))
+                {
+                    malformed();
+                }
+                break;
+
+            case state::key_string:
+                if (m_escape)
+                {
+                    m_escape = false;
+                }
+                else if (c == '\\')
+                {
+                    m_escape = true;
+                }
+                else if (c == '"')
+                {
+                    m_levels.back().key = m_token;
+                    if (m_levels.size() == 1 && m_token == "ProtocolVersion")
+                    {
+                        m_has_protocol_version = true;
+                    }
+                    m_state = state::colon;
+                    break;
+                }
+                append(c);
+                break;
+
+            case state::colon:
+                if (c == ':')
+                {
+                    m_first_in_container = false;
+                    m_state = state::value;
+                }
+                else if (!is_whitespace(c))
+                {
+                    malformed();
+                }
+                break;
+
+            case state::value_string:
+                if (m_escape)
+                {
+                    m_escape = false;
+                }
+                else if (c == '\\')
+                {
+                    m_escape = true;
+                }
+                else if (c == '"')
+                {
+                    if (m_capture)
+                    {
+                        append(c);
+                    }
+                    end_value();
+                    break;
+                }
+                if (m_capture)
+                {
+                    append(c);
+                }
+                break;
+
+            case state::literal:
+                if (!is_literal_char(c))
+                {
+                    // the character that ended the literal belongs to what follows it
+                    end_value();
+                    continue;
+                }
+                if (m_capture)
+                {
+                    append(c);
+                }
+                break;
+
+            case state::separator:
+                if (c == ',')
+                {
+                    m_first_in_container = false;
+                    m_state = m_levels.back().bracket == '{' ? state::key : state::value;
+                }
+                else if (c == '}' || c == ']')
+                {
+                    close(c);
+                }
+                else if (!is_whitespace(c))
+                {
+                    malformed();
+                }
+                break;
+
+            case state::done:
+                if (!is_whitespace(c))
+                {
+                    throw signalr_exception("unexpected data after the negotiate response");
+                }
+                break;
+            }
+            ++i;
+        }
+    }
+
+    void negotiate_parser::finish()
+    {
+        if (m_state != state::done)
+        {
+            throw signalr_exception("negotiate response ended unexpectedly");
+        }
+
+        // the access token only means something together with the url it is for
+        if (m_response.url.empty())
+        {
+            m_response.accessToken.clear();
+        }
+    }
+
+    void negotiate_parser::begin_value(char c)
+    {
+        if (m_levels.empty() && c != '{')
+        {
+            throw signalr_exception("negotiate response is not a JSON object");
+        }
+
+        if (c == '{' || c == '[')
+        {
+            open(c);
+        }
+        else if (c == ']' && m_first_in_container && m_levels.back().bracket == '[')
+        {
+            close(c);
+        }
+        else if (c == '"')
+        {
+            m_capture = wanted();
+            m_token.clear();
+            if (m_capture)
+            {
+                append(c);
+            }
+            m_state = state::value_string;
+        }
+        else if (is_literal_char(c))
+        {
+            m_capture = wanted();
+            m_token.clear();
+            if (m_capture)
+            {
+                append(c);
+            }
+            m_state = state::literal;
+        }
+        else
+        {
+            malformed();
+        }
+    }
+
+    void negotiate_parser::end_value()
+    {
+        m_state = state::separator;
+        if (!m_capture)
+        {
+            return;
+        }
+
+        if (m_levels.size() == 1)
+        {
+            const std::string& key = m_levels[0].key;
+            if (key == "connectionId")
+            {
+                read_string_field(m_token, m_response.connectionId);
+            }
+            else if (key == "connectionToken")
+            {
+                read_string_field(m_token, m_response.connectionToken);
+            }
+            else if (key == "url")
+            {
+                read_string_field(m_token, m_response.url);
+            }
+            else if (key == "accessToken")
+            {
+                read_string_field(m_token, m_response.accessToken);
+            }
+            else if (key == "error")
+            {
+                read_string_field(m_token, m_response.error);
+            }
+            else if (key == "negotiateVersion")
+            {
+                double version;
+                json_scanner::span value{ m_token.data(), m_token.size() };
+                if (json_scanner::read_number(value, version))
+                {
+                    m_negotiate_version = (int)version;
+                }
+            }
+            else if (key == "useStatefulReconnect")
+            {
+                m_response.useStatefulReconnect = m_token == "true";
+            }
+        }
+        else if (m_levels.size() == 3)
+        {
+            read_string_field(m_token, m_response.availableTransports.back().transport);
+        }
+        else
+        {
+            std::string format;
+            read_string_field(m_token, format);
+            m_response.availableTransports.back().transfer_formats.push_back(std::move(format));
+        }
+    }
+
+    void negotiate_parser::open(char bracket)
+    {
+        if (m_levels.size() >= MAX_DEPTH)
+        {
+            throw signalr_exception("negotiate response is nested too deeply");
+        }
+
+        // {"availableTransports":[{...}]}, each object in the array is a transport
+        if (bracket == '{' && m_levels.size() == 2 && m_levels[1].bracket == '[' && m_levels[0].key == "availableTransports")
+        {
+            m_response.availableTransports.push_back(available_transport());
+        }
+
+        level next;
+        next.bracket = bracket;
+        m_levels.push_back(std::move(next));
+        m_first_in_container = true;
+        m_state = bracket == '{' ? state::key : state::value;
+    }
+
+    void negotiate_parser::close(char bracket)
+    {
+        char expected = bracket == '}' ? '{' : '[';
+        if (m_levels.empty() || m_levels.back().bracket != expected)
+        {
+            malformed();
+        }
+
+        m_levels.pop_back();
+        m_first_in_container = false;
+        m_state = m_levels.empty() ? state::done : state::separator;
+    }
+
+    bool negotiate_parser::wanted() const
+    {
+        switch (m_levels.size())
+        {
+        case 1:
+        {
+            const std::string& key = m_levels[0].key;
+            return key == "connectionId" || key == "connectionToken" || key == "url" || key == "accessToken" ||
+                key == "error" || key == "negotiateVersion" || key == "useStatefulReconnect";
+        }
+        case 3:
+            // availableTransports[i].transport
+            return m_levels[0].key == "availableTransports" && m_levels[1].bracket == '[' &&
+                m_levels[2].bracket == '{' && m_levels[2].key == "transport";
+        case 4:
+            // availableTransports[i].transferFormats[j]
+            return m_levels[0].key == "availableTransports" && m_levels[1].bracket == '[' &&
+                m_levels[2].bracket == '{' && m_levels[2].key == "transferFormats" && m_levels[3].bracket == '[';
+        default:
+            return false;
+        }
+    }
+
+    void negotiate_parser::append(char c)
+    {
+        if (m_token.size() >= MAX_VALUE_LENGTH)
+        {
+            throw signalr_exception("negotiate response value is too long");
+        }
+        m_token.push_back(c);
+    }
+}
@@ -0,0 +1,70 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "negotiation_response.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // Push parser for the body of a negotiate response. The body is fed in the chunks it arrives in and only the fields
+    // of a negotiation_response are kept, so neither the whole body nor a DOM of it is ever held in memory. Only the
+    // value currently being read is buffered, and only if it is one of the fields.
+    class negotiate_parser
+    {
+    public:
+        negotiate_parser();
+
+        // throws signalr_exception once the body is known to be malformed
+        void feed(const char* data, size_t length);
+
+        // throws signalr_exception if the body ended before the top level object was closed
+        void finish();
+
+        negotiation_response& response() { return m_response; }
+        int negotiate_version() const { return m_negotiate_version; }
+        // set when the body looks like an ASP.NET (not Core) SignalR negotiate response
+        bool has_protocol_version() const { return m_has_protocol_version; }
+
+    private:
+        enum class state
+        {
+            value,
+            key,
+            colon,
+            separator,
+            key_string,
+            value_string,
+            literal,
+            done
+        };
+
+        struct level
+        {
+            char bracket;
+            std::string key;
+        };
+
+        state m_state;
+        bool m_escape;
+        bool m_capture;
+        bool m_first_in_container;
+        std::string m_token;
+        std::vector<level> m_levels;
+
+        negotiation_response m_response;
+        int m_negotiate_version;
+        bool m_has_protocol_version;
+
+        void begin_value(char c);
+        void end_value();
+        void open(char bracket);
+        void close(char bracket);
+        bool wanted() const;
+        void append(char c);
+    };
+}
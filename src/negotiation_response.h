@@ -23,5 +23,6 @@ namespace signalr
         std::string url;
         std::string accessToken;
         std::string error;
+        bool useStatefulReconnect = false;
     };
 }
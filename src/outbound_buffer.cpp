@@ -0,0 +1,159 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "outbound_buffer.h"
+#include "memory_utils.h"
+#include "signalr_exception.h"
+#include <cstring>
+
+namespace signalr
+{
+    outbound_buffer::outbound_buffer()
+        : m_bytes(0), m_max_messages(0), m_max_bytes(0), m_policy(offline_overflow_policy::drop_oldest),
+        m_flushing(false), m_dropped(0), m_flushed(0)
+    { }
+
+    outbound_buffer::~outbound_buffer()
+    {
+        // callbacks are not invoked from the dtor, the connection that would report the error is going away
+        for (auto& buffered : m_entries)
+        {
+            memory::free_memory(buffered.data);
+        }
+    }
+
+    void outbound_buffer::configure(size_t max_messages, size_t max_bytes, offline_overflow_policy policy)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_max_messages = max_messages;
+        m_max_bytes = max_bytes;
+        m_policy = policy;
+    }
+
+    bool outbound_buffer::offer(const std::string& payload, const std::function<void(std::exception_ptr)>& callback, bool connected)
+    {
+        std::vector<std::function<void(std::exception_ptr)>> dropped;
+        const char* error = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            // with the buffer disabled, messages sent while offline fail in the transport as before
+            if (m_max_messages == 0 || (connected && m_entries.empty() && !m_flushing))
+            {
+                return false;
+            }
+
+            if (payload.size() > m_max_bytes)
+            {
+                error = "message is larger than the offline buffer";
+            }
+            else if (m_policy == offline_overflow_policy::reject_new)
+            {
+                if (m_entries.size() >= m_max_messages || m_bytes + payload.size() > m_max_bytes)
+                {
+                    error = "offline buffer is full, message was dropped";
+                }
+            }
+            else
+            {
+                while (!m_entries.empty() && (m_entries.size() >= m_max_messages || m_bytes + payload.size() > m_max_bytes))
+                {
+                    auto& oldest = m_entries.front();
+                    m_bytes -= oldest.length;
+                    memory::free_memory(oldest.data);
+                    dropped.push_back(std::move(oldest.callback));
+                    m_entries.pop_front();
+                }
+            }
+
+            if (error == nullptr)
+            {
+                auto data = static_cast<char*>(memory::alloc_prefer_psram(payload.size() == 0 ? 1 : payload.size(), 0));
+                if (data == nullptr)
+                {
+                    error = "out of memory buffering message while offline";
+                }
+                else
+                {
+                    memcpy(data, payload.data(), payload.size());
+                    entry buffered;
+                    buffered.data = data;
+                    buffered.length = payload.size();
+                    buffered.callback = callback;
+                    m_entries.push_back(std::move(buffered));
+                    m_bytes += payload.size();
+                }
+            }
+
+            m_dropped += (uint32_t)dropped.size() + (error != nullptr ? 1 : 0);
+        }
+
+        for (auto& dropped_callback : dropped)
+        {
+            dropped_callback(std::make_exception_ptr(signalr_exception("offline buffer is full, message was dropped")));
+        }
+
+        if (error != nullptr)
+        {
+            callback(std::make_exception_ptr(signalr_exception(error)));
+        }
+
+        return true;
+    }
+
+    bool outbound_buffer::take(message_list& messages)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        if (m_entries.empty())
+        {
+            m_flushing = false;
+            return false;
+        }
+
+        m_flushing = true;
+        messages.reserve(messages.size() + m_entries.size());
+        for (auto& buffered : m_entries)
+        {
+            messages.push_back(std::make_pair(std::string(buffered.data, buffered.length), std::move(buffered.callback)));
+            memory::free_memory(buffered.data);
+        }
+
+        m_flushed += (uint32_t)m_entries.size();
+        m_entries.clear();
+        m_bytes = 0;
+        return true;
+    }
+
+    void outbound_buffer::fail_all(std::exception_ptr reason)
+    {
+        std::deque<entry> entries;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            entries.swap(m_entries);
+            m_bytes = 0;
+            m_flushing = false;
+        }
+
+        for (auto& buffered : entries)
+        {
+            memory::free_memory(buffered.data);
+            buffered.callback(reason);
+        }
+    }
+
+    offline_buffer_stats outbound_buffer::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        offline_buffer_stats stats;
+        stats.buffered_messages = m_entries.size();
+        stats.buffered_bytes = m_bytes;
+        stats.dropped_messages = m_dropped;
+        stats.flushed_messages = m_flushed;
+        return stats;
+    }
+}
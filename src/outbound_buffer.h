@@ -0,0 +1,65 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "offline_buffer.h"
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace signalr
+{
+    // Serialized messages sent while the connection is down, kept in PSRAM when available until they can be
+    // flushed in order. Disabled while the message limit is 0.
+    class outbound_buffer
+    {
+    public:
+        typedef std::vector<std::pair<std::string, std::function<void(std::exception_ptr)>>> message_list;
+
+        outbound_buffer();
+        ~outbound_buffer();
+
+        outbound_buffer(const outbound_buffer&) = delete;
+        outbound_buffer& operator=(const outbound_buffer&) = delete;
+
+        void configure(size_t max_messages, size_t max_bytes, offline_overflow_policy policy);
+
+        // buffers the message if the connection is not connected, or if earlier messages have not been flushed yet so
+        // the order is kept. Returns false when the caller should send the message itself. Once it returns true the buffer
+        // owns the callback, which is invoked with an error if the message is dropped
+        bool offer(const std::string& payload, const std::function<void(std::exception_ptr)>& callback, bool connected);
+
+        // moves the buffered messages into `messages`, in order. Returns false, ending the flush, once nothing is left
+        bool take(message_list& messages);
+
+        // drops every buffered message, completing its callback with `reason`
+        void fail_all(std::exception_ptr reason);
+
+        offline_buffer_stats stats() const;
+
+    private:
+        struct entry
+        {
+            char* data;
+            size_t length;
+            std::function<void(std::exception_ptr)> callback;
+        };
+
+        mutable std::mutex m_lock;
+        std::deque<entry> m_entries;
+        size_t m_bytes;
+        size_t m_max_messages;
+        size_t m_max_bytes;
+        offline_overflow_policy m_policy;
+        // set from the first take until the buffer is empty, new messages queue behind the ones being flushed
+        bool m_flushing;
+        uint32_t m_dropped;
+        uint32_t m_flushed;
+    };
+}
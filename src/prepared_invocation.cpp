@@ -0,0 +1,42 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "prepared_invocation.h"
+#include "hub_connection_impl.h"
+#include "invocation_template.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    prepared_invocation::prepared_invocation() noexcept
+    { }
+
+    prepared_invocation::prepared_invocation(const std::weak_ptr<hub_connection_impl>& connection, const std::shared_ptr<invocation_template>& invocation) noexcept
+        : m_connection(connection), m_template(invocation)
+    { }
+
+    void prepared_invocation::send(const std::vector<signalr::value>& arguments, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        auto connection = m_connection.lock();
+        if (!connection || !m_template)
+        {
+            callback(std::make_exception_ptr(signalr_exception("send() cannot be called on a prepared_invocation without a hub_connection")));
+            return;
+        }
+
+        connection->send_prepared(m_template, arguments, callback);
+    }
+
+    void prepared_invocation::invoke(const std::vector<signalr::value>& arguments, std::function<void(const signalr::value&, std::exception_ptr)> callback) noexcept
+    {
+        auto connection = m_connection.lock();
+        if (!connection || !m_template)
+        {
+            callback(signalr::value(), std::make_exception_ptr(signalr_exception("invoke() cannot be called on a prepared_invocation without a hub_connection")));
+            return;
+        }
+
+        connection->invoke_prepared(m_template, arguments, callback);
+    }
+}
@@ -0,0 +1,107 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "raw_arguments.h"
+#include "json_scanner.h"
+#include "json_helpers.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    raw_arguments::raw_arguments() noexcept
+        : m_data(nullptr), m_length(0)
+    { }
+
+    raw_arguments::raw_arguments(const char* data, size_t length) noexcept
+        : m_data(data), m_length(length)
+    { }
+
+    const char* raw_arguments::data() const noexcept
+    {
+        return m_data;
+    }
+
+    size_t raw_arguments::length() const noexcept
+    {
+        return m_length;
+    }
+
+    size_t raw_arguments::size() const
+    {
+        json_scanner::array_reader reader(m_data, m_data + m_length);
+        json_scanner::span element;
+        size_t count = 0;
+        while (reader.next(element))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    bool raw_arguments::raw_at(size_t index, const char*& data, size_t& length) const
+    {
+        json_scanner::array_reader reader(m_data, m_data + m_length);
+        json_scanner::span element;
+        size_t current = 0;
+        while (reader.next(element))
+        {
+            if (current++ == index)
+            {
+                data = element.data;
+                length = element.length;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    signalr::value raw_arguments::decode(size_t index) const
+    {
+        const char* data;
+        size_t length;
+        if (!raw_at(index, data, length))
+        {
+            throw signalr_exception("argument index " + std::to_string(index) + " is out of range");
+        }
+        return createValue(data, length);
+    }
+
+    signalr::compact_value raw_arguments::decode_compact(size_t index) const
+    {
+        const char* data;
+        size_t length;
+        if (!raw_at(index, data, length))
+        {
+            throw signalr_exception("argument index " + std::to_string(index) + " is out of range");
+        }
+        return compact_value::parse(data, length);
+    }
+
+    std::vector<signalr::value> raw_arguments::decode_all() const
+    {
+        std::vector<signalr::value> arguments;
+        if (m_length == 0)
+        {
+            return arguments;
+        }
+
+        json_scanner::array_reader reader(m_data, m_data + m_length);
+        if (!reader.is_array())
+        {
+            throw signalr_exception("Expected 'arguments' to be of type 'array'");
+        }
+
+        json_scanner::span element;
+        while (reader.next(element))
+        {
+            arguments.push_back(createValue(element.data, element.length));
+        }
+        return arguments;
+    }
+
+    std::string raw_arguments::to_string() const
+    {
+        return m_length == 0 ? std::string("[]") : std::string(m_data, m_length);
+    }
+}
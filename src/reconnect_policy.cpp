@@ -0,0 +1,95 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "reconnect_policy.h"
+#include "esp_random.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace signalr
+{
+    namespace
+    {
+        // xorshift32 when seeded, the hardware generator otherwise
+        uint32_t next_random(uint32_t& state)
+        {
+            if (state == 0)
+            {
+                return esp_random();
+            }
+
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // uniform in [low, high]
+        int64_t random_between(uint32_t& state, int64_t low, int64_t high)
+        {
+            if (high <= low)
+            {
+                return low;
+            }
+
+            uint64_t range = (uint64_t)(high - low) + 1;
+            // two draws in order, the operands of | are unsequenced
+            uint64_t high_bits = next_random(state);
+            uint64_t low_bits = next_random(state);
+            uint64_t random = (high_bits << 32) | low_bits;
+            return low + (int64_t)(random % range);
+        }
+
+        void validate(std::chrono::milliseconds base, std::chrono::milliseconds max)
+        {
+            if (base <= std::chrono::milliseconds(0))
+            {
+                throw std::runtime_error("base must be greater than 0.");
+            }
+
+            if (max < base)
+            {
+                throw std::runtime_error("max must not be less than base.");
+            }
+        }
+    }
+
+    exponential_reconnect_policy::exponential_reconnect_policy(std::chrono::milliseconds base, std::chrono::milliseconds max,
+        bool jitter, uint32_t seed)
+        : m_base(base), m_max(max), m_jitter(jitter), m_random_state(seed)
+    {
+        validate(base, max);
+    }
+
+    std::chrono::milliseconds exponential_reconnect_policy::next_delay(const reconnect_context& context)
+    {
+        int64_t ceiling = m_max.count();
+        int shift = std::max(context.previous_attempts, 0);
+        // once base << shift passes max it stays there, and the shift can't overflow
+        if (shift < 62 && (m_base.count() >> (62 - shift)) == 0)
+        {
+            ceiling = std::min(ceiling, (int64_t)m_base.count() << shift);
+        }
+
+        if (!m_jitter)
+        {
+            return std::chrono::milliseconds(ceiling);
+        }
+        return std::chrono::milliseconds(random_between(m_random_state, 0, ceiling));
+    }
+
+    decorrelated_jitter_reconnect_policy::decorrelated_jitter_reconnect_policy(std::chrono::milliseconds base,
+        std::chrono::milliseconds max, uint32_t seed)
+        : m_base(base), m_max(max), m_random_state(seed)
+    {
+        validate(base, max);
+    }
+
+    std::chrono::milliseconds decorrelated_jitter_reconnect_policy::next_delay(const reconnect_context& context)
+    {
+        int64_t previous = std::max((int64_t)context.previous_delay.count(), (int64_t)m_base.count());
+        int64_t high = std::min((int64_t)m_max.count(), previous > m_max.count() / 3 ? (int64_t)m_max.count() : previous * 3);
+        return std::chrono::milliseconds(random_between(m_random_state, m_base.count(), high));
+    }
+}
@@ -0,0 +1,162 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "reconnect_worker.h"
+#include "memory_utils.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <mutex>
+
+namespace
+{
+    inline uint32_t get_reconnect_stack_size() {
+#ifdef CONFIG_SIGNALR_RECONNECT_STACK_SIZE
+        // Use Kconfig value if specified
+        return CONFIG_SIGNALR_RECONNECT_STACK_SIZE;
+#else
+        // Fall back to dynamic sizing based on PSRAM availability
+        return signalr::memory::get_recommended_stack_size("reconnect");
+#endif
+    }
+
+    // requests beyond this fail to queue, one or two per connection are pending at most
+    constexpr UBaseType_t RECONNECT_QUEUE_LENGTH = 8;
+
+    struct job
+    {
+        signalr::reconnect_worker::job_function function;
+        void* param;
+    };
+
+    struct delayed_job
+    {
+        signalr::reconnect_worker::job_function function;
+        void* param;
+        signalr::reconnect_worker::job_function dropped;
+        int retries;
+    };
+
+    // a job that is queued again this long after the queue was found full, up to 5 seconds before it is dropped
+    constexpr TickType_t DELAYED_JOB_RETRY_TICKS = pdMS_TO_TICKS(100);
+    constexpr int DELAYED_JOB_MAX_RETRIES = 50;
+
+    // the worker and its queue live for the rest of the program once created
+    std::mutex s_lock;
+    QueueHandle_t s_queue = nullptr;
+    TaskHandle_t s_task = nullptr;
+
+    void worker_function(void*)
+    {
+        uint32_t stack_allocated = get_reconnect_stack_size();
+        ESP_LOGI("RECONN_WORKER", "reconnect worker started (stack: %u allocated, %u free)",
+            (unsigned)stack_allocated, (unsigned)(uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t)));
+
+        job next;
+        while (true)
+        {
+            if (xQueueReceive(s_queue, &next, portMAX_DELAY) != pdTRUE)
+            {
+                continue;
+            }
+
+            next.function(next.param);
+
+            ESP_LOGD("RECONN_WORKER", "reconnect job done (stack min free: %u, largest free internal block: %u)",
+                (unsigned)(uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t)),
+                (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+        }
+    }
+
+    // runs on the timer service task, which has a small stack, so it only queues the job
+    void delayed_job_due(TimerHandle_t timer)
+    {
+        auto request = static_cast<delayed_job*>(pvTimerGetTimerID(timer));
+        if (!signalr::reconnect_worker::post(request->function, request->param))
+        {
+            // a full queue usually drains quickly. One that does not has a stuck job in front, the owner of the
+            // param gets it back rather than the timer firing forever
+            if (++request->retries < DELAYED_JOB_MAX_RETRIES)
+            {
+                xTimerChangePeriod(timer, DELAYED_JOB_RETRY_TICKS, 0);
+                return;
+            }
+
+            ESP_LOGE("RECONN_WORKER", "dropping a delayed job, the reconnect queue stayed full");
+            request->dropped(request->param);
+        }
+
+        delete request;
+        xTimerDelete(timer, 0);
+    }
+}
+
+namespace signalr
+{
+    namespace reconnect_worker
+    {
+        bool post(job_function function, void* param)
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_lock);
+
+                if (s_queue == nullptr)
+                {
+                    s_queue = xQueueCreate(RECONNECT_QUEUE_LENGTH, sizeof(job));
+                    if (s_queue == nullptr)
+                    {
+                        ESP_LOGE("RECONN_WORKER", "failed to create the reconnect queue");
+                        return false;
+                    }
+                }
+
+                if (s_task == nullptr)
+                {
+                    uint32_t stack = get_reconnect_stack_size();
+                    ESP_LOGI("RECONN_WORKER", "creating reconnect worker with %u byte stack (PSRAM: %s)",
+                        (unsigned)stack, memory::is_psram_available() ? "yes" : "no");
+
+                    if (xTaskCreate(worker_function, "signalr_reconn", stack, nullptr, 5, &s_task) != pdPASS)
+                    {
+                        ESP_LOGE("RECONN_WORKER", "failed to create the reconnect worker (stack=%u)", (unsigned)stack);
+                        s_task = nullptr;
+                        return false;
+                    }
+                }
+            }
+
+            job request{ function, param };
+            if (xQueueSend(s_queue, &request, 0) != pdTRUE)
+            {
+                ESP_LOGE("RECONN_WORKER", "reconnect queue is full");
+                return false;
+            }
+            return true;
+        }
+
+        bool post_after(TickType_t delay, job_function function, void* param, job_function dropped)
+        {
+            if (delay == 0)
+            {
+                return post(function, param);
+            }
+
+            auto request = new delayed_job{ function, param, dropped, 0 };
+            auto timer = xTimerCreate("signalr_delay", delay, pdFALSE, request, delayed_job_due);
+            if (timer == nullptr || xTimerStart(timer, 0) != pdPASS)
+            {
+                ESP_LOGE("RECONN_WORKER", "failed to start the timer of a delayed job");
+                if (timer != nullptr)
+                {
+                    xTimerDelete(timer, 0);
+                }
+                delete request;
+                return false;
+            }
+            return true;
+        }
+    }
+}
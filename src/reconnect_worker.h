@@ -0,0 +1,29 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+namespace signalr
+{
+    // A single long-lived task that runs the reconnect attempts of every hub connection, one at a time and in the order
+    // they were queued. It replaces a task per attempt, whose large stack was allocated and freed again on every failure
+    // of a flapping link until it no longer fit into fragmented internal RAM. Jobs must not wait on their own: delays
+    // go through post_after, so one connection waiting out its backoff does not hold up the others.
+    namespace reconnect_worker
+    {
+        typedef void (*job_function)(void* param);
+
+        // queues `function(param)` and starts the worker on first use. Returns false if the worker could not be started
+        // or the queue is full, `param` still belongs to the caller then
+        bool post(job_function function, void* param);
+
+        // queues `function(param)` once `delay` has passed. The wait runs on a FreeRTOS timer, the worker is free to run
+        // other jobs meanwhile. Returns false if the timer could not be created, `param` still belongs to the caller then.
+        // If the queue stays full for a while after the delay, `dropped(param)` runs instead. It runs on the timer
+        // service task, whose stack is small, so it should only hand `param` on, e.g. to a scheduler
+        bool post_after(TickType_t delay, job_function function, void* param, job_function dropped);
+    }
+}
@@ -0,0 +1,112 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "replay_buffer.h"
+#include "memory_utils.h"
+#include <cstring>
+
+namespace signalr
+{
+    replay_buffer::replay_buffer()
+        : m_bytes(0), m_max_bytes(0), m_first_sequence_id(1), m_complete(true)
+    { }
+
+    replay_buffer::~replay_buffer()
+    {
+        for (auto& sent : m_entries)
+        {
+            memory::free_memory(sent.data);
+        }
+    }
+
+    void replay_buffer::reset(size_t max_bytes)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        while (!m_entries.empty())
+        {
+            drop_front();
+        }
+        m_max_bytes = max_bytes;
+        m_first_sequence_id = 1;
+        m_complete = true;
+    }
+
+    void replay_buffer::add(const std::string& payload)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        while (!m_entries.empty() && m_bytes + payload.size() > m_max_bytes)
+        {
+            drop_front();
+            m_complete = false;
+        }
+
+        auto data = payload.size() > m_max_bytes
+            ? nullptr
+            : static_cast<char*>(memory::alloc_prefer_psram(payload.size() == 0 ? 1 : payload.size(), 0));
+        if (data == nullptr)
+        {
+            // the message still takes its sequence id, the server counts it either way. Nothing before it can be
+            // replayed without a gap anymore
+            while (!m_entries.empty())
+            {
+                drop_front();
+            }
+            ++m_first_sequence_id;
+            m_complete = false;
+            return;
+        }
+
+        memcpy(data, payload.data(), payload.size());
+        entry sent;
+        sent.data = data;
+        sent.length = payload.size();
+        m_entries.push_back(sent);
+        m_bytes += payload.size();
+    }
+
+    void replay_buffer::ack(int64_t sequence_id)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        while (!m_entries.empty() && m_first_sequence_id <= sequence_id)
+        {
+            drop_front();
+        }
+    }
+
+    bool replay_buffer::complete() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_complete;
+    }
+
+    std::vector<std::string> replay_buffer::pending(int64_t& first_sequence_id) const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+
+        std::vector<std::string> messages;
+        messages.reserve(m_entries.size());
+        for (auto& sent : m_entries)
+        {
+            messages.push_back(std::string(sent.data, sent.length));
+        }
+        first_sequence_id = m_first_sequence_id;
+        return messages;
+    }
+
+    size_t replay_buffer::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_entries.size();
+    }
+
+    void replay_buffer::drop_front()
+    {
+        auto& oldest = m_entries.front();
+        m_bytes -= oldest.length;
+        memory::free_memory(oldest.data);
+        m_entries.pop_front();
+        ++m_first_sequence_id;
+    }
+}
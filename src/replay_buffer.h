@@ -0,0 +1,62 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace signalr
+{
+    // Sent messages the server has not acknowledged yet, for stateful reconnect. Messages are numbered from 1 in
+    // the order they were sent and kept in PSRAM when available until an ack covers them. When the byte limit
+    // forces older messages out the buffer is no longer complete and the connection cannot be resumed losslessly.
+    class replay_buffer
+    {
+    public:
+        replay_buffer();
+        ~replay_buffer();
+
+        replay_buffer(const replay_buffer&) = delete;
+        replay_buffer& operator=(const replay_buffer&) = delete;
+
+        // forgets every message and restarts the numbering, called for each new (not resumed) connection
+        void reset(size_t max_bytes);
+
+        // records a message the transport accepted, it gets the next sequence id
+        void add(const std::string& payload);
+
+        // drops every message with an id up to and including `sequence_id`
+        void ack(int64_t sequence_id);
+
+        // false once a message was evicted before it was acknowledged
+        bool complete() const;
+
+        // copies of the unacknowledged messages, in order. `first_sequence_id` is the id of the first one, or the
+        // id the next message will get when nothing is pending
+        std::vector<std::string> pending(int64_t& first_sequence_id) const;
+
+        size_t size() const;
+
+    private:
+        struct entry
+        {
+            char* data;
+            size_t length;
+        };
+
+        void drop_front();
+
+        mutable std::mutex m_lock;
+        std::deque<entry> m_entries;
+        size_t m_bytes;
+        size_t m_max_bytes;
+        // sequence id of m_entries.front(), ids are contiguous from there
+        int64_t m_first_sequence_id;
+        bool m_complete;
+    };
+}
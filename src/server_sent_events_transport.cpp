@@ -0,0 +1,605 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "server_sent_events_transport.h"
+#include "signalr_exception.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <cstring>
+#include <vector>
+
+#pragma warning (push)
+#pragma warning (disable : 5204 4355)
+#include <future>
+#pragma warning (pop)
+
+namespace signalr
+{
+    namespace
+    {
+        // runs the TLS reads of the stream and the message handling of the connection, which the WebSocket transport
+        // spreads over the client task (8KB) and the callback task
+#ifdef CONFIG_SIGNALR_SSE_STACK_SIZE
+        constexpr uint32_t SSE_TASK_STACK_SIZE = CONFIG_SIGNALR_SSE_STACK_SIZE;
+#else
+        constexpr uint32_t SSE_TASK_STACK_SIZE = 10240;
+#endif
+
+#ifdef CONFIG_SIGNALR_CONNECTION_TIMEOUT_MS
+        constexpr unsigned int CONNECTION_TIMEOUT_MS = CONFIG_SIGNALR_CONNECTION_TIMEOUT_MS;
+#else
+        constexpr unsigned int CONNECTION_TIMEOUT_MS = 15000;
+#endif
+
+        // an event growing past this is not a SignalR message, the stream is dropped instead of buffering on
+        constexpr size_t MAX_EVENT_SIZE = 64 * 1024;
+
+        // the server pings within its keep-alive interval, a read that waits longer than the server timeout plus this
+        // margin has lost the connection
+        constexpr std::chrono::seconds STREAM_READ_MARGIN(5);
+
+        // queued sends are joined into one POST up to this size, a larger message goes out on its own
+        constexpr size_t MAX_SEND_BATCH_SIZE = 16 * 1024;
+    }
+
+    struct server_sent_events_transport::stream
+    {
+        std::weak_ptr<server_sent_events_transport> transport;
+        std::shared_ptr<http_client> client;
+        std::string url;
+        http_request request;
+        std::shared_ptr<cancellation_token_source> cts;
+        std::shared_ptr<cancellation_token_source> done;
+        logger log;
+
+        // canceled once the response turned out to be an event stream, or the request ended before it did
+        cancellation_token_source opened;
+        std::mutex opened_lock;
+        bool is_open = false;
+        // start() stopped waiting for the stream, it must not be reported as a disconnect later
+        bool abandoned = false;
+        std::exception_ptr start_error;
+
+        // event stream parser, lines end with \r\n, \n or \r
+        std::string line;
+        bool skip_lf = false;
+        std::string data;
+        bool has_data = false;
+        // a line that is not valid in an event stream, or an event that is too large
+        std::exception_ptr error;
+
+        explicit stream(const logger& logger)
+            : log(logger)
+        { }
+
+        void feed(const char* chunk, size_t length)
+        {
+            size_t position = 0;
+            while (position < length && error == nullptr)
+            {
+                if (skip_lf)
+                {
+                    skip_lf = false;
+                    if (chunk[position] == '\n')
+                    {
+                        ++position;
+                        continue;
+                    }
+                }
+
+                size_t end = position;
+                while (end < length && chunk[end] != '\n' && chunk[end] != '\r')
+                {
+                    ++end;
+                }
+
+                line.append(chunk + position, end - position);
+                if (line.size() + data.size() > MAX_EVENT_SIZE)
+                {
+                    error = std::make_exception_ptr(signalr_exception("server-sent event exceeds the maximum size"));
+                    return;
+                }
+
+                if (end == length)
+                {
+                    return;
+                }
+
+                skip_lf = chunk[end] == '\r';
+                process_line();
+                line.clear();
+                position = end + 1;
+            }
+        }
+
+        void process_line()
+        {
+            if (line.empty())
+            {
+                if (has_data)
+                {
+                    has_data = false;
+                    std::string message;
+                    message.swap(data);
+                    dispatch(std::move(message));
+                }
+                return;
+            }
+
+            auto colon = line.find(':');
+            if (colon == 0)
+            {
+                // comment, the server starts the stream with one to get the response headers out
+                set_open();
+                return;
+            }
+
+            std::string field = line.substr(0, colon);
+            if (field == "data")
+            {
+                size_t value_start = colon == std::string::npos ? line.size() : colon + 1;
+                if (value_start < line.size() && line[value_start] == ' ')
+                {
+                    ++value_start;
+                }
+
+                if (has_data)
+                {
+                    data.push_back('\n');
+                }
+                data.append(line, value_start, std::string::npos);
+                has_data = true;
+                set_open();
+            }
+            else if (field == "event" || field == "id" || field == "retry")
+            {
+                // SignalR sends unnamed events only and does not resume streams by id
+                set_open();
+            }
+            else if (!is_open)
+            {
+                // the body of an error page or a proxy response
+                error = std::make_exception_ptr(signalr_exception("the response is not an event stream"));
+            }
+        }
+
+        void set_open()
+        {
+            {
+                std::lock_guard<std::mutex> lock(opened_lock);
+                if (is_open)
+                {
+                    return;
+                }
+                is_open = true;
+            }
+            opened.cancel();
+        }
+
+        void dispatch(std::string&& message)
+        {
+            auto this_transport = transport.lock();
+            if (!this_transport)
+            {
+                return;
+            }
+
+            bool disconnected;
+            {
+                std::lock_guard<std::mutex> lock(this_transport->m_start_stop_lock);
+                disconnected = this_transport->m_disconnected;
+            }
+            if (disconnected)
+            {
+                return;
+            }
+
+            ESP_LOGD("SSE_TRANSPORT", "received message %zu bytes", message.length());
+            try
+            {
+                this_transport->m_process_response_callback(std::move(message), nullptr);
+            }
+            catch (const std::exception& e)
+            {
+                log.log(trace_level::error, std::string("[server-sent events transport] processing a message failed: ")
+                    .append(e.what()));
+            }
+            catch (...)
+            {
+                log.log(trace_level::error, "[server-sent events transport] processing a message failed");
+            }
+        }
+    };
+
+    std::shared_ptr<signalr::transport> server_sent_events_transport::create(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+        const signalr_client_config& signalr_client_config, const logger& logger)
+    {
+        return std::shared_ptr<transport>(
+            new server_sent_events_transport(http_client_factory, signalr_client_config, logger));
+    }
+
+    server_sent_events_transport::server_sent_events_transport(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+        const signalr_client_config& signalr_client_config, const logger& logger)
+        : transport(logger), m_http_client_factory(http_client_factory), m_signalr_client_config(signalr_client_config),
+        m_process_response_callback([](std::string&&, std::exception_ptr) {}), m_close_callback([](std::exception_ptr) {}),
+        m_disconnected(true), m_stream_cts(std::make_shared<cancellation_token_source>()),
+        m_stream_done(std::make_shared<cancellation_token_source>()), m_sending(false)
+    {
+        // no request is running until start()
+        m_stream_done->cancel();
+    }
+
+    server_sent_events_transport::~server_sent_events_transport()
+    {
+        try
+        {
+            std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+            stop([promise](std::exception_ptr) { promise->set_value(); });
+            promise->get_future().get();
+        }
+        catch (...) // must not throw from the destructor
+        {}
+    }
+
+    transport_type server_sent_events_transport::get_transport_type() const noexcept
+    {
+        return transport_type::server_sent_events;
+    }
+
+    void server_sent_events_transport::receive_task(void* param)
+    {
+        // vTaskDelete does not return, so every local has to be destroyed before it; the transport is
+        // released last, once done is canceled, as its destructor waits for that
+        {
+            auto holder = static_cast<std::shared_ptr<stream>*>(param);
+            std::shared_ptr<stream> this_stream = std::move(*holder);
+            delete holder;
+
+            int status_code = 0;
+            std::exception_ptr exception;
+            this_stream->client->send(this_stream->url, this_stream->request,
+                [&status_code, &exception](const http_response& response, std::exception_ptr request_exception)
+                {
+                    status_code = response.status_code;
+                    exception = request_exception;
+                }, get_cancellation_token(this_stream->cts));
+
+            auto transport = this_stream->transport.lock();
+            if (transport)
+            {
+                transport->stream_ended(this_stream, status_code, exception);
+            }
+
+            auto done = this_stream->done;
+            this_stream.reset();
+            try
+            {
+                done->cancel();
+            }
+            catch (const std::exception& e)
+            {
+                ESP_LOGW("SSE_TRANSPORT", "stop callback threw: %s", e.what());
+            }
+        }
+        vTaskDelete(nullptr);
+    }
+
+    void server_sent_events_transport::stream_ended(const std::shared_ptr<stream>& stream, int status_code, std::exception_ptr exception)
+    {
+        if (stream->error != nullptr)
+        {
+            exception = stream->error;
+        }
+        else if (exception == nullptr)
+        {
+            exception = stream->is_open
+                ? std::make_exception_ptr(signalr_exception("the server closed the event stream"))
+                : std::make_exception_ptr(signalr_exception(
+                    std::string("the event stream request failed with status code ").append(std::to_string(status_code))));
+        }
+
+        bool report;
+        {
+            std::lock_guard<std::mutex> lock(stream->opened_lock);
+            if (!stream->is_open)
+            {
+                // start() is still waiting, it reports the failure
+                stream->is_open = true;
+                stream->start_error = exception;
+                report = false;
+            }
+            else
+            {
+                report = !stream->abandoned;
+            }
+        }
+        stream->opened.cancel();
+
+        if (!report)
+        {
+            return;
+        }
+
+        bool disconnected;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+            disconnected = m_disconnected;
+            // stop() must not call the close callback a second time
+            m_disconnected = true;
+        }
+        if (disconnected)
+        {
+            return;
+        }
+
+        try
+        {
+            std::rethrow_exception(exception);
+        }
+        catch (const std::exception& e)
+        {
+            m_logger.log(trace_level::error, std::string("[server-sent events transport] connection lost: ")
+                .append(e.what()));
+        }
+        m_close_callback(exception);
+    }
+
+    void server_sent_events_transport::start(const std::string& url, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::shared_ptr<stream> this_stream;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+
+            if (!m_disconnected)
+            {
+                callback(std::make_exception_ptr(signalr_exception("transport already connected")));
+                return;
+            }
+
+            // without the query, which carries the connection token
+            m_logger.log(trace_level::info,
+                std::string("[server-sent events transport] connecting to: ")
+                .append(url, 0, url.find('?')));
+
+            try
+            {
+                this_stream = std::make_shared<stream>(m_logger);
+                this_stream->transport = shared_from_this();
+                this_stream->client = m_http_client_factory(m_signalr_client_config);
+                this_stream->url = url;
+                this_stream->request.method = http_method::GET;
+                this_stream->request.headers = m_signalr_client_config.get_http_headers();
+                this_stream->request.headers["Accept"] = "text/event-stream";
+                this_stream->request.timeout = std::chrono::duration_cast<std::chrono::seconds>(
+                    m_signalr_client_config.get_server_timeout()) + STREAM_READ_MARGIN;
+                auto weak_stream = std::weak_ptr<stream>(this_stream);
+                this_stream->request.body_handler = [weak_stream](const char* data, size_t length)
+                {
+                    auto this_stream = weak_stream.lock();
+                    if (!this_stream || this_stream->error != nullptr)
+                    {
+                        return;
+                    }
+
+                    this_stream->feed(data, length);
+                    if (this_stream->error != nullptr)
+                    {
+                        // ends the request, the error is reported when it returns
+                        this_stream->cts->cancel();
+                    }
+                };
+
+                m_stream_cts = std::make_shared<cancellation_token_source>();
+                m_stream_done = std::make_shared<cancellation_token_source>();
+                this_stream->cts = m_stream_cts;
+                this_stream->done = m_stream_done;
+            }
+            catch (...)
+            {
+                callback(std::current_exception());
+                return;
+            }
+
+            m_url = url;
+            m_disconnected = false;
+
+            auto param = new std::shared_ptr<stream>(this_stream);
+            if (xTaskCreate(receive_task, "signalr_sse", SSE_TASK_STACK_SIZE, param, 5, nullptr) != pdPASS)
+            {
+                delete param;
+                m_disconnected = true;
+                m_stream_done->cancel();
+                callback(std::make_exception_ptr(signalr_exception("failed to create the event stream task")));
+                return;
+            }
+        }
+
+        // the callback goes on to send the handshake, which must not run on the task that reads the stream
+        std::exception_ptr exception;
+        const bool timed_out = this_stream->opened.wait(CONNECTION_TIMEOUT_MS) != 0;
+        {
+            std::lock_guard<std::mutex> lock(this_stream->opened_lock);
+            if (!this_stream->is_open || timed_out)
+            {
+                this_stream->abandoned = true;
+                exception = std::make_exception_ptr(signalr_exception("timed out waiting for the event stream"));
+            }
+            else
+            {
+                exception = this_stream->start_error;
+            }
+        }
+
+        if (exception != nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_start_stop_lock);
+                m_disconnected = true;
+            }
+            this_stream->cts->cancel();
+
+            try
+            {
+                std::rethrow_exception(exception);
+            }
+            catch (const std::exception& e)
+            {
+                m_logger.log(trace_level::error,
+                    std::string("[server-sent events transport] exception when connecting to the server: ")
+                    .append(e.what()));
+            }
+            callback(exception);
+            return;
+        }
+
+        callback(nullptr);
+    }
+
+    void server_sent_events_transport::stop(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        std::shared_ptr<cancellation_token_source> stream_cts;
+        std::shared_ptr<cancellation_token_source> stream_done;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+
+            if (m_disconnected)
+            {
+                callback(nullptr);
+                return;
+            }
+
+            m_disconnected = true;
+            stream_cts = m_stream_cts;
+            stream_done = m_stream_done;
+        }
+
+        auto logger = m_logger;
+        auto close_callback = m_close_callback;
+
+        m_logger.log(trace_level::debug, "stopping server-sent events transport");
+
+        try
+        {
+            stream_cts->cancel();
+        }
+        catch (const std::exception& e)
+        {
+            ESP_LOGW("SSE_TRANSPORT", "canceling the event stream threw: %s", e.what());
+        }
+
+        stream_done->register_callback([logger, callback, close_callback]()
+            {
+                logger.log(trace_level::debug, "server-sent events transport stopped");
+
+                close_callback(nullptr);
+
+                callback(nullptr);
+            });
+    }
+
+    void server_sent_events_transport::on_close(std::function<void(std::exception_ptr)> callback)
+    {
+        m_close_callback = callback;
+    }
+
+    void server_sent_events_transport::on_receive(std::function<void(std::string&&, std::exception_ptr)> callback)
+    {
+        m_process_response_callback = callback;
+    }
+
+    void server_sent_events_transport::send(const std::string& payload, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (transfer_format != transfer_format::text)
+        {
+            callback(std::make_exception_ptr(signalr_exception("the server-sent events transport only supports text messages")));
+            return;
+        }
+
+        std::string url;
+        std::shared_ptr<cancellation_token_source> stream_cts;
+        {
+            std::lock_guard<std::mutex> lock(m_start_stop_lock);
+            if (m_disconnected)
+            {
+                callback(std::make_exception_ptr(signalr_exception("cannot send data when the transport is not connected")));
+                return;
+            }
+            url = m_url;
+            stream_cts = m_stream_cts;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_send_lock);
+            m_pending_sends.push_back(pending_send{ payload, callback });
+            if (m_sending)
+            {
+                // the call that is sending takes it along with its next POST
+                return;
+            }
+            m_sending = true;
+        }
+
+        // One POST at a time keeps messages from different tasks in order at the server. Messages are framed by the hub
+        // protocol, so the server reads any number of them from one POST. Callbacks of messages queued by other calls
+        // run on this task.
+        while (true)
+        {
+            std::vector<pending_send> batch;
+            std::string content;
+            {
+                std::lock_guard<std::mutex> lock(m_send_lock);
+                if (m_pending_sends.empty())
+                {
+                    m_sending = false;
+                    return;
+                }
+
+                while (!m_pending_sends.empty() && (batch.empty()
+                    || content.size() + m_pending_sends.front().payload.size() <= MAX_SEND_BATCH_SIZE))
+                {
+                    content.append(m_pending_sends.front().payload);
+                    batch.push_back(std::move(m_pending_sends.front()));
+                    m_pending_sends.pop_front();
+                }
+            }
+
+            if (batch.size() > 1)
+            {
+                ESP_LOGD("SSE_TRANSPORT", "sending %d messages in one request", (int)batch.size());
+            }
+
+            std::exception_ptr exception;
+            try
+            {
+                // the client of the stream is busy until the stream ends, sends get their own
+                http_request request;
+                request.method = http_method::POST;
+                request.headers = m_signalr_client_config.get_http_headers();
+                request.headers["Content-Type"] = "text/plain;charset=UTF-8";
+                request.content = std::move(content);
+                request.timeout = std::chrono::duration_cast<std::chrono::seconds>(m_signalr_client_config.get_server_timeout());
+                m_http_client_factory(m_signalr_client_config)->send(url, request,
+                    [&exception](const http_response& response, std::exception_ptr request_exception)
+                    {
+                        exception = request_exception;
+                        if (exception == nullptr && response.status_code != 200)
+                        {
+                            exception = std::make_exception_ptr(signalr_exception(
+                                std::string("send failed with status code ").append(std::to_string(response.status_code))));
+                        }
+                    }, get_cancellation_token(stream_cts));
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            for (auto& sent : batch)
+            {
+                sent.callback(exception);
+            }
+        }
+    }
+}
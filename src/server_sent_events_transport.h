@@ -0,0 +1,78 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "transport.h"
+#include "logger.h"
+#include "http_client.h"
+#include "signalr_client_config.h"
+#include "cancellation_token_source.h"
+
+namespace signalr
+{
+    // Receives over a streaming GET of text/event-stream and sends as POSTs to the same url, one at a time with the
+    // messages queued meanwhile joined into the next one. It needs no WebSocket upgrade, so it also works behind
+    // proxies that break upgrades, and needs a single task instead of the WebSocket client task plus its callback task.
+    class server_sent_events_transport : public transport, public std::enable_shared_from_this<server_sent_events_transport>
+    {
+    public:
+        static std::shared_ptr<transport> create(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+            const signalr_client_config& signalr_client_config, const logger& logger);
+
+        ~server_sent_events_transport();
+
+        server_sent_events_transport(const server_sent_events_transport&) = delete;
+
+        server_sent_events_transport& operator=(const server_sent_events_transport&) = delete;
+
+        transport_type get_transport_type() const noexcept override;
+
+        void start(const std::string& url, std::function<void(std::exception_ptr)> callback) noexcept override;
+        void stop(std::function<void(std::exception_ptr)> callback) noexcept override;
+        void on_close(std::function<void(std::exception_ptr)> callback) override;
+
+        void send(const std::string& payload, transfer_format transfer_format, std::function<void(std::exception_ptr)> callback) noexcept override;
+
+        void on_receive(std::function<void(std::string&&, std::exception_ptr)>) override;
+
+    private:
+        server_sent_events_transport(const std::function<std::shared_ptr<http_client>(const signalr_client_config&)>& http_client_factory,
+            const signalr_client_config& signalr_client_config, const logger& logger);
+
+        // state of one event stream request, shared by the receive task and start()
+        struct stream;
+
+        struct pending_send
+        {
+            std::string payload;
+            std::function<void(std::exception_ptr)> callback;
+        };
+
+        static void receive_task(void* param);
+        void stream_ended(const std::shared_ptr<stream>& stream, int status_code, std::exception_ptr exception);
+
+        std::function<std::shared_ptr<http_client>(const signalr_client_config&)> m_http_client_factory;
+        signalr_client_config m_signalr_client_config;
+        std::function<void(std::string&&, std::exception_ptr)> m_process_response_callback;
+        std::function<void(std::exception_ptr)> m_close_callback;
+
+        std::mutex m_start_stop_lock;
+        bool m_disconnected;
+        std::string m_url;
+        // canceled by stop() to end the event stream request and the sends in flight
+        std::shared_ptr<cancellation_token_source> m_stream_cts;
+        // canceled once the event stream request has completed, initially canceled since no request is running
+        std::shared_ptr<cancellation_token_source> m_stream_done;
+
+        std::mutex m_send_lock;
+        std::deque<pending_send> m_pending_sends;
+        // a send() call is posting the queue, the others only add to it
+        bool m_sending;
+    };
+}
@@ -8,6 +8,48 @@
 
 namespace signalr
 {
+#ifdef CONFIG_SIGNALR_STREAM_UPLOAD_WINDOW
+    constexpr size_t DEFAULT_STREAM_UPLOAD_WINDOW = CONFIG_SIGNALR_STREAM_UPLOAD_WINDOW;
+#else
+    constexpr size_t DEFAULT_STREAM_UPLOAD_WINDOW = 4;
+#endif
+
+#ifdef CONFIG_SIGNALR_INVOCATION_TIMEOUT_MS
+    constexpr int DEFAULT_INVOCATION_TIMEOUT_MS = CONFIG_SIGNALR_INVOCATION_TIMEOUT_MS;
+#else
+    constexpr int DEFAULT_INVOCATION_TIMEOUT_MS = 0;
+#endif
+
+#ifdef CONFIG_SIGNALR_OFFLINE_BUFFER_MESSAGES
+    constexpr size_t DEFAULT_OFFLINE_BUFFER_MESSAGES = CONFIG_SIGNALR_OFFLINE_BUFFER_MESSAGES;
+#else
+    constexpr size_t DEFAULT_OFFLINE_BUFFER_MESSAGES = 0;
+#endif
+
+#ifdef CONFIG_SIGNALR_OFFLINE_BUFFER_BYTES
+    constexpr size_t DEFAULT_OFFLINE_BUFFER_BYTES = CONFIG_SIGNALR_OFFLINE_BUFFER_BYTES;
+#else
+    constexpr size_t DEFAULT_OFFLINE_BUFFER_BYTES = 8192;
+#endif
+
+#ifdef CONFIG_SIGNALR_STATEFUL_RECONNECT_BUFFER_SIZE
+    constexpr size_t DEFAULT_STATEFUL_RECONNECT_BUFFER_SIZE = CONFIG_SIGNALR_STATEFUL_RECONNECT_BUFFER_SIZE;
+#else
+    constexpr size_t DEFAULT_STATEFUL_RECONNECT_BUFFER_SIZE = 16384;
+#endif
+
+#ifdef CONFIG_SIGNALR_NEGOTIATE_CACHE_TTL_MS
+    constexpr int DEFAULT_NEGOTIATE_CACHE_TTL_MS = CONFIG_SIGNALR_NEGOTIATE_CACHE_TTL_MS;
+#else
+    constexpr int DEFAULT_NEGOTIATE_CACHE_TTL_MS = 0;
+#endif
+
+#ifdef CONFIG_SIGNALR_DNS_CACHE_TTL_MS
+    constexpr int DEFAULT_DNS_CACHE_TTL_MS = CONFIG_SIGNALR_DNS_CACHE_TTL_MS;
+#else
+    constexpr int DEFAULT_DNS_CACHE_TTL_MS = 0;
+#endif
+
 #ifdef USE_CPPRESTSDK
     void signalr_client_config::set_proxy(const web::web_proxy &proxy)
     {
@@ -54,6 +96,17 @@ namespace signalr
         , m_handshake_timeout(std::chrono::seconds(15))
         , m_server_timeout(std::chrono::seconds(30))
         , m_keepalive_interval(std::chrono::seconds(15))
+        , m_stream_upload_window(DEFAULT_STREAM_UPLOAD_WINDOW)
+        , m_invocation_timeout(DEFAULT_INVOCATION_TIMEOUT_MS)
+        , m_offline_buffer_max_messages(DEFAULT_OFFLINE_BUFFER_MESSAGES)
+        , m_offline_buffer_max_bytes(DEFAULT_OFFLINE_BUFFER_BYTES)
+        , m_offline_buffer_policy(offline_overflow_policy::drop_oldest)
+        , m_stateful_reconnect_enabled(false)
+        , m_stateful_reconnect_buffer_size(DEFAULT_STATEFUL_RECONNECT_BUFFER_SIZE)
+        , m_negotiate_cache_ttl(DEFAULT_NEGOTIATE_CACHE_TTL_MS)
+        , m_negotiate_cache_direct_connect(false)
+        , m_dns_cache_ttl(DEFAULT_DNS_CACHE_TTL_MS)
+        , m_dns_cache_websocket_by_address(false)
         , m_auto_reconnect_enabled(false)
         , m_max_reconnect_attempts(-1) // -1 means infinite retries
     {
@@ -154,6 +207,130 @@ namespace signalr
         return m_keepalive_interval;
     }
 
+    void signalr_client_config::set_stream_upload_window(size_t window)
+    {
+        if (window == 0)
+        {
+            throw std::runtime_error("window must be greater than 0.");
+        }
+
+        m_stream_upload_window = window;
+    }
+
+    size_t signalr_client_config::get_stream_upload_window() const noexcept
+    {
+        return m_stream_upload_window;
+    }
+
+    void signalr_client_config::set_invocation_timeout(std::chrono::milliseconds timeout)
+    {
+        if (timeout < std::chrono::milliseconds(0))
+        {
+            throw std::runtime_error("timeout must not be negative.");
+        }
+
+        m_invocation_timeout = timeout;
+    }
+
+    std::chrono::milliseconds signalr_client_config::get_invocation_timeout() const noexcept
+    {
+        return m_invocation_timeout;
+    }
+
+    void signalr_client_config::set_offline_buffer(size_t max_messages, size_t max_bytes, offline_overflow_policy policy)
+    {
+        if (max_messages > 0 && max_bytes == 0)
+        {
+            throw std::runtime_error("max_bytes must be greater than 0 when the offline buffer is enabled.");
+        }
+
+        m_offline_buffer_max_messages = max_messages;
+        m_offline_buffer_max_bytes = max_bytes;
+        m_offline_buffer_policy = policy;
+    }
+
+    size_t signalr_client_config::get_offline_buffer_max_messages() const noexcept
+    {
+        return m_offline_buffer_max_messages;
+    }
+
+    size_t signalr_client_config::get_offline_buffer_max_bytes() const noexcept
+    {
+        return m_offline_buffer_max_bytes;
+    }
+
+    offline_overflow_policy signalr_client_config::get_offline_buffer_policy() const noexcept
+    {
+        return m_offline_buffer_policy;
+    }
+
+    void signalr_client_config::enable_stateful_reconnect(bool enable)
+    {
+        m_stateful_reconnect_enabled = enable;
+    }
+
+    bool signalr_client_config::is_stateful_reconnect_enabled() const noexcept
+    {
+        return m_stateful_reconnect_enabled;
+    }
+
+    void signalr_client_config::set_stateful_reconnect_buffer_size(size_t max_bytes)
+    {
+        if (max_bytes == 0)
+        {
+            throw std::runtime_error("max_bytes must be greater than 0.");
+        }
+
+        m_stateful_reconnect_buffer_size = max_bytes;
+    }
+
+    size_t signalr_client_config::get_stateful_reconnect_buffer_size() const noexcept
+    {
+        return m_stateful_reconnect_buffer_size;
+    }
+
+    void signalr_client_config::set_negotiate_cache(std::chrono::milliseconds ttl, bool connect_directly)
+    {
+        if (ttl.count() < 0)
+        {
+            throw std::runtime_error("ttl must not be negative.");
+        }
+
+        m_negotiate_cache_ttl = ttl;
+        m_negotiate_cache_direct_connect = connect_directly;
+    }
+
+    std::chrono::milliseconds signalr_client_config::get_negotiate_cache_ttl() const noexcept
+    {
+        return m_negotiate_cache_ttl;
+    }
+
+    bool signalr_client_config::is_negotiate_cache_direct_connect() const noexcept
+    {
+        return m_negotiate_cache_direct_connect;
+    }
+
+    void signalr_client_config::set_dns_cache(std::chrono::milliseconds ttl, bool websocket_by_address)
+    {
+        if (ttl.count() < 0)
+        {
+            throw std::runtime_error("ttl must not be negative.");
+        }
+
+        m_dns_cache_ttl = ttl;
+        m_dns_cache_websocket_by_address = websocket_by_address;
+    }
+
+    std::chrono::milliseconds signalr_client_config::get_dns_cache_ttl() const noexcept
+    {
+        return m_dns_cache_ttl;
+    }
+
+    bool signalr_client_config::is_dns_cache_websocket_by_address() const noexcept
+    {
+        return m_dns_cache_websocket_by_address;
+    }
+
     void signalr_client_config::set_reconnect_delays(const std::vector<std::chrono::milliseconds>& delays)
     {
         m_reconnect_delays = delays;
@@ -164,6 +341,16 @@ namespace signalr
         return m_reconnect_delays;
     }
 
+    void signalr_client_config::set_reconnect_policy(std::shared_ptr<reconnect_policy> policy)
+    {
+        m_reconnect_policy = std::move(policy);
+    }
+
+    std::shared_ptr<reconnect_policy> signalr_client_config::get_reconnect_policy() const noexcept
+    {
+        return m_reconnect_policy;
+    }
+
     void signalr_client_config::set_max_reconnect_attempts(int max_attempts)
     {
         m_max_reconnect_attempts = max_attempts;
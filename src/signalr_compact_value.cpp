@@ -0,0 +1,656 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "signalr_compact_value.h"
+#include "signalr_exception.h"
+#include "json_scanner.h"
+#include "memory_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace signalr
+{
+    std::string value_type_to_string(value_type v);
+
+    // 16 bytes per node. Containers point at a contiguous block of child nodes (maps store key/value node pairs sorted
+    // by key), strings of up to 8 bytes live in the node itself, longer ones in the byte area after the nodes.
+    struct compact_node
+    {
+        uint8_t type;
+        uint8_t is_inline;
+        uint16_t reserved;
+        // string length, array element count or map entry count; total storage size for the header node
+        uint32_t count;
+        union
+        {
+            char number[8];     // double, memcpy'd since the allocation is only guaranteed to be 4 byte aligned
+            uint8_t boolean;
+            uint32_t offset;    // first child node index, or byte offset of a string
+            char chars[8];
+        } payload;
+    };
+
+    static_assert(sizeof(compact_node) == 16, "compact_node is expected to be 16 bytes");
+
+    namespace
+    {
+        const size_t max_depth = 32;
+        const size_t inline_capacity = sizeof(compact_node().payload.chars);
+
+        const compact_node null_node = { (uint8_t)value_type::null, 0, 0, 0, { { 0 } } };
+
+        // element/entry count of every container in document order, recorded by the first pass so the second pass can
+        // reserve each container's contiguous child block before filling it. Typical payloads fit the inline buffer.
+        class count_list
+        {
+        public:
+            count_list() : m_size(0) {}
+
+            size_t size() const { return m_size; }
+
+            void push_back(uint32_t count)
+            {
+                if (m_size < inline_count)
+                {
+                    m_inline[m_size] = count;
+                }
+                else
+                {
+                    m_overflow.push_back(count);
+                }
+                ++m_size;
+            }
+
+            uint32_t& operator[](size_t index)
+            {
+                return index < inline_count ? m_inline[index] : m_overflow[index - inline_count];
+            }
+
+        private:
+            static const size_t inline_count = 16;
+            uint32_t m_inline[inline_count];
+            std::vector<uint32_t> m_overflow;
+            size_t m_size;
+        };
+
+        struct layout
+        {
+            size_t nodes;
+            size_t bytes;
+            count_list counts;
+        };
+
+        bool literal_equals(const char* begin, const char* end, const char* literal)
+        {
+            return (size_t)(end - begin) == strlen(literal) && memcmp(begin, literal, (size_t)(end - begin)) == 0;
+        }
+
+        const char* expect(const char* p, const char* end, char c)
+        {
+            p = json_scanner::skip_whitespace(p, end);
+            if (p >= end || *p != c)
+            {
+                throw signalr_exception(std::string("invalid JSON: expected '") + c + "'");
+            }
+            return p + 1;
+        }
+
+        const char* scan_string(const char* p, const char* end)
+        {
+            if (p >= end || *p != '"')
+            {
+                throw signalr_exception("invalid JSON: expected a string");
+            }
+            auto string_end = json_scanner::skip_value(p, end);
+            if (string_end == nullptr)
+            {
+                throw signalr_exception("invalid JSON: unterminated string");
+            }
+            return string_end;
+        }
+
+        void measure_string(size_t escaped_length, layout& layout)
+        {
+            layout.nodes++;
+            // the decoded string is never longer than its escaped form
+            if (escaped_length - 2 > inline_capacity)
+            {
+                layout.bytes += escaped_length - 2;
+            }
+        }
+
+        // first pass: validates structure, counts nodes and string bytes
+        const char* measure(const char* p, const char* end, layout& layout, size_t depth)
+        {
+            if (depth > max_depth)
+            {
+                throw signalr_exception("JSON nesting is too deep");
+            }
+
+            p = json_scanner::skip_whitespace(p, end);
+            if (p >= end)
+            {
+                throw signalr_exception("invalid JSON: unexpected end of input");
+            }
+
+            if (*p == '"')
+            {
+                auto string_end = scan_string(p, end);
+                measure_string((size_t)(string_end - p), layout);
+                return string_end;
+            }
+
+            if (*p == '[' || *p == '{')
+            {
+                bool is_map = *p == '{';
+                char close = is_map ? '}' : ']';
+                layout.nodes++;
+                auto count_index = layout.counts.size();
+                layout.counts.push_back(0);
+
+                p = json_scanner::skip_whitespace(p + 1, end);
+                if (p < end && *p == close)
+                {
+                    return p + 1;
+                }
+
+                uint32_t count = 0;
+                while (true)
+                {
+                    if (is_map)
+                    {
+                        p = json_scanner::skip_whitespace(p, end);
+                        auto key_end = scan_string(p, end);
+                        measure_string((size_t)(key_end - p), layout);
+                        p = expect(key_end, end, ':');
+                    }
+                    p = measure(p, end, layout, depth + 1);
+                    ++count;
+
+                    p = json_scanner::skip_whitespace(p, end);
+                    if (p < end && *p == ',')
+                    {
+                        ++p;
+                        continue;
+                    }
+                    p = expect(p, end, close);
+                    break;
+                }
+                layout.counts[count_index] = count;
+                return p;
+            }
+
+            auto literal_end = json_scanner::skip_value(p, end);
+            if (literal_end == nullptr)
+            {
+                throw signalr_exception("invalid JSON: unexpected character");
+            }
+            layout.nodes++;
+            return literal_end;
+        }
+
+        // second pass: fills the nodes laid out by the first pass
+        class tree_builder
+        {
+        public:
+            tree_builder(compact_node* nodes, char* bytes, size_t bytes_offset, count_list& counts)
+                : m_nodes(nodes), m_next_node(2), m_bytes(bytes), m_bytes_offset(bytes_offset), m_next_byte(0),
+                m_counts(counts), m_next_count(0)
+            { }
+
+            const char* fill(const char* p, const char* end, compact_node& node)
+            {
+                memset(&node, 0, sizeof(node));
+                p = json_scanner::skip_whitespace(p, end);
+
+                switch (*p)
+                {
+                case '"':
+                {
+                    auto string_end = json_scanner::skip_value(p, end);
+                    fill_string(json_scanner::span{ p, (size_t)(string_end - p) }, node);
+                    return string_end;
+                }
+                case '[':
+                case '{':
+                {
+                    bool is_map = *p == '{';
+                    auto count = m_counts[m_next_count++];
+                    auto first = allocate(is_map ? count * 2 : count);
+                    node.type = (uint8_t)(is_map ? value_type::map : value_type::array);
+                    node.count = count;
+                    node.payload.offset = first;
+
+                    ++p;
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        p = json_scanner::skip_whitespace(p, end);
+                        if (*p == ',')
+                        {
+                            p = json_scanner::skip_whitespace(p + 1, end);
+                        }
+
+                        if (is_map)
+                        {
+                            auto key_end = json_scanner::skip_value(p, end);
+                            fill_string(json_scanner::span{ p, (size_t)(key_end - p) }, m_nodes[first + i * 2]);
+                            p = json_scanner::skip_whitespace(key_end, end) + 1; // ':'
+                            p = fill(p, end, m_nodes[first + i * 2 + 1]);
+                        }
+                        else
+                        {
+                            p = fill(p, end, m_nodes[first + i]);
+                        }
+                    }
+
+                    if (is_map)
+                    {
+                        sort_entries(first, count);
+                    }
+                    p = json_scanner::skip_whitespace(p, end);
+                    return p + 1; // closing bracket, validated by the first pass
+                }
+                default:
+                    break;
+                }
+
+                auto literal_end = json_scanner::skip_value(p, end);
+                if (literal_equals(p, literal_end, "true") || literal_equals(p, literal_end, "false"))
+                {
+                    node.type = (uint8_t)value_type::boolean;
+                    node.payload.boolean = *p == 't' ? 1 : 0;
+                }
+                else if (literal_equals(p, literal_end, "null"))
+                {
+                    node.type = (uint8_t)value_type::null;
+                }
+                else
+                {
+                    double number;
+                    if (!json_scanner::read_number(json_scanner::span{ p, (size_t)(literal_end - p) }, number))
+                    {
+                        throw signalr_exception("invalid JSON value: " + std::string(p, (size_t)(literal_end - p)));
+                    }
+                    node.type = (uint8_t)value_type::float64;
+                    memcpy(node.payload.number, &number, sizeof(number));
+                }
+                return literal_end;
+            }
+
+        private:
+            compact_node* m_nodes;
+            uint32_t m_next_node;
+            char* m_bytes;
+            size_t m_bytes_offset;
+            size_t m_next_byte;
+            count_list& m_counts;
+            size_t m_next_count;
+
+            uint32_t allocate(uint32_t count)
+            {
+                auto first = m_next_node;
+                m_next_node += count;
+                return first;
+            }
+
+            void fill_string(const json_scanner::span& value, compact_node& node)
+            {
+                node.type = (uint8_t)value_type::string;
+                size_t length;
+                if (value.length - 2 <= inline_capacity)
+                {
+                    if (!json_scanner::read_string(value, node.payload.chars, length))
+                    {
+                        throw signalr_exception("invalid JSON string");
+                    }
+                    node.is_inline = 1;
+                }
+                else
+                {
+                    char* dest = m_bytes + m_next_byte;
+                    if (!json_scanner::read_string(value, dest, length))
+                    {
+                        throw signalr_exception("invalid JSON string");
+                    }
+
+                    if (length <= inline_capacity)
+                    {
+                        // escapes made it short enough to fit in the node after all
+                        memcpy(node.payload.chars, dest, length);
+                        node.is_inline = 1;
+                    }
+                    else
+                    {
+                        node.payload.offset = (uint32_t)(m_bytes_offset + m_next_byte);
+                        m_next_byte += length;
+                    }
+                }
+                node.count = (uint32_t)length;
+            }
+
+            const char* string_of(const compact_node& node) const
+            {
+                return node.is_inline ? node.payload.chars : reinterpret_cast<const char*>(m_nodes) + node.payload.offset;
+            }
+
+            void sort_entries(uint32_t first, uint32_t count)
+            {
+                struct entry
+                {
+                    compact_node key;
+                    compact_node value;
+                };
+
+                auto entries = reinterpret_cast<entry*>(m_nodes + first);
+                // insertion sort: objects are small, it's stable (first of duplicate keys wins, like the other JSON
+                // paths) and it doesn't need a temporary buffer
+                for (uint32_t i = 1; i < count; ++i)
+                {
+                    entry current = entries[i];
+                    uint32_t j = i;
+                    while (j > 0 && less(current.key, entries[j - 1].key))
+                    {
+                        entries[j] = entries[j - 1];
+                        --j;
+                    }
+                    entries[j] = current;
+                }
+            }
+
+            bool less(const compact_node& a, const compact_node& b) const
+            {
+                auto length = std::min(a.count, b.count);
+                auto result = memcmp(string_of(a), string_of(b), length);
+                return result < 0 || (result == 0 && a.count < b.count);
+            }
+        };
+
+        int compare_key(const char* a, size_t a_length, const char* b, size_t b_length)
+        {
+            auto result = memcmp(a, b, std::min(a_length, b_length));
+            if (result != 0)
+            {
+                return result;
+            }
+            return a_length < b_length ? -1 : (a_length > b_length ? 1 : 0);
+        }
+
+        struct storage_deleter
+        {
+            void operator()(const compact_node* storage) const
+            {
+                memory::free_memory(const_cast<compact_node*>(storage));
+            }
+        };
+    }
+
+    compact_value::compact_value() noexcept
+        : m_node(&null_node)
+    { }
+
+    compact_value::compact_value(const std::shared_ptr<const compact_node>& storage, const compact_node* node) noexcept
+        : m_storage(storage), m_node(node)
+    { }
+
+    compact_value compact_value::parse(const std::string& json)
+    {
+        return parse(json.data(), json.length());
+    }
+
+    compact_value compact_value::parse(const char* json, size_t length)
+    {
+        auto end = json + length;
+        layout layout;
+        layout.nodes = 0;
+        layout.bytes = 0;
+        auto value_end = measure(json, end, layout, 0);
+        if (json_scanner::skip_whitespace(value_end, end) != end)
+        {
+            throw signalr_exception("invalid JSON: unexpected data after the value");
+        }
+
+        // node 0 is a header recording the allocation size, the tree starts at node 1
+        auto bytes_offset = (layout.nodes + 1) * sizeof(compact_node);
+        auto total = bytes_offset + layout.bytes;
+        auto storage = static_cast<compact_node*>(memory::alloc_prefer_psram(total));
+        if (storage == nullptr)
+        {
+            throw signalr_exception("failed to allocate " + std::to_string(total) + " bytes for a compact_value");
+        }
+        std::shared_ptr<const compact_node> owner(storage, storage_deleter());
+
+        memset(&storage[0], 0, sizeof(compact_node));
+        storage[0].count = (uint32_t)total;
+        tree_builder builder(storage, reinterpret_cast<char*>(storage) + bytes_offset, bytes_offset, layout.counts);
+        builder.fill(json, end, storage[1]);
+
+        return compact_value(owner, &storage[1]);
+    }
+
+    bool compact_value::is_map() const
+    {
+        return type() == value_type::map;
+    }
+
+    bool compact_value::is_double() const
+    {
+        return type() == value_type::float64;
+    }
+
+    bool compact_value::is_string() const
+    {
+        return type() == value_type::string;
+    }
+
+    bool compact_value::is_null() const
+    {
+        return type() == value_type::null;
+    }
+
+    bool compact_value::is_array() const
+    {
+        return type() == value_type::array;
+    }
+
+    bool compact_value::is_bool() const
+    {
+        return type() == value_type::boolean;
+    }
+
+    double compact_value::as_double() const
+    {
+        if (!is_double())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'float64'");
+        }
+
+        double number;
+        memcpy(&number, m_node->payload.number, sizeof(number));
+        return number;
+    }
+
+    bool compact_value::as_bool() const
+    {
+        if (!is_bool())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'boolean'");
+        }
+
+        return m_node->payload.boolean != 0;
+    }
+
+    std::string compact_value::as_string() const
+    {
+        return std::string(string_data(), string_length());
+    }
+
+    const char* compact_value::string_data() const
+    {
+        if (!is_string())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'string'");
+        }
+
+        if (m_node->is_inline)
+        {
+            return m_node->payload.chars;
+        }
+        return reinterpret_cast<const char*>(m_storage.get()) + m_node->payload.offset;
+    }
+
+    size_t compact_value::string_length() const
+    {
+        if (!is_string())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'string'");
+        }
+
+        return m_node->count;
+    }
+
+    size_t compact_value::size() const
+    {
+        if (!is_array() && !is_map())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'array' or 'map'");
+        }
+
+        return m_node->count;
+    }
+
+    compact_value compact_value::operator[](size_t index) const
+    {
+        if (!is_array())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'array'");
+        }
+        if (index >= m_node->count)
+        {
+            throw signalr_exception("index " + std::to_string(index) + " is out of range");
+        }
+
+        return compact_value(m_storage, m_storage.get() + m_node->payload.offset + index);
+    }
+
+    compact_value compact_value::operator[](const std::string& key) const
+    {
+        auto found = find(key.data(), key.length());
+        return found == nullptr ? compact_value() : compact_value(m_storage, found);
+    }
+
+    bool compact_value::contains(const std::string& key) const
+    {
+        return find(key.data(), key.length()) != nullptr;
+    }
+
+    std::string compact_value::key_at(size_t index) const
+    {
+        if (!is_map())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'map'");
+        }
+        if (index >= m_node->count)
+        {
+            throw signalr_exception("index " + std::to_string(index) + " is out of range");
+        }
+
+        return compact_value(m_storage, m_storage.get() + m_node->payload.offset + index * 2).as_string();
+    }
+
+    compact_value compact_value::value_at(size_t index) const
+    {
+        if (!is_map())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'map'");
+        }
+        if (index >= m_node->count)
+        {
+            throw signalr_exception("index " + std::to_string(index) + " is out of range");
+        }
+
+        return compact_value(m_storage, m_storage.get() + m_node->payload.offset + index * 2 + 1);
+    }
+
+    const compact_node* compact_value::find(const char* key, size_t length) const
+    {
+        if (!is_map())
+        {
+            throw signalr_exception("object is a '" + value_type_to_string(type()) + "' expected it to be a 'map'");
+        }
+
+        auto entries = m_storage.get() + m_node->payload.offset;
+        size_t low = 0;
+        size_t high = m_node->count;
+        while (low < high)
+        {
+            auto middle = low + (high - low) / 2;
+            compact_value entry_key(m_storage, entries + middle * 2);
+            auto result = compare_key(entry_key.string_data(), entry_key.string_length(), key, length);
+            if (result < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        if (low < m_node->count)
+        {
+            compact_value entry_key(m_storage, entries + low * 2);
+            if (compare_key(entry_key.string_data(), entry_key.string_length(), key, length) == 0)
+            {
+                return entries + low * 2 + 1;
+            }
+        }
+        return nullptr;
+    }
+
+    value_type compact_value::type() const
+    {
+        return (value_type)m_node->type;
+    }
+
+    signalr::value compact_value::to_value() const
+    {
+        switch (type())
+        {
+        case value_type::map:
+        {
+            std::map<std::string, signalr::value> map;
+            for (size_t i = 0; i < m_node->count; ++i)
+            {
+                // insert keeps the first of duplicate keys
+                map.insert(std::make_pair(key_at(i), value_at(i).to_value()));
+            }
+            return signalr::value(std::move(map));
+        }
+        case value_type::array:
+        {
+            std::vector<signalr::value> array;
+            array.reserve(m_node->count);
+            for (size_t i = 0; i < m_node->count; ++i)
+            {
+                array.push_back((*this)[i].to_value());
+            }
+            return signalr::value(std::move(array));
+        }
+        case value_type::string:
+            return signalr::value(string_data(), string_length());
+        case value_type::float64:
+            return signalr::value(as_double());
+        case value_type::boolean:
+            return signalr::value(as_bool());
+        default:
+            return signalr::value();
+        }
+    }
+
+    size_t compact_value::storage_size() const
+    {
+        return m_storage ? m_storage.get()->count : 0;
+    }
+}
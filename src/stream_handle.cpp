@@ -0,0 +1,31 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stream_handle.h"
+#include "stream_item_buffer.h"
+
+namespace signalr
+{
+    stream_handle::stream_handle() noexcept
+    { }
+
+    stream_handle::stream_handle(const std::shared_ptr<stream_item_buffer>& buffer) noexcept
+        : m_buffer(buffer)
+    { }
+
+    void stream_handle::cancel() noexcept
+    {
+        auto buffer = m_buffer.lock();
+        if (buffer)
+        {
+            buffer->cancel();
+        }
+    }
+
+    bool stream_handle::is_active() const noexcept
+    {
+        auto buffer = m_buffer.lock();
+        return buffer && !buffer->is_completed();
+    }
+}
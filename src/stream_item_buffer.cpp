@@ -0,0 +1,167 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stream_item_buffer.h"
+#include "cancellation_token_source.h"
+#include "signalr_exception.h"
+
+namespace signalr
+{
+    std::shared_ptr<stream_item_buffer> stream_item_buffer::create(size_t capacity, const std::shared_ptr<scheduler>& scheduler,
+        const std::function<void(const signalr::value&)>& on_item, const std::function<void(std::exception_ptr)>& on_complete)
+    {
+        return std::shared_ptr<stream_item_buffer>(new stream_item_buffer(capacity, scheduler, on_item, on_complete));
+    }
+
+    stream_item_buffer::stream_item_buffer(size_t capacity, const std::shared_ptr<scheduler>& scheduler,
+        const std::function<void(const signalr::value&)>& on_item, const std::function<void(std::exception_ptr)>& on_complete)
+        : m_capacity(capacity), m_scheduler(scheduler), m_on_item(on_item), m_on_complete(on_complete),
+        m_completed(false), m_draining(false)
+    { }
+
+    void stream_item_buffer::set_cancel_invocation(const std::function<void()>& cancel_invocation)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_cancel_invocation = cancel_invocation;
+    }
+
+    void stream_item_buffer::push(signalr::value&& item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_completed)
+            {
+                // items that were in flight when the stream was canceled
+                return;
+            }
+
+            if (m_items.size() < m_capacity)
+            {
+                m_items.push_back(std::move(item));
+                schedule_drain();
+                return;
+            }
+        }
+
+        abort(std::make_exception_ptr(signalr_exception("stream canceled, more than " + std::to_string(m_capacity)
+            + " items were waiting to be processed")));
+    }
+
+    void stream_item_buffer::complete(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        if (m_completed)
+        {
+            return;
+        }
+
+        m_completed = true;
+        m_error = error;
+        m_cancel_invocation = nullptr;
+        schedule_drain();
+    }
+
+    void stream_item_buffer::cancel()
+    {
+        abort(std::make_exception_ptr(canceled_exception()));
+    }
+
+    bool stream_item_buffer::is_completed() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_completed;
+    }
+
+    void stream_item_buffer::abort(std::exception_ptr reason)
+    {
+        std::function<void()> cancel_invocation;
+
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            if (m_completed)
+            {
+                return;
+            }
+
+            m_completed = true;
+            m_error = reason;
+            m_items.clear();
+            cancel_invocation.swap(m_cancel_invocation);
+            schedule_drain();
+        }
+
+        if (cancel_invocation)
+        {
+            cancel_invocation();
+        }
+    }
+
+    void stream_item_buffer::schedule_drain()
+    {
+        if (m_draining)
+        {
+            return;
+        }
+
+        auto scheduler = m_scheduler.lock();
+        if (!scheduler)
+        {
+            return;
+        }
+
+        m_draining = true;
+        auto self = shared_from_this();
+        scheduler->schedule([self]()
+            {
+                self->drain();
+            });
+    }
+
+    void stream_item_buffer::drain()
+    {
+        while (true)
+        {
+            signalr::value item;
+            std::function<void(std::exception_ptr)> on_complete;
+            std::exception_ptr error;
+
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                if (m_items.empty())
+                {
+                    m_draining = false;
+                    if (!m_completed || !m_on_complete)
+                    {
+                        return;
+                    }
+
+                    // completion is delivered once, after the last item
+                    on_complete.swap(m_on_complete);
+                    error = m_error;
+                    m_on_item = nullptr;
+                }
+                else
+                {
+                    item = std::move(m_items.front());
+                    m_items.pop_front();
+                }
+            }
+
+            if (on_complete)
+            {
+                on_complete(error);
+                return;
+            }
+
+            try
+            {
+                m_on_item(item);
+            }
+            catch (...)
+            {
+                abort(std::current_exception());
+            }
+        }
+    }
+}
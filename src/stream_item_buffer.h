@@ -0,0 +1,62 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "scheduler.h"
+#include "signalr_value.h"
+
+namespace signalr
+{
+    // Holds the items of one server-to-client stream between the receive task and the user callbacks. Items are
+    // delivered in order on the scheduler so a slow `on_item` does not stall the connection; when more than
+    // `capacity` items are waiting the stream is canceled and completed with an error instead of growing the buffer.
+    class stream_item_buffer : public std::enable_shared_from_this<stream_item_buffer>
+    {
+    public:
+        static std::shared_ptr<stream_item_buffer> create(size_t capacity, const std::shared_ptr<scheduler>& scheduler,
+            const std::function<void(const signalr::value&)>& on_item, const std::function<void(std::exception_ptr)>& on_complete);
+
+        stream_item_buffer(const stream_item_buffer&) = delete;
+        stream_item_buffer& operator=(const stream_item_buffer&) = delete;
+
+        // tells the server to stop sending and stops tracking the invocation, invoked at most once
+        void set_cancel_invocation(const std::function<void()>& cancel_invocation);
+
+        void push(signalr::value&& item);
+
+        // completion from the server or the connection, buffered items are still delivered first
+        void complete(std::exception_ptr error);
+
+        // canceled by the user, buffered items are dropped
+        void cancel();
+
+        bool is_completed() const;
+
+    private:
+        stream_item_buffer(size_t capacity, const std::shared_ptr<scheduler>& scheduler,
+            const std::function<void(const signalr::value&)>& on_item, const std::function<void(std::exception_ptr)>& on_complete);
+
+        // must be called with m_lock held
+        void schedule_drain();
+        void drain();
+        void abort(std::exception_ptr reason);
+
+        const size_t m_capacity;
+        std::weak_ptr<scheduler> m_scheduler;
+        std::function<void(const signalr::value&)> m_on_item;
+        std::function<void(std::exception_ptr)> m_on_complete;
+        std::function<void()> m_cancel_invocation;
+
+        mutable std::mutex m_lock;
+        std::deque<signalr::value> m_items;
+        std::exception_ptr m_error;
+        bool m_completed;
+        bool m_draining;
+    };
+}
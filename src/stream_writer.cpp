@@ -0,0 +1,85 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "stream_writer.h"
+#include "client_stream.h"
+
+namespace signalr
+{
+    stream_writer::stream_writer() noexcept
+    { }
+
+    stream_writer::stream_writer(const std::shared_ptr<client_stream>& stream) noexcept
+        : m_stream(stream)
+    { }
+
+    bool stream_writer::write(const signalr::value& item, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (!m_stream)
+        {
+            return false;
+        }
+
+        try
+        {
+            return m_stream->write(item, callback);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    bool stream_writer::complete(std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (!m_stream)
+        {
+            return false;
+        }
+
+        try
+        {
+            return m_stream->complete("", callback);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    bool stream_writer::cancel(const std::string& error, std::function<void(std::exception_ptr)> callback) noexcept
+    {
+        if (!m_stream)
+        {
+            return false;
+        }
+
+        try
+        {
+            return m_stream->complete(error, callback);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    void stream_writer::set_ready_handler(const std::function<void()>& handler) noexcept
+    {
+        if (m_stream)
+        {
+            m_stream->set_ready_handler(handler);
+        }
+    }
+
+    size_t stream_writer::in_flight() const noexcept
+    {
+        return m_stream ? m_stream->in_flight() : 0;
+    }
+
+    bool stream_writer::is_open() const noexcept
+    {
+        return m_stream && m_stream->is_open();
+    }
+}
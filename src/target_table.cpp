@@ -0,0 +1,203 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "target_table.h"
+#include "signalr_exception.h"
+#include <algorithm>
+
+namespace signalr
+{
+    namespace
+    {
+        // Highest displacement tried for a bucket before the table is grown. Displacements are stored as uint16_t.
+        const uint32_t max_displacement = 4096;
+
+        // Tables tried, each a little larger and with a new seed, before giving up on the names.
+        const uint32_t max_build_attempts = 16;
+
+        inline char fold(char c)
+        {
+            return (c >= 'A' && c <= 'Z') ? (char)(c | 0x20) : c;
+        }
+
+        inline uint32_t slot_for(uint32_t hash, uint32_t displacement, size_t slot_count)
+        {
+            // derive a second hash from the first so a lookup only walks the name once
+            uint32_t f1 = (hash >> 16) | (hash << 16);
+            uint32_t f2 = (hash * 0x85ebca6bU) | 1;
+            return (uint32_t)((f1 + displacement * f2) % slot_count);
+        }
+    }
+
+    target_table::target_table()
+        : m_seed(0)
+    { }
+
+    target_table::target_table(const std::vector<std::string>& names)
+        : m_names(names), m_seed(0)
+    {
+        if (m_names.size() > INT16_MAX)
+        {
+            throw signalr_exception("too many hub methods registered");
+        }
+
+        if (m_names.empty())
+        {
+            return;
+        }
+
+        // a slightly oversized table lets construction finish in a few tries without costing much memory
+        size_t slot_count = m_names.size() + m_names.size() / 4 + 1;
+        for (uint32_t attempt = 1; attempt <= max_build_attempts; ++attempt)
+        {
+            if (try_build(slot_count))
+            {
+                return;
+            }
+            slot_count += slot_count / 4 + 1;
+            m_seed = attempt * 0x9e3779b9U;
+        }
+
+        m_names.clear();
+        m_displacements.clear();
+        m_slots.clear();
+    }
+
+    bool target_table::try_build(size_t slot_count)
+    {
+        size_t bucket_count = m_names.size() / 2 + 1;
+        std::vector<std::vector<int>> buckets(bucket_count);
+        std::vector<uint32_t> hashes(m_names.size());
+        for (size_t i = 0; i < m_names.size(); ++i)
+        {
+            hashes[i] = hash(m_names[i].data(), m_names[i].length(), m_seed);
+            buckets[hashes[i] % bucket_count].push_back((int)i);
+        }
+
+        // place the most crowded buckets first while the table is still empty
+        std::vector<size_t> order(bucket_count);
+        for (size_t i = 0; i < bucket_count; ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&buckets](size_t a, size_t b)
+            {
+                return buckets[a].size() > buckets[b].size();
+            });
+
+        m_slots.assign(slot_count, (int16_t)not_found);
+        m_displacements.assign(bucket_count, 0);
+
+        std::vector<uint32_t> candidate;
+        for (auto bucket_index : order)
+        {
+            const auto& bucket = buckets[bucket_index];
+            if (bucket.empty())
+            {
+                break;
+            }
+
+            bool placed = false;
+            for (uint32_t displacement = 0; displacement < max_displacement && !placed; ++displacement)
+            {
+                candidate.clear();
+                placed = true;
+                for (auto name_index : bucket)
+                {
+                    auto slot = slot_for(hashes[name_index], displacement, slot_count);
+                    if (m_slots[slot] != not_found || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+                    {
+                        placed = false;
+                        break;
+                    }
+                    candidate.push_back(slot);
+                }
+
+                if (placed)
+                {
+                    for (size_t i = 0; i < bucket.size(); ++i)
+                    {
+                        m_slots[candidate[i]] = (int16_t)bucket[i];
+                    }
+                    m_displacements[bucket_index] = (uint16_t)displacement;
+                }
+            }
+
+            if (!placed)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int target_table::find(const char* name, size_t length) const
+    {
+        if (m_names.empty())
+        {
+            return not_found;
+        }
+
+        auto h = hash(name, length, m_seed);
+        auto displacement = m_displacements[h % m_displacements.size()];
+        auto index = m_slots[slot_for(h, displacement, m_slots.size())];
+        if (index == not_found || !equals(m_names[(size_t)index], name, length))
+        {
+            return not_found;
+        }
+        return index;
+    }
+
+    int target_table::find(const std::string& name) const
+    {
+        return find(name.data(), name.length());
+    }
+
+    const std::string& target_table::name(int index) const
+    {
+        return m_names.at((size_t)index);
+    }
+
+    size_t target_table::size() const
+    {
+        return m_names.size();
+    }
+
+    uint32_t target_table::hash(const char* name, size_t length, uint32_t seed)
+    {
+        // FNV-1a over the case folded bytes, 32 bit to stay cheap on the ESP32
+        uint32_t h = 2166136261U ^ seed;
+        for (size_t i = 0; i < length; ++i)
+        {
+            h ^= (uint8_t)fold(name[i]);
+            h *= 16777619U;
+        }
+
+        // FNV leaves the low bits weakly mixed and they pick the bucket, finish with an avalanche step
+        h ^= h >> 16;
+        h *= 0x85ebca6bU;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    bool target_table::equals(const std::string& candidate, const char* name, size_t length)
+    {
+        if (candidate.length() != length)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (fold(candidate[i]) != fold(name[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
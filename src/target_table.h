@@ -0,0 +1,48 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace signalr
+{
+    // Immutable, case-insensitive intern table of hub method names. It is compiled once when the connection starts
+    // (handlers can't be registered while connected) into a perfect hash, over a table about a quarter larger than the
+    // number of names, so that a received target can be resolved to a handler index straight from the receive buffer:
+    // one hash pass, one comparison, no allocation. If no table can be built the result is empty and every target is
+    // reported as not_found, which callers resolve by name instead.
+    // Like case_insensitive_equals this only folds ASCII letters, which is what hub method names are in practice.
+    class target_table
+    {
+    public:
+        static const int not_found = -1;
+
+        target_table();
+        explicit target_table(const std::vector<std::string>& names);
+
+        // `name` is the raw target bytes without the surrounding quotes
+        int find(const char* name, size_t length) const;
+        int find(const std::string& name) const;
+
+        const std::string& name(int index) const;
+        size_t size() const;
+
+    private:
+        std::vector<std::string> m_names;
+        // one displacement per bucket, the bucket is picked from the low bits of the hash
+        std::vector<uint16_t> m_displacements;
+        // name index for every slot or not_found
+        std::vector<int16_t> m_slots;
+        // changed when building fails, names that share the whole hash under one seed are apart under another
+        uint32_t m_seed;
+
+        bool try_build(size_t slot_count);
+        static uint32_t hash(const char* name, size_t length, uint32_t seed);
+        static bool equals(const std::string& candidate, const char* name, size_t length);
+    };
+}
@@ -3,8 +3,15 @@
 // See the LICENSE file in the project root for more information.
 
 #include "transport_factory.h"
+#include "sdkconfig.h"
 #include "websocket_transport.h"
 #include "websocket_client.h"
+#ifdef CONFIG_SIGNALR_ENABLE_SSE_TRANSPORT
+#include "server_sent_events_transport.h"
+#endif
+#ifdef CONFIG_SIGNALR_ENABLE_LONG_POLLING_TRANSPORT
+#include "long_polling_transport.h"
+#endif
 #include <stdexcept>
 
 namespace signalr
@@ -23,6 +30,20 @@ namespace signalr
                 logger);
         }
 
+#ifdef CONFIG_SIGNALR_ENABLE_SSE_TRANSPORT
+        if (transport_type == signalr::transport_type::server_sent_events)
+        {
+            return server_sent_events_transport::create(m_http_client_factory, signalr_client_config, logger);
+        }
+#endif
+
+#ifdef CONFIG_SIGNALR_ENABLE_LONG_POLLING_TRANSPORT
+        if (transport_type == signalr::transport_type::long_polling)
+        {
+            return long_polling_transport::create(m_http_client_factory, signalr_client_config, logger);
+        }
+#endif
+
         throw std::runtime_error("not implemented");
     }
 
@@ -3,58 +3,126 @@
 // See the LICENSE file in the project root for more information.
 
 
+#include "url_builder.h"
 #include "uri_builder.h"
-#include "transport_type.h"
 
 namespace signalr
 {
     namespace url_builder
     {
-        uri_builder &convert_to_websocket_url(uri_builder &builder, transport_type transport)
+        namespace
         {
-            if (transport == transport_type::websockets)
+            // same joining rules as uri_builder::append_query
+            void append_query(std::string& query, const std::string& to_append)
+            {
+                if (to_append.empty())
+                {
+                    return;
+                }
+
+                if (!query.empty())
+                {
+                    if (query.back() == '&' && to_append.front() == '&')
+                    {
+                        query.pop_back();
+                    }
+                    else if (query.back() != '&' && to_append.front() != '&')
+                    {
+                        query.push_back('&');
+                    }
+                }
+                query.append(to_append);
+            }
+
+            std::string join(const std::string& scheme, const endpoint& base, const char* command, const std::string& query_string)
             {
-                if (builder.scheme() == "https")
+                std::string query = base.query;
+                append_query(query, query_string);
+
+                std::string url;
+                url.reserve(scheme.size() + base.authority.size() + base.path.size() + 16 + query.size() + base.fragment.size());
+                if (!scheme.empty())
                 {
-                    builder.set_scheme("wss");
+                    url.append(scheme).append(1, ':');
                 }
-                else
+                url.append(base.authority).append(base.path);
+
+                // same joining rules as uri_builder::append_path, the path is canonical already
+                if (command != nullptr)
+                {
+                    if (url.empty() || url.back() != '/')
+                    {
+                        url.push_back('/');
+                    }
+                    url.append(command);
+                }
+
+                if (!query.empty())
                 {
-                    builder.set_scheme("ws");
+                    url.append(1, '?').append(query);
                 }
+                return url.append(base.fragment);
             }
+        }
+
+        endpoint::endpoint(const std::string& base_url)
+            : base_url(base_url)
+        {
+            // the uri constructor canonicalizes: lower case scheme and host, a leading slash on the path
+            uri_builder builder{ uri(base_url) };
 
-            return builder;
+            scheme = builder.scheme();
+            if (!builder.host().empty())
+            {
+                authority.append("//");
+                if (!builder.user_info().empty())
+                {
+                    authority.append(builder.user_info()).append(1, '@');
+                }
+                authority.append(builder.host());
+                if (builder.port() > 0)
+                {
+                    authority.append(1, ':').append(std::to_string(builder.port()));
+                }
+            }
+            path = builder.path();
+            query = builder.query();
+            if (!builder.fragment().empty())
+            {
+                fragment.append(1, '#').append(builder.fragment());
+            }
         }
 
-        uri_builder build_uri(const std::string& base_url, const std::string& command, const std::string& query_string)
+        std::string build_negotiate(const endpoint& base, const std::string& query_string)
         {
-            uri_builder builder(base_url);
-            builder.append_path(command);
-            return builder.append_query(query_string);
+            return join(base.scheme, base, "negotiate", query_string);
         }
 
-        uri_builder build_uri(const std::string& base_url, const std::string& command)
+        std::string build_connect(const endpoint& base, transport_type transport, const std::string& query_string)
         {
-            uri_builder builder(base_url);
-            return builder.append_path(command);
+            if (transport == transport_type::websockets)
+            {
+                static const std::string wss("wss");
+                static const std::string ws("ws");
+                return join(base.scheme == "https" || base.scheme == "wss" ? wss : ws, base, nullptr, query_string);
+            }
+            return join(base.scheme, base, nullptr, query_string);
         }
 
         std::string build_negotiate(const std::string& base_url)
         {
-            return build_uri(base_url, "negotiate").to_string();
+            return build_negotiate(endpoint(base_url), std::string());
         }
 
         std::string build_connect(const std::string& base_url, transport_type transport, const std::string& query_string)
         {
-            auto builder = build_uri(base_url, "", query_string);
-            return convert_to_websocket_url(builder, transport).to_string();
+            return build_connect(endpoint(base_url), transport, query_string);
         }
 
         std::string add_query_string(const std::string& base_url, const std::string& query_string)
         {
-            uri_builder builder(base_url);
-            return builder.append_query(query_string).to_string();
+            endpoint base(base_url);
+            return join(base.scheme, base, nullptr, query_string);
         }
     }
 }
@@ -5,11 +5,35 @@
 #pragma once
 
 #include "transport_type.h"
+#include <string>
 
 namespace signalr
 {
     namespace url_builder
     {
+        // A base url parsed and canonicalized once, so negotiate and connect urls are built by appending to its parts
+        // instead of running the url through uri_builder on every (re)connect
+        struct endpoint
+        {
+            endpoint() = default;
+            // throws uri_exception if `base_url` is not a valid url
+            explicit endpoint(const std::string& base_url);
+
+            // the url the endpoint was made from, as given
+            std::string base_url;
+            // lower case, the transport decides which one the connect url gets
+            std::string scheme;
+            // //[user_info@]host[:port], empty for a url without a host
+            std::string authority;
+            std::string path;
+            std::string query;
+            // with the leading '#', empty if there is none
+            std::string fragment;
+        };
+
+        std::string build_negotiate(const endpoint& base, const std::string& query_string);
+        std::string build_connect(const endpoint& base, transport_type transport, const std::string& query_string);
+
         std::string build_negotiate(const std::string& base_url);
         std::string build_connect(const std::string& base_url, transport_type transport, const std::string& query_string);
         std::string add_query_string(const std::string& base_url, const std::string& query_string);
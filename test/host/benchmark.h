@@ -0,0 +1,90 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+// Timing and heap allocation counting for the host benchmarks. Replaces the global operator new, so include it from
+// exactly one file of a benchmark executable.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace benchmark
+{
+    size_t allocations = 0;
+    size_t allocated_bytes = 0;
+
+    struct result
+    {
+        double ns_per_op;
+        double allocations_per_op;
+        double bytes_per_op;
+    };
+
+    // runs `body`, which performs `ops` operations, a few times and keeps the fastest run
+    template <typename Body>
+    result measure(size_t ops, Body&& body)
+    {
+        result best = { 0, 0, 0 };
+        for (int run = 0; run < 5; ++run)
+        {
+            size_t allocations_before = allocations;
+            size_t bytes_before = allocated_bytes;
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            result current = { elapsed / ops, double(allocations - allocations_before) / ops,
+                double(allocated_bytes - bytes_before) / ops };
+            if (run == 0 || current.ns_per_op < best.ns_per_op)
+            {
+                best = current;
+            }
+        }
+        return best;
+    }
+
+    void report(const char* name, const result& measured)
+    {
+        std::printf("%-48s %10.1f ns/op %8.2f allocs/op %10.1f bytes/op\n", name, measured.ns_per_op,
+            measured.allocations_per_op, measured.bytes_per_op);
+    }
+
+    // keeps the optimizer from dropping a result
+    template <typename T>
+    void keep(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
+
+void* operator new(size_t size)
+{
+    ++benchmark::allocations;
+    benchmark::allocated_bytes += size;
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,49 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark.h"
+#include "callback_manager.h"
+#include <string>
+#include <vector>
+
+using namespace signalr;
+
+namespace
+{
+    // `outstanding` invocations are pending at any time, each round completes the oldest and registers a new one
+    benchmark::result register_and_complete(size_t outstanding, size_t rounds)
+    {
+        callback_manager callbacks("stopped");
+        std::vector<std::string> ids(outstanding);
+        size_t completed = 0;
+        auto on_completion = [&completed](const char*, const signalr::value&) { ++completed; };
+        const signalr::value result;
+
+        for (auto& id : ids)
+        {
+            id = callbacks.register_callback(on_completion);
+        }
+
+        auto measured = benchmark::measure(rounds, [&]()
+            {
+                for (size_t round = 0; round < rounds; ++round)
+                {
+                    auto& oldest = ids[round % outstanding];
+                    callbacks.invoke_callback(oldest, nullptr, result, true);
+                    oldest = callbacks.register_callback(on_completion);
+                }
+            });
+        benchmark::keep(completed);
+        return measured;
+    }
+}
+
+int main()
+{
+    const size_t rounds = 1000000;
+    benchmark::report("register + complete, 1 outstanding", register_and_complete(1, rounds));
+    benchmark::report("register + complete, 64 outstanding", register_and_complete(64, rounds));
+    benchmark::report("register + complete, 256 outstanding", register_and_complete(256, rounds));
+    return 0;
+}
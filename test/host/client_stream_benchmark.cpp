@@ -0,0 +1,132 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark.h"
+#include "client_stream.h"
+#include "host_scheduler.h"
+#include <condition_variable>
+
+using namespace signalr;
+
+namespace
+{
+    // stands in for the JSON hub protocol, which needs cJSON, with the same framing of a stream item
+    std::string serialize(const hub_message& message)
+    {
+        const auto& item = static_cast<const stream_item_message&>(message);
+        char buffer[96];
+        int length = std::snprintf(buffer, sizeof(buffer), "{\"type\":2,\"invocationId\":\"%s\",\"item\":%g}\x1e",
+            item.invocation_id.c_str(), item.item.as_double());
+        return std::string(buffer, length);
+    }
+
+    // the fields invocation_message copies for a send, which cannot be linked here since its view of received
+    // arguments needs cJSON
+    struct send_invocation : hub_invocation_message
+    {
+        send_invocation(const std::string& target, const std::vector<signalr::value>& arguments)
+            : hub_invocation_message("", signalr::message_type::invocation), target(target), arguments(arguments)
+        { }
+
+        std::string target;
+        std::vector<signalr::value> arguments;
+        std::vector<std::string> stream_ids;
+    };
+
+    std::string serialize_invocation(const send_invocation& invocation)
+    {
+        char buffer[96];
+        int length = std::snprintf(buffer, sizeof(buffer), "{\"type\":1,\"target\":\"%s\",\"arguments\":[%g]}\x1e",
+            invocation.target.c_str(), invocation.arguments[0].as_double());
+        return std::string(buffer, length);
+    }
+
+    // what hub_connection::send does for every sample short of the JSON protocol: an invocation with the sample as
+    // its one argument, serialized and handed to the same transport
+    benchmark::result send_samples(size_t count)
+    {
+        size_t sent_bytes = 0;
+        auto sender = [&sent_bytes](const std::string& payload, std::function<void(std::exception_ptr)> callback)
+            {
+                sent_bytes += payload.size();
+                callback(nullptr);
+            };
+
+        size_t completed = 0;
+        auto measured = benchmark::measure(count, [&]()
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const std::vector<signalr::value> arguments{ signalr::value(20.0 + (i % 100) * 0.1) };
+                    send_invocation invocation("Send", arguments);
+                    std::function<void(std::exception_ptr)> callback = [&completed](std::exception_ptr) { ++completed; };
+                    sender(serialize_invocation(invocation), [callback](std::exception_ptr e) { callback(e); });
+                }
+            });
+        benchmark::keep(sent_bytes + completed);
+        return measured;
+    }
+
+    // streams `count` samples through a window of `window` messages to a transport that completes every send at once
+    benchmark::result stream_samples(size_t count, size_t window)
+    {
+        auto scheduler = std::make_shared<host_scheduler>();
+        size_t sent_bytes = 0;
+        auto stream = client_stream::create("1", window, scheduler, serialize,
+            [&sent_bytes](const std::string& payload, std::function<void(std::exception_ptr)> callback)
+            {
+                sent_bytes += payload.size();
+                callback(nullptr);
+            });
+
+        std::mutex lock;
+        std::condition_variable ready;
+        stream->set_ready_handler([&]()
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ready.notify_one();
+            });
+
+        std::mutex done_lock;
+        std::condition_variable done;
+        size_t completed = 0;
+        auto on_sent = [&](std::exception_ptr)
+            {
+                std::lock_guard<std::mutex> guard(done_lock);
+                if (++completed == count)
+                {
+                    done.notify_one();
+                }
+            };
+
+        auto measured = benchmark::measure(count, [&]()
+            {
+                completed = 0;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const signalr::value sample(20.0 + (i % 100) * 0.1);
+                    while (!stream->write(sample, on_sent))
+                    {
+                        std::unique_lock<std::mutex> guard(lock);
+                        ready.wait_for(guard, std::chrono::milliseconds(1));
+                    }
+                }
+
+                std::unique_lock<std::mutex> guard(done_lock);
+                done.wait(guard, [&]() { return completed == count; });
+            });
+        benchmark::keep(sent_bytes);
+        return measured;
+    }
+}
+
+int main()
+{
+    const size_t samples = 100000;
+    benchmark::report("send per sample", send_samples(samples));
+    benchmark::report("client_stream, window 1", stream_samples(samples, 1));
+    benchmark::report("client_stream, window 8", stream_samples(samples, 8));
+    benchmark::report("client_stream, window 64", stream_samples(samples, 64));
+    return 0;
+}
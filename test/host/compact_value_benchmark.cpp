@@ -0,0 +1,89 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark.h"
+#include "signalr_compact_value.h"
+#include <string>
+
+using namespace signalr;
+
+namespace
+{
+    // the arguments of one sensor update
+    std::string small_payload()
+    {
+        return "{\"deviceId\":\"esp32-0042\",\"temperature\":23.5,\"humidity\":41.2,\"online\":true}";
+    }
+
+    // a batch of 50 readings
+    std::string telemetry_payload()
+    {
+        std::string json = "[";
+        for (int i = 0; i < 50; ++i)
+        {
+            json.append(i == 0 ? "" : ",").append("{\"t\":").append(std::to_string(1700000000 + i))
+                .append(",\"sensor\":\"temperature\",\"value\":").append(std::to_string(21.5 + i * 0.1))
+                .append(",\"unit\":\"C\",\"flags\":[1,0,2]}");
+        }
+        return json.append("]");
+    }
+
+    // a configuration pushed by the server, nested maps with mostly string settings
+    std::string config_payload()
+    {
+        std::string json = "{\"version\":7,\"groups\":{";
+        for (int group = 0; group < 5; ++group)
+        {
+            json.append(group == 0 ? "" : ",").append("\"group").append(std::to_string(group)).append("\":{");
+            for (int setting = 0; setting < 8; ++setting)
+            {
+                json.append(setting == 0 ? "" : ",").append("\"setting").append(std::to_string(setting))
+                    .append("\":\"").append(setting % 2 ? "on" : "https://example.com/firmware/channel/stable")
+                    .append("\"");
+            }
+            json.append("}");
+        }
+        return json.append("},\"enabled\":true}");
+    }
+
+    void run(const char* name, const std::string& json)
+    {
+        const size_t repeats = 20000;
+
+        compact_value parsed = compact_value::parse(json);
+        auto parse = benchmark::measure(repeats, [&]()
+            {
+                for (size_t i = 0; i < repeats; ++i)
+                {
+                    auto value = compact_value::parse(json);
+                    benchmark::keep(value);
+                }
+            });
+
+        // what the signalr::value tree the payload used to be converted into costs on its own, without the cJSON
+        // parse and DOM that came before it
+        auto convert = benchmark::measure(repeats, [&]()
+            {
+                for (size_t i = 0; i < repeats; ++i)
+                {
+                    auto value = parsed.to_value();
+                    benchmark::keep(value);
+                }
+            });
+
+        std::printf("%s, %u bytes of JSON:\n", name, (unsigned)json.size());
+        // the tree itself comes from heap_caps_malloc, the allocations counted here are temporaries of the parse
+        benchmark::report("  compact_value::parse", parse);
+        std::printf("%-48s %10u bytes\n", "  compact tree held, one allocation", (unsigned)parsed.storage_size());
+        benchmark::report("  compact_value::to_value (signalr::value tree)", convert);
+    }
+}
+
+int main()
+{
+    run("sensor update", small_payload());
+    run("telemetry batch", telemetry_payload());
+    run("configuration", config_payload());
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+#include "scheduler.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// runs the callbacks in order on one thread, like the default scheduler on the device. Delays are not honored, the
+// code the benchmarks drive does not schedule with one
+class host_scheduler : public signalr::scheduler
+{
+public:
+    host_scheduler() : m_stopped(false), m_thread([this]() { run(); }) { }
+
+    ~host_scheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stopped = true;
+        }
+        m_changed.notify_one();
+        m_thread.join();
+    }
+
+    void schedule(const signalr::signalr_base_cb& cb, std::chrono::milliseconds) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_callbacks.push_back(cb);
+        }
+        m_changed.notify_one();
+    }
+
+private:
+    void run()
+    {
+        while (true)
+        {
+            signalr::signalr_base_cb callback;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_changed.wait(lock, [this]() { return m_stopped || !m_callbacks.empty(); });
+                if (m_callbacks.empty())
+                {
+                    return;
+                }
+                callback = std::move(m_callbacks.front());
+                m_callbacks.pop_front();
+            }
+            callback();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_changed;
+    std::deque<signalr::signalr_base_cb> m_callbacks;
+    bool m_stopped;
+    std::thread m_thread;
+};
@@ -0,0 +1,101 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "json_scanner.h"
+#include <cstdio>
+#include <string>
+
+using namespace signalr;
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { ++failures; std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } } while (0)
+
+    // decodes `json`, a string value with its quotes, through both overloads and checks they agree
+    bool decode(const std::string& json, std::string& out)
+    {
+        json_scanner::span value{ json.data(), json.size() };
+
+        std::string buffer(json.size(), '\xff');
+        size_t length = 0;
+        bool in_place = json_scanner::read_string(value, &buffer[0], length);
+
+        bool copied = json_scanner::read_string(value, out);
+        CHECK(in_place == copied);
+        if (in_place && copied)
+        {
+            CHECK(out == buffer.substr(0, length));
+        }
+        return copied;
+    }
+
+    void plain_and_escaped_strings_decode()
+    {
+        std::string out;
+        CHECK(decode("\"hello\"", out) && out == "hello");
+        CHECK(decode("\"\"", out) && out.empty());
+        CHECK(decode("\"a\\\"b\\\\c\\/d\\n\\t\"", out) && out == "a\"b\\c/d\n\t");
+        CHECK(decode("\"\\u00e9\\u20ac\"", out) && out == "\xc3\xa9\xe2\x82\xac");
+    }
+
+    void surrogate_pairs_decode_to_four_bytes()
+    {
+        std::string out;
+        CHECK(decode("\"\\ud83d\\ude00\"", out) && out == "\xf0\x9f\x98\x80");
+        CHECK(decode("\"x\\uD834\\uDD1Ey\"", out) && out == "x\xf0\x9d\x84\x9ey");
+    }
+
+    void unpaired_surrogates_are_rejected()
+    {
+        std::string out;
+        CHECK(!decode("\"\\ud83d\"", out));
+        CHECK(!decode("\"\\ud83dabcdef\"", out));
+        CHECK(!decode("\"\\ud83d\\u0041\"", out));
+        CHECK(!decode("\"\\ud83d\\ud83d\"", out));
+        CHECK(!decode("\"\\ude00\"", out));
+        CHECK(!decode("\"\\ude00\\ud83d\"", out));
+    }
+
+    void nul_ends_the_string()
+    {
+        std::string out;
+        CHECK(decode("\"abc\\u0000def\"", out) && out == "abc");
+        CHECK(decode("\"\\u0000\"", out) && out.empty());
+        CHECK(out.find('\0') == std::string::npos);
+
+        // the rest of the string is still checked
+        CHECK(!decode("\"abc\\u0000\\q\"", out));
+        CHECK(!decode("\"abc\\u0000\\ud83d\"", out));
+    }
+
+    void malformed_escapes_are_rejected()
+    {
+        std::string out;
+        CHECK(!decode("\"\\u12\"", out));
+        CHECK(!decode("\"\\u12g4\"", out));
+        CHECK(!decode("\"\\x\"", out));
+        CHECK(!decode("\"abc\\\"", out));
+        CHECK(!decode("abc", out));
+    }
+}
+
+int main()
+{
+    plain_and_escaped_strings_decode();
+    surrogate_pairs_decode_to_four_bytes();
+    unpaired_surrogates_are_rejected();
+    nul_ends_the_string();
+    malformed_escapes_are_rejected();
+
+    if (failures != 0)
+    {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark.h"
+#include "message_batch.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace signalr;
+
+namespace
+{
+    // what the transport was handed, one send is one websocket frame
+    struct frame_counter
+    {
+        size_t frames = 0;
+        size_t bytes = 0;
+        size_t completed = 0;
+
+        void send(const std::string& payload, const message_batch::callback_list& callbacks)
+        {
+            ++frames;
+            bytes += payload.size();
+            for (auto& callback : callbacks)
+            {
+                callback(nullptr);
+            }
+        }
+
+        void send(const std::string& payload, const std::function<void(std::exception_ptr)>& callback)
+        {
+            ++frames;
+            bytes += payload.size();
+            callback(nullptr);
+        }
+    };
+
+    std::vector<std::string> make_burst(size_t count, size_t argument_length)
+    {
+        std::vector<std::string> messages;
+        for (size_t i = 0; i < count; ++i)
+        {
+            messages.push_back(std::string("{\"type\":1,\"target\":\"Telemetry\",\"arguments\":[\"")
+                .append(argument_length, 'a' + i % 26).append("\"]}\x1e"));
+        }
+        return messages;
+    }
+
+    // the path of hub_connection_impl::send_message once a message is serialized
+    void send_message(message_batch& batch, frame_counter& transport, const std::string& message,
+        const std::function<void(std::exception_ptr)>& callback)
+    {
+        std::string full_batch;
+        message_batch::callback_list full_batch_callbacks;
+        if (!batch.append(message, callback, full_batch, full_batch_callbacks))
+        {
+            transport.send(message, callback);
+            return;
+        }
+
+        if (!full_batch.empty())
+        {
+            transport.send(full_batch, full_batch_callbacks);
+        }
+    }
+
+    void run_burst(const char* name, const std::vector<std::string>& burst, bool corked, size_t bursts)
+    {
+        message_batch batch(4096);
+        frame_counter transport;
+        size_t message_callbacks = 0;
+        size_t runs = 0;
+        auto on_sent = [&message_callbacks](std::exception_ptr) { ++message_callbacks; };
+
+        auto measured = benchmark::measure(bursts, [&]()
+            {
+                ++runs;
+                for (size_t i = 0; i < bursts; ++i)
+                {
+                    if (corked)
+                    {
+                        batch.cork();
+                    }
+
+                    for (auto& message : burst)
+                    {
+                        send_message(batch, transport, message, on_sent);
+                    }
+
+                    std::string payload;
+                    message_batch::callback_list callbacks;
+                    if (corked && batch.uncork([](std::exception_ptr) {}, payload, callbacks))
+                    {
+                        transport.send(payload, callbacks);
+                    }
+                }
+            });
+        benchmark::keep(transport.bytes);
+
+        // the counts are the same for every run
+        const double total_bursts = static_cast<double>(runs * bursts);
+        benchmark::report(name, measured);
+        std::printf("    %.2f frames per burst, %.0f bytes per frame, %.2f message callbacks per burst\n",
+            transport.frames / total_bursts, static_cast<double>(transport.bytes) / transport.frames,
+            message_callbacks / total_bursts);
+    }
+}
+
+int main()
+{
+    const size_t bursts = 20000;
+    auto small = make_burst(20, 8);
+    auto large = make_burst(20, 300);
+
+    std::printf("bursts of 20 messages of %zu bytes\n", small[0].size());
+    run_burst("  one send per message", small, false, bursts);
+    run_burst("  corked", small, true, bursts);
+
+    std::printf("bursts of 20 messages of %zu bytes, over the 4096 byte frame limit\n", large[0].size());
+    run_burst("  one send per message", large, false, bursts);
+    run_burst("  corked", large, true, bursts);
+    return 0;
+}
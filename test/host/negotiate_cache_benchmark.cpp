@@ -0,0 +1,178 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "connection_impl.h"
+#include "host_scheduler.h"
+#include "http_client.h"
+#include "websocket_client.h"
+#include "signalr_exception.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <thread>
+
+using namespace signalr;
+
+namespace
+{
+    // The server end of the link: every HTTP request and every WebSocket connect costs `request_time`, standing in for
+    // the TCP and TLS handshakes and the request itself. The first negotiate redirects to the hub service with an
+    // access token, like Azure SignalR does.
+    struct stub_server
+    {
+        std::chrono::milliseconds request_time{ 0 };
+        std::atomic<int> negotiates{ 0 };
+        std::atomic<int> websocket_connects{ 0 };
+
+        void wait() const
+        {
+            if (request_time.count() > 0)
+            {
+                std::this_thread::sleep_for(request_time);
+            }
+        }
+    };
+
+    stub_server server;
+
+    class stub_http_client : public http_client
+    {
+    public:
+        void send(const std::string& url, http_request& request,
+            std::function<void(const http_response&, std::exception_ptr)> callback, cancellation_token) override
+        {
+            server.wait();
+            ++server.negotiates;
+
+            std::string body = url.find("//service.local/") != std::string::npos
+                ? "{\"negotiateVersion\":1,\"connectionId\":\"a1b2\",\"connectionToken\":\"c3d4\","
+                  "\"availableTransports\":[{\"transport\":\"WebSockets\",\"transferFormats\":[\"Text\",\"Binary\"]}]}"
+                : "{\"url\":\"http://service.local/client/?hub=chat\",\"accessToken\":\"eyJhbGciOiJIUzI1NiJ9.e30.c2ln\"}";
+
+            http_response response(200, "");
+            if (request.body_handler)
+            {
+                request.body_handler(body.data(), body.size());
+            }
+            else
+            {
+                response.content = body;
+            }
+            callback(response, nullptr);
+        }
+    };
+
+    class stub_websocket_client : public websocket_client
+    {
+    public:
+        void start(const std::string&, std::function<void(std::exception_ptr)> callback) override
+        {
+            server.wait();
+            ++server.websocket_connects;
+            callback(nullptr);
+        }
+
+        void stop(std::function<void(std::exception_ptr)> callback) override
+        {
+            std::function<void(const std::string&, std::exception_ptr)> receive;
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                receive.swap(m_receive);
+            }
+            if (receive)
+            {
+                receive("", std::make_exception_ptr(canceled_exception()));
+            }
+            callback(nullptr);
+        }
+
+        void send(const std::string&, transfer_format, std::function<void(std::exception_ptr)> callback) override
+        {
+            callback(nullptr);
+        }
+
+        void receive(std::function<void(const std::string&, std::exception_ptr)> callback) override
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_receive = callback;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::function<void(const std::string&, std::exception_ptr)> m_receive;
+    };
+
+    // starts a connection to `url` `starts` times and reports the mean time from start() to connected
+    void measure_starts(const char* name, const std::string& url, std::chrono::milliseconds cache_ttl, bool connect_directly, int starts)
+    {
+        signalr_client_config config;
+        config.set_scheduler(std::make_shared<host_scheduler>());
+        config.set_negotiate_cache(cache_ttl, connect_directly);
+
+        // the first start fills the cache
+        double total_us = 0;
+        int negotiates = 0;
+        int connects = 0;
+        for (int i = 0; i <= starts; ++i)
+        {
+            auto connection = connection_impl::create(url, trace_level::none, nullptr,
+                [](const signalr_client_config&) { return std::make_shared<stub_http_client>(); },
+                [](const signalr_client_config&) { return std::make_shared<stub_websocket_client>(); });
+            connection->set_client_config(config);
+
+            const int negotiates_before = server.negotiates;
+            const int connects_before = server.websocket_connects;
+            std::promise<void> started;
+            const auto begin = std::chrono::steady_clock::now();
+            connection->start([&started](std::exception_ptr exception)
+                {
+                    if (exception)
+                    {
+                        started.set_exception(exception);
+                    }
+                    else
+                    {
+                        started.set_value();
+                    }
+                });
+            started.get_future().get();
+            const auto elapsed = std::chrono::steady_clock::now() - begin;
+
+            if (i > 0)
+            {
+                total_us += std::chrono::duration<double, std::micro>(elapsed).count();
+                negotiates += server.negotiates - negotiates_before;
+                connects += server.websocket_connects - connects_before;
+            }
+
+            std::promise<void> stopped;
+            connection->stop([&stopped](std::exception_ptr) { stopped.set_value(); }, nullptr);
+            stopped.get_future().get();
+        }
+
+        std::printf("%-48s %10.1f us to connected %6.2f negotiates %6.2f websocket connects\n", name,
+            total_us / starts, static_cast<double>(negotiates) / starts, static_cast<double>(connects) / starts);
+    }
+
+    void measure_all(std::chrono::milliseconds request_time, int starts)
+    {
+        server.request_time = request_time;
+        std::printf("every request and connect takes %lld ms\n", static_cast<long long>(request_time.count()));
+
+        const std::string suffix = std::to_string(request_time.count());
+        measure_starts("  no cache", "http://gateway.local/chat" + suffix, std::chrono::milliseconds(0), false, starts);
+        measure_starts("  cache, negotiates with the cached url", "http://gateway.local/cached" + suffix,
+            std::chrono::minutes(5), false, starts);
+        measure_starts("  cache, connects directly", "http://gateway.local/direct" + suffix,
+            std::chrono::minutes(5), true, starts);
+    }
+}
+
+int main()
+{
+    measure_all(std::chrono::milliseconds(0), 200);
+    measure_all(std::chrono::milliseconds(50), 10);
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "reconnect_policy.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace signalr;
+using std::chrono::milliseconds;
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { ++failures; std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } } while (0)
+
+    reconnect_context context(int previous_attempts, milliseconds previous_delay)
+    {
+        reconnect_context result;
+        result.previous_attempts = previous_attempts;
+        result.previous_delay = previous_delay;
+        return result;
+    }
+
+    // every tenth of [low, high] gets its share of `delays`, give or take a third of it, and the ends are reached
+    void check_spread(const std::vector<int64_t>& delays, int64_t low, int64_t high)
+    {
+        const int buckets = 10;
+        std::vector<size_t> counts(buckets, 0);
+        int64_t smallest = high;
+        int64_t largest = low;
+        for (auto delay : delays)
+        {
+            smallest = std::min(smallest, delay);
+            largest = std::max(largest, delay);
+            int bucket = static_cast<int>((delay - low) * buckets / (high - low + 1));
+            ++counts[std::min(std::max(bucket, 0), buckets - 1)];
+        }
+
+        const size_t expected = delays.size() / buckets;
+        for (auto count : counts)
+        {
+            CHECK(count > expected * 2 / 3 && count < expected * 4 / 3);
+        }
+
+        const int64_t edge = (high - low) / 100;
+        CHECK(smallest <= low + edge);
+        CHECK(largest >= high - edge);
+    }
+
+    void exponential_without_jitter_doubles_up_to_max()
+    {
+        exponential_reconnect_policy policy(milliseconds(100), milliseconds(5000), false);
+
+        const int64_t expected[] = { 100, 200, 400, 800, 1600, 3200, 5000, 5000 };
+        for (int attempt = 0; attempt < 8; ++attempt)
+        {
+            CHECK(policy.next_delay(context(attempt, milliseconds(0))).count() == expected[attempt]);
+        }
+
+        // the shift stops before it overflows
+        CHECK(policy.next_delay(context(1000, milliseconds(0))).count() == 5000);
+    }
+
+    void exponential_jitter_stays_under_the_ceiling()
+    {
+        exponential_reconnect_policy policy(milliseconds(100), milliseconds(5000), true, 1234);
+
+        for (int attempt = 0; attempt < 20; ++attempt)
+        {
+            int64_t ceiling = std::min<int64_t>(5000, 100LL << attempt);
+            for (int i = 0; i < 100; ++i)
+            {
+                auto delay = policy.next_delay(context(attempt, milliseconds(0))).count();
+                CHECK(delay >= 0 && delay <= ceiling);
+            }
+        }
+    }
+
+    void exponential_jitter_is_spread_over_the_range()
+    {
+        exponential_reconnect_policy policy(milliseconds(100), milliseconds(5000), true, 42);
+
+        std::vector<int64_t> delays;
+        for (int i = 0; i < 20000; ++i)
+        {
+            delays.push_back(policy.next_delay(context(10, milliseconds(0))).count());
+        }
+        check_spread(delays, 0, 5000);
+    }
+
+    void decorrelated_jitter_stays_within_three_times_the_previous_delay()
+    {
+        decorrelated_jitter_reconnect_policy policy(milliseconds(100), milliseconds(10000), 99);
+
+        milliseconds previous(0);
+        for (int attempt = 0; attempt < 200; ++attempt)
+        {
+            auto delay = policy.next_delay(context(attempt, previous));
+            int64_t high = std::min<int64_t>(10000, std::max<int64_t>(previous.count(), 100) * 3);
+            CHECK(delay.count() >= 100 && delay.count() <= high);
+            previous = delay;
+        }
+    }
+
+    void decorrelated_jitter_is_spread_over_the_range()
+    {
+        decorrelated_jitter_reconnect_policy policy(milliseconds(100), milliseconds(10000), 7);
+
+        std::vector<int64_t> delays;
+        for (int i = 0; i < 20000; ++i)
+        {
+            delays.push_back(policy.next_delay(context(3, milliseconds(1000))).count());
+        }
+        check_spread(delays, 100, 3000);
+    }
+
+    template <typename Policy>
+    std::vector<int64_t> draw(Policy&& policy, int count)
+    {
+        std::vector<int64_t> delays;
+        milliseconds previous(0);
+        for (int attempt = 0; attempt < count; ++attempt)
+        {
+            previous = policy.next_delay(context(attempt, previous));
+            delays.push_back(previous.count());
+        }
+        return delays;
+    }
+
+    void seeded_policies_are_reproducible()
+    {
+        CHECK(draw(exponential_reconnect_policy(milliseconds(100), milliseconds(30000), true, 5), 30)
+            == draw(exponential_reconnect_policy(milliseconds(100), milliseconds(30000), true, 5), 30));
+        CHECK(draw(exponential_reconnect_policy(milliseconds(100), milliseconds(30000), true, 5), 30)
+            != draw(exponential_reconnect_policy(milliseconds(100), milliseconds(30000), true, 6), 30));
+
+        CHECK(draw(decorrelated_jitter_reconnect_policy(milliseconds(100), milliseconds(30000), 5), 30)
+            == draw(decorrelated_jitter_reconnect_policy(milliseconds(100), milliseconds(30000), 5), 30));
+        CHECK(draw(decorrelated_jitter_reconnect_policy(milliseconds(100), milliseconds(30000), 5), 30)
+            != draw(decorrelated_jitter_reconnect_policy(milliseconds(100), milliseconds(30000), 6), 30));
+    }
+
+    void unseeded_policies_stay_in_bounds()
+    {
+        for (auto delay : draw(exponential_reconnect_policy(milliseconds(100), milliseconds(30000)), 30))
+        {
+            CHECK(delay >= 0 && delay <= 30000);
+        }
+        for (auto delay : draw(decorrelated_jitter_reconnect_policy(milliseconds(100), milliseconds(30000)), 30))
+        {
+            CHECK(delay >= 100 && delay <= 30000);
+        }
+    }
+
+    void invalid_arguments_throw()
+    {
+        bool thrown = false;
+        try { exponential_reconnect_policy(milliseconds(0), milliseconds(1000)); } catch (const std::runtime_error&) { thrown = true; }
+        CHECK(thrown);
+
+        thrown = false;
+        try { decorrelated_jitter_reconnect_policy(milliseconds(1000), milliseconds(100)); } catch (const std::runtime_error&) { thrown = true; }
+        CHECK(thrown);
+    }
+}
+
+int main()
+{
+    exponential_without_jitter_doubles_up_to_max();
+    exponential_jitter_stays_under_the_ceiling();
+    exponential_jitter_is_spread_over_the_range();
+    decorrelated_jitter_stays_within_three_times_the_previous_delay();
+    decorrelated_jitter_is_spread_over_the_range();
+    seeded_policies_are_reproducible();
+    unseeded_policies_stay_in_bounds();
+    invalid_arguments_throw();
+
+    if (failures != 0)
+    {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
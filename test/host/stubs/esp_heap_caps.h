@@ -0,0 +1,41 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+// host stand-in: every capability is served by the C heap, and there is no PSRAM
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t)
+{
+    return std::malloc(size);
+}
+
+inline void* heap_caps_realloc(void* ptr, size_t size, uint32_t)
+{
+    return std::realloc(ptr, size);
+}
+
+inline void heap_caps_free(void* ptr)
+{
+    std::free(ptr);
+}
+
+inline size_t heap_caps_get_free_size(uint32_t)
+{
+    return 0;
+}
+
+inline size_t heap_caps_get_total_size(uint32_t)
+{
+    return 0;
+}
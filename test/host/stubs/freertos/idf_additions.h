@@ -0,0 +1,20 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+// host stand-in: the memory capabilities of a task stack mean nothing on the host
+
+#include "task.h"
+
+inline BaseType_t xTaskCreateWithCaps(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+    UBaseType_t priority, TaskHandle_t* handle, UBaseType_t)
+{
+    return xTaskCreate(function, name, stack_depth, param, priority, handle);
+}
+
+inline void vTaskDeleteWithCaps(TaskHandle_t task)
+{
+    vTaskDelete(task);
+}
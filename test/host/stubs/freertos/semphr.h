@@ -0,0 +1,64 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+// host stand-in: mutexes and binary semaphores are a flag guarded by a std::mutex, taken with the FreeRTOS timeout
+
+#include "FreeRTOS.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+struct host_semaphore
+{
+    explicit host_semaphore(bool available) : available(available) { }
+
+    std::mutex lock;
+    std::condition_variable given;
+    bool available;
+};
+
+typedef host_semaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new host_semaphore(true);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new host_semaphore(false);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(semaphore->lock);
+    if (ticks == portMAX_DELAY)
+    {
+        semaphore->given.wait(lock, [semaphore]() { return semaphore->available; });
+    }
+    else if (!semaphore->given.wait_for(lock, std::chrono::milliseconds(ticks), [semaphore]() { return semaphore->available; }))
+    {
+        return pdFALSE;
+    }
+
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    {
+        std::lock_guard<std::mutex> lock(semaphore->lock);
+        semaphore->available = true;
+    }
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
@@ -0,0 +1,37 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#pragma once
+
+// host stand-in: a task is a detached thread. Task functions return right after vTaskDelete(NULL), which does
+// nothing here
+
+#include "FreeRTOS.h"
+#include <chrono>
+#include <thread>
+
+typedef void (*TaskFunction_t)(void*);
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char*, uint32_t, void* param, UBaseType_t, TaskHandle_t* handle)
+{
+    std::thread(function, param).detach();
+    if (handle != nullptr)
+    {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t)
+{ }
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t)
+{
+    return 0;
+}
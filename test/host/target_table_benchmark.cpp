@@ -0,0 +1,94 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+// See the LICENSE file in the project root for more information.
+
+#include "benchmark.h"
+#include "target_table.h"
+#include "case_insensitive_comparison_utils.h"
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace signalr;
+
+namespace
+{
+    const char* const prefixes[] = { "On", "Receive", "device", "Update", "sensorReading", "NotifyGroupMemberStatusChanged" };
+
+    // hub method names of the lengths seen in practice, from 9 to 33 characters
+    std::vector<std::string> make_names(size_t count)
+    {
+        std::vector<std::string> names;
+        for (size_t i = 0; i < count; ++i)
+        {
+            names.push_back(std::string(prefixes[i % 6]).append("Event").append(std::to_string(i)));
+        }
+        return names;
+    }
+
+    // the targets of received invocations as they sit in the receive buffer, in a scattered order
+    std::vector<std::string> make_received(const std::vector<std::string>& names, size_t count)
+    {
+        std::vector<std::string> received;
+        uint32_t state = 12345;
+        for (size_t i = 0; i < count; ++i)
+        {
+            state = state * 1103515245 + 12345;
+            received.push_back(names[(state >> 8) % names.size()]);
+        }
+        return received;
+    }
+}
+
+int main()
+{
+    const size_t lookups = 1000;
+    const size_t repeats = 1000;
+
+    for (size_t target_count : { 10, 100 })
+    {
+        auto names = make_names(target_count);
+        auto received = make_received(names, lookups);
+
+        // before: the target is copied out of the message and looked up by name
+        std::unordered_map<std::string, std::function<void()>, case_insensitive_hash, case_insensitive_equals> subscriptions;
+        for (const auto& name : names)
+        {
+            subscriptions.insert({ name, []() {} });
+        }
+
+        size_t found = 0;
+        auto by_name = benchmark::measure(lookups * repeats, [&]()
+            {
+                for (size_t repeat = 0; repeat < repeats; ++repeat)
+                {
+                    for (const auto& target : received)
+                    {
+                        std::string copied(target.data(), target.size());
+                        found += subscriptions.find(copied) != subscriptions.end();
+                    }
+                }
+            });
+
+        // after: the raw target bytes resolve to an index into the handlers
+        target_table table(names);
+        auto by_table = benchmark::measure(lookups * repeats, [&]()
+            {
+                for (size_t repeat = 0; repeat < repeats; ++repeat)
+                {
+                    for (const auto& target : received)
+                    {
+                        found += table.find(target.data(), target.size()) != target_table::not_found;
+                    }
+                }
+            });
+        benchmark::keep(found);
+
+        std::printf("%u targets:\n", (unsigned)target_count);
+        benchmark::report("  copy + unordered_map<case_insensitive_hash>", by_name);
+        benchmark::report("  target_table::find", by_table);
+    }
+    return 0;
+}